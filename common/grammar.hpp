@@ -0,0 +1,131 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "jff.hpp"
+
+// Context-free grammar with integer symbols.
+// Терминал - код байта (0..255), переменная - 256 + номер. Так правые части
+// хранятся как массивы int, а преобразования (НФХ, LL/LR-таблицы) могут
+// добавлять новые переменные с произвольными именами.
+struct Production {
+    int left = 0;
+    std::vector<int> right;     // empty - ε
+};
+
+class Grammar {
+public:
+    static constexpr int FIRST_VARIABLE = 256;
+
+    static bool IsTerminal(int symbol) { return symbol < FIRST_VARIABLE; }
+    static int Variable(int index) { return FIRST_VARIABLE + index; }
+    static int VariableIndex(int symbol) { return symbol - FIRST_VARIABLE; }
+
+    // Symbol of the variable `name`, added if it is new
+    int AddVariable(const std::string& name)
+    {
+        for (size_t i = 0; i < m_Names.size(); ++i)
+            if (m_Names[i] == name)
+                return Variable(static_cast<int>(i));
+        m_Names.push_back(name);
+        return Variable(static_cast<int>(m_Names.size()) - 1);
+    }
+
+    // A new variable whose name is not used yet: base, base1, base2, ...
+    int AddFreshVariable(const std::string& base)
+    {
+        std::string name = base;
+        for (int n = 1; Find(name) >= 0; ++n)
+            name = base + std::to_string(n);
+        return AddVariable(name);
+    }
+
+    int Find(const std::string& name) const
+    {
+        for (size_t i = 0; i < m_Names.size(); ++i)
+            if (m_Names[i] == name)
+                return Variable(static_cast<int>(i));
+        return -1;
+    }
+
+    void AddProduction(int left, std::vector<int> right)
+    {
+        Production p;
+        p.left = left;
+        p.right = std::move(right);
+        m_Productions.push_back(std::move(p));
+    }
+
+    int Variables() const { return static_cast<int>(m_Names.size()); }
+    const std::string& VariableName(int symbol) const { return m_Names[VariableIndex(symbol)]; }
+
+    int Start() const { return m_Start; }
+    void SetStart(int symbol) { m_Start = symbol; }
+
+    const std::vector<Production>& Productions() const { return m_Productions; }
+    std::vector<Production>& Productions() { return m_Productions; }
+
+    std::string SymbolName(int symbol) const
+    {
+        return IsTerminal(symbol) ? std::string(1, static_cast<char>(symbol)) : VariableName(symbol);
+    }
+
+    // "A -> aB" ("A -> ε" for an empty right side)
+    std::string ToString(const Production& p) const
+    {
+        std::string text = SymbolName(p.left) + " -> ";
+        if (p.right.empty())
+            text += "ε";
+        for (int symbol : p.right)
+            text += SymbolName(symbol);
+        return text;
+    }
+
+    // <type>grammar</type> in JFLAP conventions: uppercase letters are
+    // variables, the left side of the first production is the start symbol
+    bool FromJff(const JffDocument& doc, std::string* error = nullptr)
+    {
+        m_Names.clear();
+        m_Productions.clear();
+        if (doc.Type() != "grammar")
+            return Fail(error, "not a grammar: <type>" + std::string(doc.Type()) + "</type>");
+        if (doc.Productions().empty())
+            return Fail(error, "no productions");
+
+        for (const auto& p : doc.Productions()) {
+            std::string_view left = doc.Text(p.left);
+            if (left.size() != 1 || !IsJffVariable(left[0]))
+                return Fail(error, "left side \"" + std::string(left) + "\" is not a variable");
+            int head = AddVariable(std::string(left));
+
+            std::vector<int> right;
+            for (char ch : doc.Text(p.right))
+                right.push_back(IsJffVariable(ch) ? AddVariable(std::string(1, ch)) : static_cast<unsigned char>(ch));
+            AddProduction(head, std::move(right));
+        }
+        m_Start = m_Productions[0].left;
+        return true;
+    }
+
+    bool Load(const char* path, std::string* error = nullptr)
+    {
+        JffDocument doc;
+        return doc.Load(path, error) && FromJff(doc, error);
+    }
+
+private:
+    static bool IsJffVariable(char ch) { return ch >= 'A' && ch <= 'Z'; }
+
+    static bool Fail(std::string* error, const std::string& message)
+    {
+        if (error)
+            *error = message;
+        return false;
+    }
+
+    std::vector<std::string> m_Names;
+    std::vector<Production> m_Productions;
+    int m_Start = FIRST_VARIABLE;
+};
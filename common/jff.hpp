@@ -0,0 +1,452 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Loader for JFLAP .jff files (fa, pda, turing, grammar, re).
+// Однопроходный разбор XML без внешних зависимостей: интересующие теги
+// (state, transition, production, ...) сразу складываются в компактные
+// массивы, все строки - в один общий буфер (m_Pool), элементы ссылаются
+// на него смещениями. Координаты, заметки и прочие теги пропускаются.
+
+// Reference to a decoded string in the document pool
+struct JffString {
+    uint32_t offset = 0;
+    uint32_t length = 0;
+};
+
+enum JFF_LABEL_KIND {
+    JFF_READ  = 0,
+    JFF_WRITE = 1,
+    JFF_MOVE  = 2,
+    JFF_POP   = 3,
+    JFF_PUSH  = 4
+};
+
+// One <read>/<write>/<move>/<pop>/<push> of a transition
+struct JffLabel {
+    uint8_t kind = JFF_READ;
+    uint8_t tape = 1;   // tape="N" of multi-tape Turing machines, 1 otherwise
+    JffString text;
+};
+
+struct JffState {
+    int id = 0;          // id from the file
+    JffString name;
+    bool initial = false;
+    bool final = false;
+};
+
+struct JffTransition {
+    int from = -1;       // state indices (not file ids) after loading
+    int to = -1;
+    uint32_t first_label = 0;
+    uint32_t labels = 0;
+};
+
+struct JffProduction {
+    JffString left;
+    JffString right;
+};
+
+class JffDocument {
+public:
+    bool Load(const char* path, std::string* error = nullptr)
+    {
+        FILE* in = std::fopen(path, "rb");
+        if (!in)
+            return Fail(error, std::string("cannot open ") + path);
+
+        // One read of the whole file (size from fseek when the stream allows it)
+        std::vector<char> data;
+        if (std::fseek(in, 0, SEEK_END) == 0) {
+            long size = std::ftell(in);
+            std::fseek(in, 0, SEEK_SET);
+            if (size > 0)
+                data.resize(static_cast<size_t>(size));
+            data.resize(std::fread(data.data(), 1, data.size(), in));
+        } else {
+            char block[1 << 16];
+            size_t got;
+            while ((got = std::fread(block, 1, sizeof(block), in)) > 0)
+                data.insert(data.end(), block, block + got);
+        }
+        std::fclose(in);
+
+        return Parse(data.data(), data.size(), error);
+    }
+
+    bool Parse(const char* data, size_t size, std::string* error = nullptr)
+    {
+        Clear();
+        m_Pool.reserve(size / 8);
+
+        const char* p = data;
+        const char* end = data + size;
+        const char* text_begin = nullptr;   // content of the innermost open tag
+
+        while (p < end) {
+            const char* lt = static_cast<const char*>(std::memchr(p, '<', end - p));
+            if (!lt)
+                break;
+
+            // Comments, <?xml ...?>, <!DOCTYPE ...>
+            if (lt + 1 < end && (lt[1] == '!' || lt[1] == '?')) {
+                const char* close = (end - lt >= 4 && std::memcmp(lt, "<!--", 4) == 0)
+                                        ? Find(lt + 4, end, "-->") : Find(lt + 1, end, ">");
+                if (!close)
+                    return Fail(error, "unterminated comment or declaration");
+                p = close + (lt[1] == '!' && lt[2] == '-' ? 3 : 1);
+                continue;
+            }
+
+            const char* gt = static_cast<const char*>(std::memchr(lt, '>', end - lt));
+            if (!gt)
+                return Fail(error, "unterminated tag");
+
+            bool closing = lt[1] == '/';
+            bool self_closing = gt[-1] == '/';
+            const char* name = lt + (closing ? 2 : 1);
+            const char* name_end = name;
+            while (name_end < gt && !IsSpace(*name_end) && *name_end != '/' && *name_end != '>')
+                ++name_end;
+            std::string_view tag(name, name_end - name);
+
+            if (closing) {
+                if (text_begin && !OnText(tag, text_begin, lt, error))
+                    return false;
+                text_begin = nullptr;
+                OnClose(tag);
+            } else {
+                std::string_view attributes(name_end, (self_closing ? gt - 1 : gt) - name_end);
+                if (!OnOpen(tag, attributes, error))
+                    return false;
+                if (self_closing) {
+                    if (!OnText(tag, gt, gt, error))
+                        return false;
+                    OnClose(tag);
+                    text_begin = nullptr;
+                } else {
+                    text_begin = gt + 1;
+                }
+            }
+            p = gt + 1;
+        }
+
+        return Resolve(error);
+    }
+
+    std::string_view Type() const { return Text(m_Type); }
+    int Tapes() const { return m_Tapes; }
+    std::string_view Expression() const { return Text(m_Expression); }
+
+    const std::vector<JffState>& States() const { return m_States; }
+    const std::vector<JffTransition>& Transitions() const { return m_Transitions; }
+    const std::vector<JffProduction>& Productions() const { return m_Productions; }
+
+    std::string_view Text(JffString s) const
+    {
+        return std::string_view(m_Pool.data() + s.offset, s.length);
+    }
+
+    // Index of the initial state, -1 if there is none
+    int InitialState() const { return m_Initial; }
+
+    // Text of the label `kind` on `tape`; empty if the label is empty or absent
+    std::string_view Label(const JffTransition& t, int kind, int tape = 1) const
+    {
+        for (uint32_t i = t.first_label; i < t.first_label + t.labels; ++i)
+            if (m_Labels[i].kind == kind && m_Labels[i].tape == tape)
+                return Text(m_Labels[i].text);
+        return std::string_view();
+    }
+
+private:
+    enum CONTEXT { IN_NONE, IN_STATE, IN_TRANSITION, IN_PRODUCTION };
+
+    void Clear()
+    {
+        m_Pool.clear();
+        m_States.clear();
+        m_Transitions.clear();
+        m_Labels.clear();
+        m_Productions.clear();
+        m_Type = m_Expression = JffString();
+        m_Tapes = 1;
+        m_Initial = -1;
+        m_Context = IN_NONE;
+    }
+
+    bool OnOpen(std::string_view tag, std::string_view attributes, std::string* error)
+    {
+        if (tag == "state") {
+            JffState state;
+            std::string_view id = Attribute(attributes, "id");
+            if (!ParseInt(id, state.id))
+                return Fail(error, "state without a numeric id");
+            state.name = Store(Attribute(attributes, "name"));
+            m_States.push_back(state);
+            m_Context = IN_STATE;
+        } else if (tag == "transition") {
+            JffTransition transition;
+            transition.first_label = static_cast<uint32_t>(m_Labels.size());
+            m_Transitions.push_back(transition);
+            m_Context = IN_TRANSITION;
+        } else if (tag == "production") {
+            m_Productions.push_back(JffProduction());
+            m_Context = IN_PRODUCTION;
+        } else if (m_Context == IN_STATE && tag == "initial") {
+            m_States.back().initial = true;
+        } else if (m_Context == IN_STATE && tag == "final") {
+            m_States.back().final = true;
+        } else if (m_Context == IN_TRANSITION) {
+            int kind = LabelKind(tag);
+            if (kind >= 0) {
+                JffLabel label;
+                label.kind = static_cast<uint8_t>(kind);
+                int tape = 1;
+                std::string_view tape_text = Attribute(attributes, "tape");
+                if (!tape_text.empty() && (!ParseInt(tape_text, tape) || tape < 1 || tape > 255))
+                    return Fail(error, "bad tape number");
+                label.tape = static_cast<uint8_t>(tape);
+                m_Labels.push_back(label);
+                ++m_Transitions.back().labels;
+            }
+        }
+        return true;
+    }
+
+    bool OnText(std::string_view tag, const char* first, const char* last, std::string* error)
+    {
+        if (m_Context == IN_TRANSITION) {
+            if (tag == "from" || tag == "to") {
+                int id;
+                if (!ParseInt(std::string_view(first, last - first), id))
+                    return Fail(error, "bad <from>/<to> in a transition");
+                (tag == "from" ? m_Transitions.back().from : m_Transitions.back().to) = id;
+            } else if (LabelKind(tag) >= 0 && m_Transitions.back().labels > 0) {
+                m_Labels.back().text = Decode(first, last);
+            }
+        } else if (m_Context == IN_PRODUCTION) {
+            if (tag == "left")
+                m_Productions.back().left = Decode(first, last);
+            else if (tag == "right")
+                m_Productions.back().right = Decode(first, last);
+        } else if (tag == "type") {
+            m_Type = Decode(first, last);
+        } else if (tag == "expression") {
+            m_Expression = Decode(first, last);
+        } else if (tag == "tapes") {
+            if (!ParseInt(std::string_view(first, last - first), m_Tapes) || m_Tapes < 1)
+                return Fail(error, "bad <tapes>");
+        }
+        return true;
+    }
+
+    void OnClose(std::string_view tag)
+    {
+        if (tag == "state" || tag == "transition" || tag == "production")
+            m_Context = IN_NONE;
+    }
+
+    // File ids of states -> indices in m_States.
+    // Id в файле произвольный: таблица по id только пока id сравнимы с числом
+    // состояний, иначе хеш-таблица, чтобы id="99999999" не выделял сотни МБ.
+    bool Resolve(std::string* error)
+    {
+        int max_id = -1;
+        for (const auto& state : m_States) {
+            if (state.id < 0)
+                return Fail(error, "duplicate or negative state id");
+            max_id = std::max(max_id, state.id);
+        }
+
+        const bool dense = static_cast<size_t>(max_id) < 4 * m_States.size() + 64;
+        std::vector<int> table(dense ? max_id + 1 : 0, -1);
+        std::unordered_map<int, int> map;
+        for (size_t i = 0; i < m_States.size(); ++i) {
+            bool inserted;
+            if (dense) {
+                inserted = table[m_States[i].id] < 0;
+                table[m_States[i].id] = static_cast<int>(i);
+            } else {
+                inserted = map.emplace(m_States[i].id, static_cast<int>(i)).second;
+            }
+            if (!inserted)
+                return Fail(error, "duplicate or negative state id");
+            if (m_States[i].initial)
+                m_Initial = static_cast<int>(i);
+        }
+        auto index = [&](int id) {
+            if (id < 0 || id > max_id)
+                return -1;
+            if (dense)
+                return table[id];
+            auto found = map.find(id);
+            return found == map.end() ? -1 : found->second;
+        };
+
+        for (auto& t : m_Transitions) {
+            int from = index(t.from), to = index(t.to);
+            if (from < 0 || to < 0)
+                return Fail(error, "transition refers to an unknown state");
+            t.from = from;
+            t.to = to;
+        }
+        return true;
+    }
+
+    static int LabelKind(std::string_view tag)
+    {
+        if (tag == "read") return JFF_READ;
+        if (tag == "write") return JFF_WRITE;
+        if (tag == "move") return JFF_MOVE;
+        if (tag == "pop") return JFF_POP;
+        if (tag == "push") return JFF_PUSH;
+        return -1;
+    }
+
+    // Value of attribute `name` (without quotes), empty if absent
+    static std::string_view Attribute(std::string_view attributes, std::string_view name)
+    {
+        size_t pos = 0;
+        while ((pos = attributes.find(name, pos)) != std::string_view::npos) {
+            size_t after = pos + name.size();
+            bool starts = pos == 0 || IsSpace(attributes[pos - 1]);
+            if (starts && after + 1 < attributes.size() && attributes[after] == '=') {
+                char quote = attributes[after + 1];
+                size_t close = attributes.find(quote, after + 2);
+                if (close != std::string_view::npos)
+                    return attributes.substr(after + 2, close - after - 2);
+            }
+            pos = after;
+        }
+        return std::string_view();
+    }
+
+    // Decodes XML entities into the pool
+    JffString Decode(const char* first, const char* last)
+    {
+        JffString s;
+        s.offset = static_cast<uint32_t>(m_Pool.size());
+        while (first < last) {
+            const char* amp = static_cast<const char*>(std::memchr(first, '&', last - first));
+            if (!amp) {
+                m_Pool.append(first, last);
+                break;
+            }
+            m_Pool.append(first, amp);
+            const char* semi = static_cast<const char*>(std::memchr(amp, ';', last - amp));
+            if (!semi) {
+                m_Pool.append(amp, last);
+                break;
+            }
+            std::string_view entity(amp + 1, semi - amp - 1);
+            if (entity == "amp") m_Pool += '&';
+            else if (entity == "lt") m_Pool += '<';
+            else if (entity == "gt") m_Pool += '>';
+            else if (entity == "quot") m_Pool += '"';
+            else if (entity == "apos") m_Pool += '\'';
+            else if (!entity.empty() && entity[0] == '#') {
+                unsigned long code = (entity.size() > 1 && entity[1] == 'x')
+                                         ? std::strtoul(std::string(entity.substr(2)).c_str(), nullptr, 16)
+                                         : std::strtoul(std::string(entity.substr(1)).c_str(), nullptr, 10);
+                AppendUtf8(code);
+            } else {
+                m_Pool.append(amp, semi + 1);
+            }
+            first = semi + 1;
+        }
+        s.length = static_cast<uint32_t>(m_Pool.size() - s.offset);
+        return s;
+    }
+
+    JffString Store(std::string_view text)
+    {
+        return Decode(text.data(), text.data() + text.size());
+    }
+
+    void AppendUtf8(unsigned long code)
+    {
+        if (code < 0x80) {
+            m_Pool += static_cast<char>(code);
+        } else if (code < 0x800) {
+            m_Pool += static_cast<char>(0xC0 | (code >> 6));
+            m_Pool += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            m_Pool += static_cast<char>(0xE0 | (code >> 12));
+            m_Pool += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            m_Pool += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            m_Pool += static_cast<char>(0xF0 | (code >> 18));
+            m_Pool += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            m_Pool += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            m_Pool += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    static bool ParseInt(std::string_view text, int& value)
+    {
+        while (!text.empty() && IsSpace(text.front()))
+            text.remove_prefix(1);
+        while (!text.empty() && IsSpace(text.back()))
+            text.remove_suffix(1);
+        if (text.empty())
+            return false;
+        bool negative = text[0] == '-';
+        if (negative)
+            text.remove_prefix(1);
+        if (text.empty())
+            return false;
+        long result = 0;
+        for (char ch : text) {
+            if (ch < '0' || ch > '9' || result > 100000000)
+                return false;
+            result = result * 10 + (ch - '0');
+        }
+        value = static_cast<int>(negative ? -result : result);
+        return true;
+    }
+
+    static bool IsSpace(char ch)
+    {
+        return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+    }
+
+    static const char* Find(const char* first, const char* last, const char* needle)
+    {
+        size_t length = std::strlen(needle);
+        for (; first + length <= last; ++first) {
+            first = static_cast<const char*>(std::memchr(first, needle[0], last - first));
+            if (!first || first + length > last)
+                return nullptr;
+            if (std::memcmp(first, needle, length) == 0)
+                return first;
+        }
+        return nullptr;
+    }
+
+    static bool Fail(std::string* error, const std::string& message)
+    {
+        if (error)
+            *error = message;
+        return false;
+    }
+
+    std::string m_Pool;
+    std::vector<JffState> m_States;
+    std::vector<JffTransition> m_Transitions;
+    std::vector<JffLabel> m_Labels;
+    std::vector<JffProduction> m_Productions;
+    JffString m_Type;
+    JffString m_Expression;
+    int m_Tapes = 1;
+    int m_Initial = -1;
+    int m_Context = IN_NONE;
+};
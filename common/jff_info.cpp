@@ -0,0 +1,100 @@
+// Loads JFLAP files and prints what was read and how long it took.
+//
+//   jff_info <file.jff>...                 - summary of every file
+//   jff_info --generate <states> <out.jff> - writes a random 3-tape Turing
+//                                            machine for load-time measurements
+
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+#include "jff.hpp"
+
+int Generate(int states, const char *path)
+{
+    FILE *out = std::fopen(path, "wb");
+    if (!out)
+    {
+        std::perror(path);
+        return 1;
+    }
+
+    std::mt19937 rng(42);
+    const char symbols[] = "01XY";
+    const char moves[] = "LRS";
+
+    std::fprintf(out, "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?><!--Generated.--><structure>&#13;\n");
+    std::fprintf(out, "\t<type>turing</type>&#13;\n\t<tapes>3</tapes>&#13;\n\t<automaton>&#13;\n");
+    for (int q = 0; q < states; ++q)
+    {
+        std::fprintf(out, "\t\t<state id=\"%d\" name=\"q%d\">&#13;\n\t\t\t<x>%d.0</x>&#13;\n\t\t\t<y>%d.0</y>&#13;\n", q, q, q * 10, q * 7);
+        if (q == 0)
+            std::fprintf(out, "\t\t\t<initial/>&#13;\n");
+        if (q == states - 1)
+            std::fprintf(out, "\t\t\t<final/>&#13;\n");
+        std::fprintf(out, "\t\t</state>&#13;\n");
+    }
+    for (int q = 0; q < states; ++q)
+    {
+        for (int k = 0; k < 4; ++k)
+        {
+            std::fprintf(out, "\t\t<transition>&#13;\n\t\t\t<from>%d</from>&#13;\n\t\t\t<to>%d</to>&#13;\n",
+                         q, (int)(rng() % states));
+            for (int tape = 1; tape <= 3; ++tape)
+            {
+                std::fprintf(out, "\t\t\t<read tape=\"%d\">%c</read>&#13;\n", tape, symbols[rng() % 4]);
+                std::fprintf(out, "\t\t\t<write tape=\"%d\">%c</write>&#13;\n", tape, symbols[rng() % 4]);
+                std::fprintf(out, "\t\t\t<move tape=\"%d\">%c</move>&#13;\n", tape, moves[rng() % 3]);
+            }
+            std::fprintf(out, "\t\t</transition>&#13;\n");
+        }
+    }
+    std::fprintf(out, "\t</automaton>&#13;\n</structure>\n");
+    std::fclose(out);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 3 && std::strcmp(argv[1], "--generate") == 0)
+        return Generate(std::atoi(argv[2]), argv[3]);
+
+    if (argc < 2)
+    {
+        std::cout << "Usage: jff_info <file.jff>... | jff_info --generate <states> <out.jff>\n";
+        return 1;
+    }
+
+    int status = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        JffDocument doc;
+        std::string error;
+        bool ok = doc.Load(argv[i], &error);
+        double ms = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() * 1e3;
+
+        if (!ok)
+        {
+            std::fprintf(stderr, "%s: %s\n", argv[i], error.c_str());
+            status = 1;
+            continue;
+        }
+
+        std::string type(doc.Type());
+        std::printf("%s: type %s", argv[i], type.c_str());
+        if (type == "re")
+            std::printf(", expression \"%s\"", std::string(doc.Expression()).c_str());
+        else if (type == "grammar")
+            std::printf(", %zu productions", doc.Productions().size());
+        else
+            std::printf(", %zu states, %zu transitions, %d tape(s)",
+                        doc.States().size(), doc.Transitions().size(), doc.Tapes());
+        std::printf(", loaded in %.3f ms\n", ms);
+    }
+    return status;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Open-addressing hash table uint64 -> int32.
+// Clear() - O(1) (счетчик поколений вместо обнуления), память остается, поэтому
+// одна таблица служит множеству коротких слоев поиска (позиций входа). Без
+// Clear() - обычное отображение.
+class LayerTable {
+public:
+    LayerTable() { Rehash(1024); }
+
+    void Clear()
+    {
+        m_Size = 0;
+        if (++m_Generation == 0) {
+            for (auto& slot : m_Slots)
+                slot.generation = 0;
+            m_Generation = 1;
+        }
+    }
+
+    // Value stored for `key`; if there is none, `value` is stored and
+    // returned, `inserted` tells which
+    int32_t FindOrInsert(uint64_t key, int32_t value, bool& inserted)
+    {
+        return Locate(key, value, inserted).value;
+    }
+
+    // Value of `key` for update; `initial` is stored first if there is none
+    int32_t& At(uint64_t key, int32_t initial = -1)
+    {
+        bool inserted;
+        return Locate(key, initial, inserted).value;
+    }
+
+    // Value stored for `key` or `missing`
+    int32_t Find(uint64_t key, int32_t missing = -1) const
+    {
+        size_t mask = m_Slots.size() - 1;
+        for (size_t i = Hash(key) & mask;; i = (i + 1) & mask) {
+            const Slot& slot = m_Slots[i];
+            if (slot.generation != m_Generation)
+                return missing;
+            if (slot.key == key)
+                return slot.value;
+        }
+    }
+
+    size_t Size() const { return m_Size; }
+    size_t Bytes() const { return m_Slots.capacity() * sizeof(Slot); }
+
+private:
+    struct Slot {
+        uint64_t key;
+        int32_t value;
+        uint32_t generation;
+    };
+
+    Slot& Locate(uint64_t key, int32_t value, bool& inserted)
+    {
+        if (2 * (m_Size + 1) > m_Slots.size())
+            Rehash(2 * m_Slots.size());
+        size_t mask = m_Slots.size() - 1;
+        for (size_t i = Hash(key) & mask;; i = (i + 1) & mask) {
+            Slot& slot = m_Slots[i];
+            if (slot.generation != m_Generation) {
+                slot = Slot{ key, value, m_Generation };
+                ++m_Size;
+                inserted = true;
+                return slot;
+            }
+            if (slot.key == key) {
+                inserted = false;
+                return slot;
+            }
+        }
+    }
+
+    static size_t Hash(uint64_t key)
+    {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return static_cast<size_t>(key);
+    }
+
+    void Rehash(size_t capacity)
+    {
+        std::vector<Slot> old;
+        old.swap(m_Slots);
+        m_Slots.assign(capacity, Slot{ 0, 0, 0 });
+        uint32_t generation = m_Generation;
+        m_Generation = 1;
+        m_Size = 0;
+        for (const Slot& slot : old)
+            if (slot.generation == generation) {
+                bool inserted;
+                FindOrInsert(slot.key, slot.value, inserted);
+            }
+    }
+
+    std::vector<Slot> m_Slots;
+    size_t m_Size = 0;
+    uint32_t m_Generation = 1;
+};
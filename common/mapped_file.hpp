@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only view of a whole file.
+// Обычный файл отображается в память (mmap) без копирования и без предела
+// размера; поток ("-" - stdin, канал) читается в буфер целиком.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const char* path, std::string* error = nullptr)
+    {
+        Close();
+        bool is_stdin = path[0] == '-' && path[1] == '\0';
+        int fd = is_stdin ? STDIN_FILENO : ::open(path, O_RDONLY);
+        if (fd < 0)
+            return Fail(error, std::string("cannot open ") + path);
+
+        struct stat info;
+        if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            void* map = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map != MAP_FAILED) {
+                ::madvise(map, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+                m_Map = map;
+                m_Size = static_cast<size_t>(info.st_size);
+            }
+        }
+        if (!m_Map) {
+            char block[1 << 16];
+            ssize_t got;
+            while ((got = ::read(fd, block, sizeof(block))) > 0)
+                m_Buffer.insert(m_Buffer.end(), block, block + got);
+            m_Size = m_Buffer.size();
+        }
+        if (!is_stdin)
+            ::close(fd);
+        return true;
+    }
+
+    void Close()
+    {
+        if (m_Map)
+            ::munmap(m_Map, m_Size);
+        m_Map = nullptr;
+        m_Size = 0;
+        m_Buffer.clear();
+    }
+
+    const char* Data() const { return m_Map ? static_cast<const char*>(m_Map) : m_Buffer.data(); }
+    size_t Size() const { return m_Size; }
+    bool IsMapped() const { return m_Map != nullptr; }
+
+private:
+    static bool Fail(std::string* error, const std::string& message)
+    {
+        if (error)
+            *error = message;
+        return false;
+    }
+
+    void* m_Map = nullptr;
+    size_t m_Size = 0;
+    std::vector<char> m_Buffer;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+#include "mapped_file.hpp"
+
+// Lines of a file ("-" - stdin) one at a time, of any length.
+// Файл открывается через MappedFile, и строка - окно в его данные; stdin
+// читается блоками, и строка, не поместившаяся в блок, собирается в буфере,
+// который растет до ее длины (памяти - самая длинная строка плюс блок).
+// Конец строки - '\n', '\r' перед ним отбрасывается; последняя строка без
+// '\n' - тоже запись. Окно записи действительно до следующего Next().
+class RecordReader {
+public:
+    static constexpr size_t BLOCK = 1 << 16;
+
+    bool Open(const char* path, std::string* error = nullptr)
+    {
+        m_Stream = path[0] == '-' && path[1] == '\0';
+        m_Begin = m_End = 0;
+        m_Eof = false;
+        m_Records = 0;
+        if (m_Stream)
+            return true;
+        if (!m_File.Open(path, error))
+            return false;
+        m_End = m_File.Size();
+        return true;
+    }
+
+    bool Next(std::string_view& record)
+    {
+        const char* data = m_Stream ? m_Buffer.data() : m_File.Data();
+        const char* eol = m_Begin < m_End ? static_cast<const char*>(std::memchr(data + m_Begin, '\n', m_End - m_Begin))
+                                          : nullptr;
+        while (!eol && m_Stream && !m_Eof) {
+            size_t searched = m_End - m_Begin;
+            Fill();
+            data = m_Buffer.data();
+            eol = static_cast<const char*>(std::memchr(data + m_Begin + searched, '\n', m_End - m_Begin - searched));
+        }
+        if (!eol && m_Begin == m_End)
+            return false;
+
+        size_t last = eol ? static_cast<size_t>(eol - data) : m_End;
+        size_t length = last - m_Begin;
+        if (length > 0 && data[last - 1] == '\r')
+            --length;
+        record = std::string_view(data + m_Begin, length);
+        m_Begin = eol ? last + 1 : m_End;
+        ++m_Records;
+        return true;
+    }
+
+    size_t Records() const { return m_Records; }
+
+private:
+    // The unread part to the front of the buffer, then one more block
+    void Fill()
+    {
+        size_t rest = m_End - m_Begin;
+        std::memmove(m_Buffer.data(), m_Buffer.data() + m_Begin, rest);
+        m_Begin = 0;
+        m_End = rest;
+        if (m_Buffer.size() < rest + BLOCK)
+            m_Buffer.resize(std::max(2 * m_Buffer.size(), rest + BLOCK));
+        ssize_t got = ::read(STDIN_FILENO, m_Buffer.data() + m_End, m_Buffer.size() - m_End);
+        if (got <= 0)
+            m_Eof = true;
+        else
+            m_End += static_cast<size_t>(got);
+    }
+
+    MappedFile m_File;
+    bool m_Stream = false;
+    std::vector<char> m_Buffer;     // stdin: [m_Begin, m_End) not read yet
+    size_t m_Begin = 0;
+    size_t m_End = 0;
+    bool m_Eof = false;
+    size_t m_Records = 0;
+};
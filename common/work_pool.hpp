@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Pool of threads for data-parallel loops with work stealing.
+// ParallelFor делит диапазон на куски и раскладывает их по очередям потоков
+// (вызывающий поток - участник номер 0). Свою очередь поток берет с конца,
+// опустевший поток крадет куски с начала чужих очередей, так что неравные по
+// стоимости куски (длинные отрезки CYK, тяжелые входы) выравниваются сами.
+class WorkPool {
+public:
+    explicit WorkPool(int threads = static_cast<int>(std::thread::hardware_concurrency()))
+        : m_Queues(std::max(threads, 1))
+    {
+        for (auto& queue : m_Queues)
+            queue = std::make_unique<Queue>();
+        for (int t = 1; t < Threads(); ++t)
+            m_Workers.emplace_back([this, t] { Work(t); });
+    }
+
+    ~WorkPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stop = true;
+        }
+        m_Wake.notify_all();
+        for (auto& worker : m_Workers)
+            worker.join();
+    }
+
+    WorkPool(const WorkPool&) = delete;
+    WorkPool& operator=(const WorkPool&) = delete;
+
+    int Threads() const { return static_cast<int>(m_Queues.size()); }
+
+    // Calls fn(from, to) on pieces of [first, last) of at most `grain` items
+    // (0 - about four pieces per thread) and returns when all are done
+    template <class Fn>
+    void ParallelFor(int first, int last, int grain, Fn fn)
+    {
+        ParallelForWorker(first, last, grain, [&fn](int, int from, int to) { fn(from, to); });
+    }
+
+    // The same with fn(worker, from, to): `worker` is the participant that
+    // runs the piece (0 .. Threads() - 1), so per-thread state indexed by it
+    // is never used by two pieces at once
+    template <class Fn>
+    void ParallelForWorker(int first, int last, int grain, Fn fn)
+    {
+        if (first >= last)
+            return;
+        if (grain <= 0)
+            grain = std::max(1, (last - first) / (4 * Threads()));
+        if (Threads() == 1 || last - first <= grain) {
+            fn(0, first, last);
+            return;
+        }
+
+        // A worker late from the previous loop may take a chunk as soon as it
+        // is queued, so the job and the counter are set up first
+        std::function<void(int, int, int)> job(std::move(fn));
+        m_Job = &job;
+        m_Pending.store((last - first + grain - 1) / grain);
+        for (int from = first, k = 0; from < last; from += grain, ++k) {
+            Queue& queue = *m_Queues[k % Threads()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.chunks.emplace_back(from, std::min(last, from + grain));
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            ++m_Generation;
+        }
+        m_Wake.notify_all();
+
+        RunChunks(0);
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Done.wait(lock, [this] { return m_Pending.load() == 0; });
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::pair<int, int>> chunks;
+    };
+
+    void Work(int self)
+    {
+        unsigned long long seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Wake.wait(lock, [&] { return m_Stop || m_Generation != seen; });
+                if (m_Stop)
+                    return;
+                seen = m_Generation;
+            }
+            RunChunks(self);
+        }
+    }
+
+    // Own queue from the back, then the others from the front
+    void RunChunks(int self)
+    {
+        std::pair<int, int> chunk;
+        while (Pop(self, chunk)) {
+            (*m_Job)(self, chunk.first, chunk.second);
+            if (m_Pending.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Done.notify_all();
+            }
+        }
+    }
+
+    bool Pop(int self, std::pair<int, int>& chunk)
+    {
+        {
+            Queue& own = *m_Queues[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.chunks.empty()) {
+                chunk = own.chunks.back();
+                own.chunks.pop_back();
+                return true;
+            }
+        }
+        for (int k = 1; k < Threads(); ++k) {
+            Queue& other = *m_Queues[(self + k) % Threads()];
+            std::lock_guard<std::mutex> lock(other.mutex);
+            if (!other.chunks.empty()) {
+                chunk = other.chunks.front();
+                other.chunks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<std::unique_ptr<Queue>> m_Queues;
+    std::vector<std::thread> m_Workers;
+    const std::function<void(int, int, int)>* m_Job = nullptr;   // set before the chunks are queued
+    std::atomic<int> m_Pending{0};
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Wake;
+    std::condition_variable m_Done;
+    unsigned long long m_Generation = 0;
+    bool m_Stop = false;
+};
@@ -0,0 +1,206 @@
+// NFA -> DFA compile pipeline (ε-removal, subset construction, Hopcroft
+// minimization) on the automata of this practical work and on large NFAs.
+//
+//   compile                      - built-in automata
+//   compile <file.jff> [input]   - automaton from JFLAP; with `input` every
+//                                  line of it is classified ('1' / '0')
+
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../common/record_reader.hpp"
+#include "compile.hpp"
+#include "jff_nfa.hpp"
+
+// DFA from dfa.cpp: state = last five symbols, accepted if the fifth from the
+// right is 1. With `history` = 6 the machine remembers one symbol more than it
+// needs (64 states), minimization must collapse it back to 32 states.
+BitNfa BuildShiftRegisterDFA(int history)
+{
+    int states = 1 << history;
+    BitNfa nfa(states, "01");
+    for (int q = 0; q < states; ++q)
+    {
+        nfa.AddTransition(q, '0', (q << 1) & (states - 1));
+        nfa.AddTransition(q, '1', ((q << 1) | 1) & (states - 1));
+        if ((q >> 4) & 1)
+            nfa.SetAccepting(q);
+    }
+    nfa.AddStart(0);
+    return nfa;
+}
+
+// NFA from nfa.cpp
+BitNfa BuildNFA()
+{
+    enum { q0, q1, q2 };
+    BitNfa nfa(3, "ab");
+    nfa.AddTransition(q0, 'b', q0);
+    nfa.AddTransition(q0, 'a', q1);
+    nfa.AddTransition(q0, 'a', q2);
+    nfa.AddTransition(q1, 'a', q1);
+    nfa.AddTransition(q1, 'b', q2);
+    nfa.AddTransition(q2, 'a', q2);
+    nfa.AddTransition(q2, 'b', q2);
+    nfa.AddStart(q0);
+    nfa.SetAccepting(q0);
+    nfa.SetAccepting(q1);
+    return nfa;
+}
+
+// ε-NFA from enfa.cpp
+BitNfa BuildENFA()
+{
+    enum { q0, q1, q2 };
+    BitNfa nfa(3, "ab");
+    nfa.AddEpsilon(q0, q1);
+    nfa.AddTransition(q0, 'b', q2);
+    nfa.AddTransition(q1, 'a', q1);
+    nfa.AddTransition(q2, 'b', q2);
+    nfa.AddTransition(q2, 'a', q1);
+    nfa.AddStart(q0);
+    nfa.SetAccepting(q1);
+    nfa.SetAccepting(q2);
+    nfa.ComputeClosures();
+    return nfa;
+}
+
+// "The k-th symbol from the right is 1": k + 1 NFA states, 2^k DFA states
+BitNfa BuildKthFromRight(int k)
+{
+    BitNfa nfa(k + 1, "01");
+    nfa.AddTransition(0, '0', 0);
+    nfa.AddTransition(0, '1', 0);
+    nfa.AddTransition(0, '1', 1);
+    for (int q = 1; q < k; ++q)
+    {
+        nfa.AddTransition(q, '0', q + 1);
+        nfa.AddTransition(q, '1', q + 1);
+    }
+    nfa.AddStart(0);
+    nfa.SetAccepting(k);
+    return nfa;
+}
+
+// Union of random keywords, every keyword is a separate ε-branch from the start:
+// thousands of NFA states, the DFA is the keyword trie
+BitNfa BuildKeywords(int keywords, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<std::string> words(keywords);
+    int states = 1;
+    for (auto &word : words)
+    {
+        int length = 4 + (int)(rng() % 12);
+        for (int i = 0; i < length; ++i)
+            word += "abcd"[rng() % 4];
+        states += length + 1;
+    }
+
+    BitNfa nfa(states, "abcd");
+    int next = 1;
+    for (const auto &word : words)
+    {
+        int from = next++;
+        nfa.AddEpsilon(0, from);
+        for (char ch : word)
+        {
+            nfa.AddTransition(from, ch, next);
+            from = next++;
+        }
+        nfa.SetAccepting(from);
+    }
+    nfa.AddStart(0);
+    nfa.ComputeClosures();
+    return nfa;
+}
+
+// Checks the compiled DFA against the NFA simulation on random strings
+bool Verify(const BitNfa &nfa, const DenseDfa &dfa, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    NfaRunner runner(nfa);
+    const std::string &sigma = nfa.Alphabet();
+    for (int t = 0; t < 2000; ++t)
+    {
+        std::string input;
+        int length = (int)(rng() % 40);
+        for (int i = 0; i < length; ++i)
+            input += sigma[rng() % sigma.size()];
+
+        runner.Reset();
+        for (char ch : input)
+            runner.Step(ch);
+        if (runner.IsAccepting() != dfa.Accepts(input.data(), input.data() + input.size()))
+            return false;
+    }
+    return true;
+}
+
+void Report(const char *name, const BitNfa &nfa)
+{
+    CompileStats stats;
+    DenseDfa dfa = CompileNfa(nfa, &stats);
+    bool ok = Verify(nfa, dfa, 7);
+
+    std::printf("%-28s NFA %6d%s | eps-free (%7.3f ms) | subset %6d (%8.3f ms) | minimal %6d (%7.3f ms) | %s\n",
+                name, stats.nfa_states, stats.had_epsilon ? " (eps)" : "      ",
+                stats.epsilon_seconds * 1e3,
+                stats.subset_states, stats.subset_seconds * 1e3,
+                stats.minimal_states, stats.minimize_seconds * 1e3, ok ? "ok" : "MISMATCH");
+}
+
+int RunJff(const char *path, const char *input)
+{
+    auto begin = std::chrono::steady_clock::now();
+    JffDocument doc;
+    BitNfa nfa;
+    std::string error;
+    if (!doc.Load(path, &error) || !BuildBitNfa(doc, nfa, &error))
+    {
+        std::fprintf(stderr, "%s: %s\n", path, error.c_str());
+        return 1;
+    }
+    double load_ms = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() * 1e3;
+    std::fprintf(stderr, "%s: loaded in %.3f ms\n", path, load_ms);
+
+    if (!input)
+    {
+        Report(path, nfa);
+        return 0;
+    }
+
+    DenseDfa dfa = CompileNfa(nfa);
+    RecordReader reader;
+    if (!reader.Open(input, &error))
+    {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    std::string_view line;
+    while (reader.Next(line))
+        std::fputs(dfa.Accepts(line.data(), line.data() + line.size()) ? "1\n" : "0\n", stdout);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1)
+        return RunJff(argv[1], argc > 2 ? argv[2] : nullptr);
+
+    Report("dfa.cpp (32 states)", BuildShiftRegisterDFA(5));
+    Report("dfa.cpp, 6-symbol history", BuildShiftRegisterDFA(6));
+    Report("nfa.cpp", BuildNFA());
+    Report("enfa.cpp", BuildENFA());
+    Report("12th from right is 1", BuildKthFromRight(12));
+    Report("100 keywords", BuildKeywords(100, 1));
+    Report("300 keywords", BuildKeywords(300, 2));
+    Report("1000 keywords", BuildKeywords(1000, 3));
+    return 0;
+}
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "dense_dfa.hpp"
+#include "lazy_dfa.hpp"
+#include "nfa.hpp"
+
+// NFA -> DFA compile pipeline: ε-removal, subset construction, Hopcroft
+// minimization. Результат - DenseDfa с полной плотной таблицей переходов.
+
+// Subset construction: all DFA states reachable from the start set.
+// Множества интернирует LazyDfa без ограничения памяти; обход в ширину
+// по его состояниям дает полный ДКА (пустое множество - мертвое состояние).
+inline DenseDfa SubsetConstruction(const BitNfa& nfa)
+{
+    LazyDfa lazy(nfa, std::numeric_limits<size_t>::max());
+    int alphabet = nfa.AlphabetSize();
+
+    std::vector<int> next;
+    for (int state = 0; state < lazy.States(); ++state)
+        for (int a = 0; a < alphabet; ++a)
+            next.push_back(lazy.Next(state, a));
+
+    int states = lazy.States();
+    DenseDfa dfa(states, nfa.Alphabet(), lazy.Start());
+    for (int state = 0; state < states; ++state) {
+        for (int a = 0; a < alphabet; ++a)
+            dfa.SetTransition(state, a, next[static_cast<size_t>(state) * alphabet + a]);
+        dfa.SetAccepting(state, lazy.IsAccepting(state));
+    }
+    return dfa;
+}
+
+// Hopcroft minimization of a complete DFA whose states are all reachable.
+// Разбиение хранится как перестановка состояний, где каждый блок - отрезок;
+// при обработке сплиттера состояния-предшественники переносятся в начало
+// своих блоков, и блок делится по этой границе. В очередь попадает меньшая
+// из половин (или обе, если блок уже был в очереди) - O(k n log n).
+inline DenseDfa MinimizeHopcroft(const DenseDfa& dfa)
+{
+    int n = dfa.States();
+    int k = dfa.AlphabetSize();
+
+    // Inverse transitions in CSR form: sources of (target, symbol)
+    std::vector<int> inv_first(static_cast<size_t>(n) * k + 1, 0);
+    std::vector<int> inv_source(static_cast<size_t>(n) * k);
+    for (int q = 0; q < n; ++q)
+        for (int a = 0; a < k; ++a)
+            ++inv_first[static_cast<size_t>(dfa.Next(q, a)) * k + a + 1];
+    for (size_t i = 1; i < inv_first.size(); ++i)
+        inv_first[i] += inv_first[i - 1];
+    {
+        std::vector<int> fill(inv_first.begin(), inv_first.end() - 1);
+        for (int q = 0; q < n; ++q)
+            for (int a = 0; a < k; ++a)
+                inv_source[fill[static_cast<size_t>(dfa.Next(q, a)) * k + a]++] = q;
+    }
+
+    // Refinable partition
+    std::vector<int> elems(n), loc(n), block(n);
+    std::vector<int> first, end, mid;
+    std::vector<uint8_t> in_work;
+    std::vector<int> work;
+
+    int accepting = 0;
+    for (int q = 0; q < n; ++q)
+        accepting += dfa.IsAccepting(q);
+    {
+        int pos_acc = 0, pos_rej = accepting;
+        for (int q = 0; q < n; ++q)
+            elems[dfa.IsAccepting(q) ? pos_acc++ : pos_rej++] = q;
+    }
+    auto add_block = [&](int b_first, int b_end) {
+        int b = static_cast<int>(first.size());
+        first.push_back(b_first);
+        end.push_back(b_end);
+        mid.push_back(b_first);
+        in_work.push_back(0);
+        for (int i = b_first; i < b_end; ++i) {
+            block[elems[i]] = b;
+            loc[elems[i]] = i;
+        }
+        return b;
+    };
+    if (accepting > 0)
+        add_block(0, accepting);
+    if (accepting < n)
+        add_block(accepting, n);
+    if (first.size() == 2) {
+        int smaller = (end[0] - first[0] <= end[1] - first[1]) ? 0 : 1;
+        work.push_back(smaller);
+        in_work[smaller] = 1;
+    }
+
+    std::vector<int> splitter, touched;
+    while (!work.empty()) {
+        int s = work.back();
+        work.pop_back();
+        in_work[s] = 0;
+        splitter.assign(elems.begin() + first[s], elems.begin() + end[s]);
+
+        for (int a = 0; a < k; ++a) {
+            touched.clear();
+            for (int t : splitter) {
+                size_t key = static_cast<size_t>(t) * k + a;
+                for (int i = inv_first[key]; i < inv_first[key + 1]; ++i) {
+                    int q = inv_source[i];
+                    int b = block[q];
+                    if (loc[q] < mid[b])
+                        continue;  // already marked
+                    if (mid[b] == first[b])
+                        touched.push_back(b);
+                    // Swap q with the first unmarked element of its block
+                    int other = elems[mid[b]];
+                    std::swap(elems[loc[q]], elems[mid[b]]);
+                    loc[other] = loc[q];
+                    loc[q] = mid[b];
+                    ++mid[b];
+                }
+            }
+
+            for (int b : touched) {
+                if (mid[b] == end[b]) {
+                    mid[b] = first[b];
+                    continue;
+                }
+                // Marked part [first, mid) becomes a new block
+                int nb = add_block(first[b], mid[b]);
+                first[b] = mid[b];
+                mid[b] = first[b];
+                if (in_work[b]) {
+                    work.push_back(nb);
+                    in_work[nb] = 1;
+                } else {
+                    int smaller = (end[nb] - first[nb] <= end[b] - first[b]) ? nb : b;
+                    work.push_back(smaller);
+                    in_work[smaller] = 1;
+                }
+            }
+        }
+    }
+
+    // Quotient DFA, states renumbered in BFS order from the start block
+    int blocks = static_cast<int>(first.size());
+    std::vector<int> number(blocks, -1);
+    std::vector<int> order;
+    number[block[dfa.Start()]] = 0;
+    order.push_back(block[dfa.Start()]);
+    for (size_t i = 0; i < order.size(); ++i) {
+        int representative = elems[first[order[i]]];
+        for (int a = 0; a < k; ++a) {
+            int b = block[dfa.Next(representative, a)];
+            if (number[b] < 0) {
+                number[b] = static_cast<int>(order.size());
+                order.push_back(b);
+            }
+        }
+    }
+
+    DenseDfa minimal(static_cast<int>(order.size()), dfa.Alphabet(), 0);
+    for (size_t i = 0; i < order.size(); ++i) {
+        int representative = elems[first[order[i]]];
+        for (int a = 0; a < k; ++a)
+            minimal.SetTransition(static_cast<int>(i), a, number[block[dfa.Next(representative, a)]]);
+        minimal.SetAccepting(static_cast<int>(i), dfa.IsAccepting(representative));
+    }
+    return minimal;
+}
+
+struct CompileStats {
+    int nfa_states = 0;
+    bool had_epsilon = false;
+    int subset_states = 0;
+    int minimal_states = 0;
+    double epsilon_seconds = 0;
+    double subset_seconds = 0;
+    double minimize_seconds = 0;
+};
+
+// The whole pipeline: BitNfa (possibly with ε-transitions) -> minimal DenseDfa
+inline DenseDfa CompileNfa(const BitNfa& nfa, CompileStats* stats = nullptr)
+{
+    using Clock = std::chrono::steady_clock;
+    auto seconds = [](Clock::time_point from) {
+        return std::chrono::duration<double>(Clock::now() - from).count();
+    };
+
+    CompileStats local;
+    local.nfa_states = nfa.States();
+    local.had_epsilon = nfa.HasEpsilon();
+
+    auto begin = Clock::now();
+    BitNfa plain = nfa.RemoveEpsilon();
+    local.epsilon_seconds = seconds(begin);
+
+    begin = Clock::now();
+    DenseDfa subset = SubsetConstruction(plain);
+    local.subset_seconds = seconds(begin);
+    local.subset_states = subset.States();
+
+    begin = Clock::now();
+    DenseDfa minimal = MinimizeHopcroft(subset);
+    local.minimize_seconds = seconds(begin);
+    local.minimal_states = minimal.States();
+
+    if (stats)
+        *stats = local;
+    return minimal;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// DFA with a dense transition table whose size is known only at runtime
+// (результат компиляции НКА, см. compile.hpp). Таблица полная: отсутствующие
+// переходы ведут в явное "мертвое" состояние.
+class DenseDfa {
+public:
+    static constexpr int UNKNOWN_SYMBOL = -1;
+
+    DenseDfa() = default;
+
+    DenseDfa(int states, const std::string& alphabet, int start_state = 0)
+        : m_States(states), m_Start(start_state), m_Alphabet(alphabet)
+    {
+        m_Symbol_Class.fill(-1);
+        for (size_t i = 0; i < alphabet.size(); ++i)
+            m_Symbol_Class[static_cast<unsigned char>(alphabet[i])] = static_cast<int>(i);
+        m_Delta.assign(static_cast<size_t>(states) * alphabet.size(), 0);
+        m_Accepted.assign(states, 0);
+    }
+
+    int States() const { return m_States; }
+    int Start() const { return m_Start; }
+    int AlphabetSize() const { return static_cast<int>(m_Alphabet.size()); }
+    const std::string& Alphabet() const { return m_Alphabet; }
+
+    // Index of the symbol in Sigma, -1 if the symbol is not in Sigma
+    int SymbolIndex(char symbol) const
+    {
+        return m_Symbol_Class[static_cast<unsigned char>(symbol)];
+    }
+
+    void SetStart(int state) { m_Start = state; }
+
+    void SetTransition(int from, int symbol_index, int to)
+    {
+        m_Delta[static_cast<size_t>(from) * m_Alphabet.size() + symbol_index] = to;
+    }
+
+    void SetAccepting(int state, bool accepting = true) { m_Accepted[state] = accepting; }
+
+    int Next(int state, int symbol_index) const
+    {
+        return m_Delta[static_cast<size_t>(state) * m_Alphabet.size() + symbol_index];
+    }
+
+    bool IsAccepting(int state) const { return m_Accepted[state]; }
+
+    // Runs [first, last) from `state`; returns the reached state or UNKNOWN_SYMBOL
+    int Run(int state, const char* first, const char* last) const
+    {
+        const int* delta = m_Delta.data();
+        size_t width = m_Alphabet.size();
+        for (; first != last; ++first) {
+            int symbol_index = SymbolIndex(*first);
+            if (symbol_index < 0)
+                return UNKNOWN_SYMBOL;
+            state = delta[static_cast<size_t>(state) * width + symbol_index];
+        }
+        return state;
+    }
+
+    bool Accepts(const char* first, const char* last) const
+    {
+        int state = Run(m_Start, first, last);
+        return state != UNKNOWN_SYMBOL && IsAccepting(state);
+    }
+
+private:
+    int m_States = 0;
+    int m_Start = 0;
+    std::string m_Alphabet;
+    std::array<int, 256> m_Symbol_Class {};
+    std::vector<int> m_Delta;
+    std::vector<uint8_t> m_Accepted;
+};
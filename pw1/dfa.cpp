@@ -1,5 +1,18 @@
 #include <iostream>
 #include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dfa.hpp"
+#include "dfa_parallel.hpp"
+#include "dfa_search.hpp"
+#include "dfa_simd.hpp"
 
 enum RESULT {
     UNKNOWN_SYMBOL_ERR      = 0,
@@ -20,88 +33,166 @@ constexpr int ACCEPTED_STATES = 16;
 constexpr int ALPHABET_CHARCTERS = 2;
 
 // The set F
-std::array<int, ACCEPTED_STATES> g_Accepted_states { 
+constexpr std::array<int, ACCEPTED_STATES> g_Accepted_states { 
     q10000, q10001, q10010, q10011, q10100, q10101, q10110, q10111, 
     q11000, q11001, q11010, q11011, q11100, q11101, q11110, q11111 
 };
 
 // The set Sigma
-std::array<char, ALPHABET_CHARCTERS> g_Alphabet { '0', '1' };
-
-// Transition function
-int g_Transition_Table[TOTAL_STATES][ALPHABET_CHARCTERS] = {};
-
-//Start state of DFA
-int g_Current_state = q00000;
-
-void SetDFA_Transitions() {
-    g_Transition_Table[q00000][0] = q00000; 
-    g_Transition_Table[q00000][1] = q00001;
-    g_Transition_Table[q00001][0] = q00010; 
-    g_Transition_Table[q00001][1] = q00011;
-    g_Transition_Table[q00010][0] = q00100; 
-    g_Transition_Table[q00010][1] = q00101;
-    g_Transition_Table[q00011][0] = q00110; 
-    g_Transition_Table[q00011][1] = q00111;
-    g_Transition_Table[q00100][0] = q01000; 
-    g_Transition_Table[q00100][1] = q01001;
-    g_Transition_Table[q00101][0] = q01010; 
-    g_Transition_Table[q00101][1] = q01011;
-    g_Transition_Table[q00110][0] = q01100; 
-    g_Transition_Table[q00110][1] = q01101;
-    g_Transition_Table[q00111][0] = q01110; 
-    g_Transition_Table[q00111][1] = q01111;
-    g_Transition_Table[q01000][0] = q10000; 
-    g_Transition_Table[q01000][1] = q10001;
-    g_Transition_Table[q01001][0] = q10010; 
-    g_Transition_Table[q01001][1] = q10011;
-    g_Transition_Table[q01010][0] = q10100; 
-    g_Transition_Table[q01010][1] = q10101;
-    g_Transition_Table[q01011][0] = q10110; 
-    g_Transition_Table[q01011][1] = q10111;
-    g_Transition_Table[q01100][0] = q11000; 
-    g_Transition_Table[q01100][1] = q11001;
-    g_Transition_Table[q01101][0] = q11010; 
-    g_Transition_Table[q01101][1] = q11011;
-    g_Transition_Table[q01110][0] = q11100; 
-    g_Transition_Table[q01110][1] = q11101;
-    g_Transition_Table[q01111][0] = q11110; 
-    g_Transition_Table[q01111][1] = q11111;
-    g_Transition_Table[q10000][0] = q00000; 
-    g_Transition_Table[q10000][1] = q00001;
-    g_Transition_Table[q10001][0] = q00010; 
-    g_Transition_Table[q10001][1] = q00011;
-    g_Transition_Table[q10010][0] = q00100; 
-    g_Transition_Table[q10010][1] = q00101;
-    g_Transition_Table[q10011][0] = q00110; 
-    g_Transition_Table[q10011][1] = q00111;
-    g_Transition_Table[q10100][0] = q01000; 
-    g_Transition_Table[q10100][1] = q01001;
-    g_Transition_Table[q10101][0] = q01010; 
-    g_Transition_Table[q10101][1] = q01011;
-    g_Transition_Table[q10110][0] = q01100; 
-    g_Transition_Table[q10110][1] = q01101;
-    g_Transition_Table[q10111][0] = q01110; 
-    g_Transition_Table[q10111][1] = q01111;
-    g_Transition_Table[q11000][0] = q10000; 
-    g_Transition_Table[q11000][1] = q10001;
-    g_Transition_Table[q11001][0] = q10010; 
-    g_Transition_Table[q11001][1] = q10011;
-    g_Transition_Table[q11010][0] = q10100; 
-    g_Transition_Table[q11010][1] = q10101;
-    g_Transition_Table[q11011][0] = q10110; 
-    g_Transition_Table[q11011][1] = q10111;
-    g_Transition_Table[q11100][0] = q11000; 
-    g_Transition_Table[q11100][1] = q11001;
-    g_Transition_Table[q11101][0] = q11010; 
-    g_Transition_Table[q11101][1] = q11011;
-    g_Transition_Table[q11110][0] = q11100; 
-    g_Transition_Table[q11110][1] = q11101;
-    g_Transition_Table[q11111][0] = q11110; 
-    g_Transition_Table[q11111][1] = q11111;
+constexpr std::array<char, ALPHABET_CHARCTERS> g_Alphabet { '0', '1' };
+
+using DFA_Type = Dfa<TOTAL_STATES, ALPHABET_CHARCTERS>;
+
+// Transition function (built at compile time, start state is q00000)
+constexpr DFA_Type BuildDFA() {
+    DFA_Type dfa(g_Alphabet, q00000);
+
+    dfa.SetTransition(q00000, '0', q00000); 
+    dfa.SetTransition(q00000, '1', q00001);
+    dfa.SetTransition(q00001, '0', q00010); 
+    dfa.SetTransition(q00001, '1', q00011);
+    dfa.SetTransition(q00010, '0', q00100); 
+    dfa.SetTransition(q00010, '1', q00101);
+    dfa.SetTransition(q00011, '0', q00110); 
+    dfa.SetTransition(q00011, '1', q00111);
+    dfa.SetTransition(q00100, '0', q01000); 
+    dfa.SetTransition(q00100, '1', q01001);
+    dfa.SetTransition(q00101, '0', q01010); 
+    dfa.SetTransition(q00101, '1', q01011);
+    dfa.SetTransition(q00110, '0', q01100); 
+    dfa.SetTransition(q00110, '1', q01101);
+    dfa.SetTransition(q00111, '0', q01110); 
+    dfa.SetTransition(q00111, '1', q01111);
+    dfa.SetTransition(q01000, '0', q10000); 
+    dfa.SetTransition(q01000, '1', q10001);
+    dfa.SetTransition(q01001, '0', q10010); 
+    dfa.SetTransition(q01001, '1', q10011);
+    dfa.SetTransition(q01010, '0', q10100); 
+    dfa.SetTransition(q01010, '1', q10101);
+    dfa.SetTransition(q01011, '0', q10110); 
+    dfa.SetTransition(q01011, '1', q10111);
+    dfa.SetTransition(q01100, '0', q11000); 
+    dfa.SetTransition(q01100, '1', q11001);
+    dfa.SetTransition(q01101, '0', q11010); 
+    dfa.SetTransition(q01101, '1', q11011);
+    dfa.SetTransition(q01110, '0', q11100); 
+    dfa.SetTransition(q01110, '1', q11101);
+    dfa.SetTransition(q01111, '0', q11110); 
+    dfa.SetTransition(q01111, '1', q11111);
+    dfa.SetTransition(q10000, '0', q00000); 
+    dfa.SetTransition(q10000, '1', q00001);
+    dfa.SetTransition(q10001, '0', q00010); 
+    dfa.SetTransition(q10001, '1', q00011);
+    dfa.SetTransition(q10010, '0', q00100); 
+    dfa.SetTransition(q10010, '1', q00101);
+    dfa.SetTransition(q10011, '0', q00110); 
+    dfa.SetTransition(q10011, '1', q00111);
+    dfa.SetTransition(q10100, '0', q01000); 
+    dfa.SetTransition(q10100, '1', q01001);
+    dfa.SetTransition(q10101, '0', q01010); 
+    dfa.SetTransition(q10101, '1', q01011);
+    dfa.SetTransition(q10110, '0', q01100); 
+    dfa.SetTransition(q10110, '1', q01101);
+    dfa.SetTransition(q10111, '0', q01110); 
+    dfa.SetTransition(q10111, '1', q01111);
+    dfa.SetTransition(q11000, '0', q10000); 
+    dfa.SetTransition(q11000, '1', q10001);
+    dfa.SetTransition(q11001, '0', q10010); 
+    dfa.SetTransition(q11001, '1', q10011);
+    dfa.SetTransition(q11010, '0', q10100); 
+    dfa.SetTransition(q11010, '1', q10101);
+    dfa.SetTransition(q11011, '0', q10110); 
+    dfa.SetTransition(q11011, '1', q10111);
+    dfa.SetTransition(q11100, '0', q11000); 
+    dfa.SetTransition(q11100, '1', q11001);
+    dfa.SetTransition(q11101, '0', q11010); 
+    dfa.SetTransition(q11101, '1', q11011);
+    dfa.SetTransition(q11110, '0', q11100); 
+    dfa.SetTransition(q11110, '1', q11101);
+    dfa.SetTransition(q11111, '0', q11110); 
+    dfa.SetTransition(q11111, '1', q11111);
+
+    for (int st : g_Accepted_states)
+        dfa.SetAccepting(st);
+
+    return dfa;
 }
 
-int DFA(char current_symbol) {
+constexpr DFA_Type g_DFA = BuildDFA();
+
+// One step is a table load for the symbol, a table load for the transition
+// and a bit test in the accept bitmap (REACHED = NOT_REACHED + 1)
+int DFA(int& current_state, char current_symbol) {
+
+    int symbol_index = g_DFA.SymbolIndex(current_symbol);
+
+    if (symbol_index < 0)
+        return UNKNOWN_SYMBOL_ERR;
+
+    current_state = g_DFA.Next(current_state, symbol_index);
+
+    return NOT_REACHED_FINAL_STATE + g_DFA.IsAccepting(current_state);
+}
+
+// Bulk mode: every line of the file is a separate input string.
+// Файл читается большими блоками, на каждую строку выводится вердикт
+// ('1' - accepted, '0' - rejected), по одному в строке.
+constexpr size_t BULK_BLOCK_SIZE = 1 << 20;
+
+int RunBulk(const char* path)
+{
+    FILE* in = (std::strcmp(path, "-") == 0) ? stdin : std::fopen(path, "rb");
+    if (!in) {
+        std::perror(path);
+        return 1;
+    }
+
+    std::vector<char> block(BULK_BLOCK_SIZE);
+    std::vector<char> verdicts;
+    verdicts.reserve(BULK_BLOCK_SIZE);
+
+    int state = g_DFA.Start();
+    bool bad_symbol = false;
+    bool line_open = false;
+
+    size_t got;
+    while ((got = std::fread(block.data(), 1, block.size(), in)) > 0) {
+        for (size_t i = 0; i < got; ++i) {
+            char ch = block[i];
+            if (ch == '\n') {
+                bool accepted = !bad_symbol && g_DFA.IsAccepting(state);
+                verdicts.push_back(accepted ? '1' : '0');
+                verdicts.push_back('\n');
+                state = g_DFA.Start();
+                bad_symbol = false;
+                line_open = false;
+                continue;
+            }
+            line_open = true;
+            int symbol_index = g_DFA.SymbolIndex(ch);
+            if (symbol_index >= 0)
+                state = g_DFA.Next(state, symbol_index);
+            else if (ch != '\r')
+                bad_symbol = true;
+        }
+        std::fwrite(verdicts.data(), 1, verdicts.size(), stdout);
+        verdicts.clear();
+    }
+
+    // Last line without trailing '\n'
+    if (line_open) {
+        bool accepted = !bad_symbol && g_DFA.IsAccepting(state);
+        std::fputs(accepted ? "1\n" : "0\n", stdout);
+    }
+
+    if (in != stdin)
+        std::fclose(in);
+    return 0;
+}
+
+// Step function with linear scans over Sigma and F (previous version of DFA()),
+// kept as the baseline for the benchmark
+int DFA_Reference(int& current_state, char current_symbol) {
 
     int symbol_index = -1;
 
@@ -114,24 +205,405 @@ int DFA(char current_symbol) {
     if (symbol_index == -1)
         return UNKNOWN_SYMBOL_ERR;
 
-    g_Current_state = g_Transition_Table[g_Current_state][symbol_index];
+    current_state = g_DFA.Next(current_state, symbol_index);
 
     for (int st : g_Accepted_states) {
-        if (g_Current_state == st) return REACHED_FINAL_STATE;
+        if (current_state == st) return REACHED_FINAL_STATE;
     }
 
     return NOT_REACHED_FINAL_STATE;
 }
 
-int main()
+template <typename StepFn>
+double BenchStep(StepFn step, const std::vector<char>& input, long long& checksum)
+{
+    auto begin = std::chrono::steady_clock::now();
+    int state = g_DFA.Start();
+    long long sum = 0;
+    for (char ch : input)
+        sum += step(state, ch);
+    auto end = std::chrono::steady_clock::now();
+    checksum += sum;
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+// Benchmark: table-driven DFA() against DFA_Reference() on random '0'/'1' strings
+int RunBenchmark()
+{
+    const size_t sizes[] = { 1ull << 10, 1ull << 20, 1ull << 30 };
+    const char* names[] = { "1 KB", "1 MB", "1 GB" };
+
+    std::mt19937_64 rng(42);
+    long long checksum = 0;
+
+    for (int i = 0; i < 3; ++i) {
+        std::vector<char> input(sizes[i]);
+        for (size_t pos = 0; pos < input.size(); pos += 64) {
+            uint64_t bits = rng();
+            for (size_t b = 0; b < 64 && pos + b < input.size(); ++b)
+                input[pos + b] = (bits >> b) & 1 ? '1' : '0';
+        }
+
+        // Small inputs are repeated to get measurable times
+        int repeats = (int)((1ull << 30) / sizes[i] / 32);
+        if (repeats < 1) repeats = 1;
+
+        double t_ref = 0, t_table = 0;
+        for (int r = 0; r < repeats; ++r) {
+            t_ref += BenchStep(DFA_Reference, input, checksum);
+            t_table += BenchStep(DFA, input, checksum);
+        }
+
+        double mb = (double)sizes[i] * repeats / (1 << 20);
+        std::printf("%-5s  reference: %8.1f MB/s   table: %8.1f MB/s   speedup: %.2fx\n",
+                    names[i], mb / t_ref, mb / t_table, t_ref / t_table);
+    }
+
+    std::printf("checksum: %lld\n", checksum);
+    return 0;
+}
+
+// Scaling benchmark of RunParallel() on one long random string (default 2 GB)
+int RunParallelBenchmark(size_t megabytes)
+{
+    std::vector<char> input(megabytes << 20);
+    std::mt19937_64 rng(42);
+    for (size_t pos = 0; pos < input.size(); pos += 64) {
+        uint64_t bits = rng();
+        for (size_t b = 0; b < 64 && pos + b < input.size(); ++b)
+            input[pos + b] = (bits >> b) & 1 ? '1' : '0';
+    }
+
+    const char* first = input.data();
+    const char* last = first + input.size();
+
+    auto begin = std::chrono::steady_clock::now();
+    int expected = g_DFA.Run(g_DFA.Start(), first, last);
+    double t_seq = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::printf("%zu MB, sequential: %.3f s (%.1f MB/s)\n", megabytes, t_seq, megabytes / t_seq);
+
+    int max_threads = (int)std::thread::hardware_concurrency();
+    if (max_threads < 2) max_threads = 2;
+
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        begin = std::chrono::steady_clock::now();
+        int state = RunParallel(g_DFA, g_DFA.Start(), first, last, threads);
+        double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        std::printf("threads: %2d  %.3f s  %8.1f MB/s  speedup: %.2fx  %s\n",
+                    threads, t, megabytes / t, t_seq / t, state == expected ? "ok" : "MISMATCH");
+    }
+    return 0;
+}
+
+// Benchmark of the RunFromAll() kernels (all 32 start states at once)
+int RunSimdBenchmark()
+{
+    std::vector<char> input(64 << 20);
+    std::mt19937_64 rng(42);
+    for (size_t pos = 0; pos < input.size(); pos += 64) {
+        uint64_t bits = rng();
+        for (size_t b = 0; b < 64 && pos + b < input.size(); ++b)
+            input[pos + b] = (bits >> b) & 1 ? '1' : '0';
+    }
+
+    const char* first = input.data();
+    const char* last = first + input.size();
+    int best = DetectSimdKernel();
+    std::printf("CPU kernel: %s\n", SimdKernelName(best));
+
+    DFA_Type::StateMap expected;
+    double t_scalar = 0;
+    for (int kernel = KERNEL_SCALAR; kernel <= best; ++kernel) {
+        DFA_Type::StateMap map;
+        auto begin = std::chrono::steady_clock::now();
+        RunFromAllSimd(g_DFA, first, last, map, kernel);
+        double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        if (kernel == KERNEL_SCALAR) {
+            expected = map;
+            t_scalar = t;
+        }
+        std::printf("%-10s  %8.1f MB/s  speedup: %5.2fx  %s\n", SimdKernelName(kernel),
+                    input.size() / t / (1 << 20), t_scalar / t, map == expected ? "ok" : "MISMATCH");
+    }
+    return 0;
+}
+
+// The same automaton as a BitNfa (for the search engine)
+BitNfa ToBitNfa()
 {
-    SetDFA_Transitions();
+    BitNfa nfa(TOTAL_STATES, std::string(g_Alphabet.begin(), g_Alphabet.end()));
+    for (int q = 0; q < TOTAL_STATES; ++q) {
+        for (int a = 0; a < ALPHABET_CHARCTERS; ++a)
+            nfa.AddTransitionByIndex(q, a, g_DFA.Next(q, a));
+        if (g_DFA.IsAccepting(q))
+            nfa.SetAccepting(q);
+    }
+    nfa.AddStart(g_DFA.Start());
+    return nfa;
+}
+
+// Search mode: every match of the language inside the file (not only whole
+// lines) as "start end" byte offsets, end exclusive
+int RunSearch(const char* path)
+{
+    FILE* in = (std::strcmp(path, "-") == 0) ? stdin : std::fopen(path, "rb");
+    if (!in) {
+        std::perror(path);
+        return 1;
+    }
+
+    DfaSearcher searcher(ToBitNfa());
+    std::string out;
+    DfaSearcher::Stats stats = searcher.SearchStream(in, [&out](size_t start, size_t end) {
+        out += std::to_string(start);
+        out += ' ';
+        out += std::to_string(end);
+        out += '\n';
+        if (out.size() > BULK_BLOCK_SIZE) {
+            std::fwrite(out.data(), 1, out.size(), stdout);
+            out.clear();
+        }
+    });
+    std::fwrite(out.data(), 1, out.size(), stdout);
+
+    std::fprintf(stderr, "%llu matches, %llu bytes, %llu skipped by the prefilter (%s), %.2f live runs per byte\n",
+                 (unsigned long long)stats.matches, (unsigned long long)stats.bytes, (unsigned long long)stats.skipped,
+                 SimdKernelName(searcher.Kernel()), stats.bytes ? (double)stats.run_steps / stats.bytes : 0.0);
+    if (in != stdin)
+        std::fclose(in);
+    return 0;
+}
+
+// Search benchmark on log-like text: letters, digits and rare runs of '0'/'1'
+int RunSearchBenchmark(size_t megabytes)
+{
+    std::vector<char> input(megabytes << 20);
+    std::mt19937_64 rng(42);
+    const char text[] = "abcdefghijklmnopqrstuvwxyz  23456789:=/.,";
+    size_t pos = 0;
+    while (pos < input.size()) {
+        uint64_t r = rng();
+        if (pos % 80 == 79) {
+            input[pos++] = '\n';
+        } else if (r % 200 == 0) {
+            // a run of 8..15 random bits
+            int bits = 8 + (int)((r >> 32) % 8);
+            for (int b = 0; b < bits && pos < input.size(); ++b)
+                input[pos++] = (r >> (8 + b)) & 1 ? '1' : '0';
+        } else {
+            input[pos++] = text[(r >> 16) % (sizeof(text) - 1)];
+        }
+    }
+
+    const char* first = input.data();
+    const char* last = first + input.size();
+    DfaSearcher searcher(ToBitNfa());
+    std::printf("%zu MB, DFA %d states, %d tuples\n", megabytes, searcher.States(), searcher.Tuples());
+
+    struct Mode { const char* name; bool prefilter; int kernel; };
+    const Mode modes[] = {
+        { "no prefilter", false, KERNEL_SCALAR },
+        { "scalar prefilter", true, KERNEL_SCALAR },
+        { "avx2 prefilter", true, KERNEL_AVX2 },
+    };
+
+    uint64_t expected = 0;
+    double t_base = 0;
+    for (const Mode& mode : modes) {
+        if (mode.kernel > DetectSimdKernel())
+            continue;
+        searcher.SetPrefilter(mode.prefilter);
+        searcher.SetKernel(mode.kernel);
+
+        uint64_t checksum = 0;
+        auto begin = std::chrono::steady_clock::now();
+        DfaSearcher::Stats stats = searcher.Search(first, last, [&checksum](size_t start, size_t end) {
+            checksum += start * 31 + end;
+        });
+        double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        if (!mode.prefilter) {
+            expected = checksum;
+            t_base = t;
+        }
+        std::printf("%-17s %8.1f MB/s  speedup: %5.2fx  %llu matches, %.1f%% skipped  %s\n", mode.name,
+                    megabytes / t, t_base / t, (unsigned long long)stats.matches,
+                    100.0 * stats.skipped / stats.bytes, checksum == expected ? "ok" : "MISMATCH");
+    }
+    return 0;
+}
+
+// Leftmost start for every match end, by running the NFA from every start
+std::vector<std::pair<size_t, size_t>> BruteForceMatches(const BitNfa& nfa, const std::string& text)
+{
+    std::vector<std::pair<size_t, size_t>> matches;
+    NfaRunner runner(nfa);
+    for (size_t end = 1; end <= text.size(); ++end) {
+        for (size_t start = 0; start < end; ++start) {
+            runner.Reset();
+            size_t p = start;
+            while (p < end && runner.Step(text[p]))
+                ++p;
+            if (p == end && runner.IsAccepting()) {
+                matches.emplace_back(start, end);
+                break;
+            }
+        }
+    }
+    return matches;
+}
+
+// Search self-check: small languages against BruteForceMatches on random
+// texts, in memory and as a stream cut into tiny blocks; then long texts that
+// are one live region, where the time must stay linear
+int RunSearchTest()
+{
+    using Matches = std::vector<std::pair<size_t, size_t>>;
+    auto search_stream = [](const DfaSearcher& searcher, const std::string& text, size_t block,
+                            DfaSearcher::Stats* stats) {
+        Matches found;
+        FILE* in = std::tmpfile();
+        std::fwrite(text.data(), 1, text.size(), in);
+        std::rewind(in);
+        *stats = searcher.SearchStream(in, [&found](size_t start, size_t end) { found.emplace_back(start, end); },
+                                       block);
+        std::fclose(in);
+        return found;
+    };
+
+    // {ab, b}: the minimal Sigma* L DFA is back in its start state after "a"
+    BitNfa ab_b(3, "ab");
+    ab_b.AddTransition(0, 'a', 1);
+    ab_b.AddTransition(1, 'b', 2);
+    ab_b.AddTransition(0, 'b', 2);
+    ab_b.AddStart(0);
+    ab_b.SetAccepting(2);
+    // a*b
+    BitNfa star(2, "ab");
+    star.AddTransition(0, 'a', 0);
+    star.AddTransition(0, 'b', 1);
+    star.AddStart(0);
+    star.SetAccepting(1);
+
+    struct Case { const char* name; BitNfa nfa; const char* text; };
+    const Case cases[] = {
+        { "{ab, b}", ab_b, "abx" },
+        { "a*b", star, "abx" },
+        { "dfa", ToBitNfa(), "01x" },
+    };
+
+    bool ok = true;
+    std::mt19937 rng(13);
+    for (const Case& c : cases) {
+        DfaSearcher searcher(c.nfa);
+        int failures = 0;
+        for (int it = 0; it < 2000; ++it) {
+            std::string text;
+            if (it == 0)
+                text = "xab";
+            for (int n = it == 0 ? 0 : rng() % 40; n > 0; --n)
+                text += c.text[rng() % 3];
+            Matches expected = BruteForceMatches(c.nfa, text);
+
+            // With the tuple DFA and with the runs kept one by one
+            Matches found, runs;
+            searcher.Search(text.data(), text.data() + text.size(),
+                            [&found](size_t start, size_t end) { found.emplace_back(start, end); });
+            DfaSearcher::Stats stats;
+            Matches streamed = search_stream(searcher, text, 1 + rng() % 4, &stats);
+            searcher.SetTuples(false);
+            searcher.Search(text.data(), text.data() + text.size(),
+                            [&runs](size_t start, size_t end) { runs.emplace_back(start, end); });
+            Matches streamed_runs = search_stream(searcher, text, 1 + rng() % 4, &stats);
+            searcher.SetTuples(true);
+            if (found != expected || streamed != expected || runs != expected || streamed_runs != expected) {
+                if (failures++ < 3)
+                    std::printf("%s: MISMATCH on \"%s\"\n", c.name, text.c_str());
+            }
+        }
+        std::printf("%-8s DFA %2d states, %2d tuples, 2000 random texts: %s\n", c.name, searcher.States(),
+                    searcher.Tuples(), failures ? "MISMATCH" : "ok");
+        ok = ok && failures == 0;
+    }
+
+    // a*b over 1 MB of "a" read in 4 KB blocks: the start is carried as an
+    // offset, not as bytes
+    DfaSearcher searcher(star);
+    DfaSearcher::Stats stats;
+    Matches found = search_stream(searcher, std::string(1 << 20, 'a') + "b", 4096, &stats);
+    bool whole = found.size() == 1 && found[0].first == 0 && found[0].second == (1 << 20) + 1;
+    std::printf("a*b      1 MB of \"a\" and \"b\" streamed: %s\n", whole ? "ok" : "MISMATCH");
+
+    // The pw1 language on random "0"/"1" without a separator: one live region
+    // with a match at almost every byte. Every byte costs at most one step of
+    // each DFA state, so 4 MB take about 4 times as long as 1 MB
+    DfaSearcher dfa(ToBitNfa());
+    double seconds[2][2] = {};
+    bool linear = true;
+    for (int k = 0; k < 2; ++k) {
+        size_t size = size_t(1) << (20 + 2 * k);
+        std::string text(size, '0');
+        for (char& ch : text)
+            ch = rng() & 1 ? '1' : '0';
+        uint64_t checksum[2] = {};
+        for (int tuples = 0; tuples < 2; ++tuples) {
+            dfa.SetTuples(tuples);
+            uint64_t& sum = checksum[tuples];
+            auto begin = std::chrono::steady_clock::now();
+            stats = dfa.Search(text.data(), text.data() + text.size(),
+                               [&sum](size_t start, size_t end) { sum += start ^ end; });
+            seconds[tuples][k] = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            linear = linear && stats.run_steps <= stats.bytes * dfa.States();
+        }
+        linear = linear && checksum[0] == checksum[1];
+        std::printf("dfa      %zu MB of random bits: %llu matches, %.2f live runs per byte, %.1f MB/s "
+                    "(runs one by one %.1f MB/s)\n", size >> 20, (unsigned long long)stats.matches,
+                    (double)stats.run_steps / stats.bytes, (size >> 20) / seconds[1][k],
+                    (size >> 20) / seconds[0][k]);
+    }
+    for (int tuples = 0; tuples < 2; ++tuples)
+        linear = linear && seconds[tuples][1] < 8 * seconds[tuples][0];
+    std::printf("dfa      4 MB / 1 MB time: %.2f, runs one by one %.2f (quadratic would be 16): %s\n",
+                seconds[1][1] / seconds[1][0], seconds[0][1] / seconds[0][0], linear ? "ok" : "MISMATCH");
+    return ok && whole && linear ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0)
+        return RunBenchmark();
+
+    if (argc > 1 && std::strcmp(argv[1], "--bench-simd") == 0)
+        return RunSimdBenchmark();
+
+    if (argc > 1 && std::strcmp(argv[1], "--bench-parallel") == 0)
+        return RunParallelBenchmark(argc > 2 ? std::stoul(argv[2]) : 2048);
+
+    if (argc > 1 && std::strcmp(argv[1], "--bench-search") == 0)
+        return RunSearchBenchmark(argc > 2 ? std::stoul(argv[2]) : 1024);
+
+    if (argc > 1 && std::strcmp(argv[1], "--test-search") == 0)
+        return RunSearchTest();
+
+    if (argc > 2 && std::strcmp(argv[1], "--search") == 0)
+        return RunSearch(argv[2]);
+
+    // An option without its argument or a misspelled one is not a file name
+    if (argc > 1 && std::strncmp(argv[1], "--", 2) == 0) {
+        std::cout << "Usage: dfa [<file> | -] | dfa --search <file> | dfa --test-search\n"
+                     "       dfa --bench | --bench-simd | --bench-parallel [MB] | --bench-search [MB]\n";
+        return 1;
+    }
+
+    if (argc > 1)
+        return RunBulk(argv[1]);
+
     std::cout << "Enter a string with '0's and '1's:\nPress Enter Key to stop\n";
 
     char ch;
+    int state = g_DFA.Start();
     int result = NOT_REACHED_FINAL_STATE;
     while(std::cin.get(ch) && ch != '\n') {
-        result = DFA(ch);
+        result = DFA(state, ch);
         if (result == UNKNOWN_SYMBOL_ERR) break;
     }
 
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Header-only DFA with compile-time tables.
+// Таблица переходов и множество F строятся в constexpr-функции, поэтому
+// объект можно объявить constexpr: он лежит в read-only памяти и не
+// содержит глобального состояния - текущее состояние хранит вызывающий код.
+template <int States, int Alphabet>
+class Dfa {
+    static_assert(States > 0 && States <= 65535, "Dfa: unsupported number of states");
+    static_assert(Alphabet > 0 && Alphabet <= 127, "Dfa: unsupported alphabet size");
+
+public:
+    using State = std::conditional_t<(States <= 256), uint8_t, uint16_t>;
+
+    // Image of every state: map[q] is the state reached from q
+    using StateMap = std::array<int, States>;
+
+    static constexpr int TOTAL_STATES = States;
+    static constexpr int ALPHABET_CHARCTERS = Alphabet;
+
+    // Returned by Run() when the input contains a symbol outside of Sigma
+    static constexpr int UNKNOWN_SYMBOL = -1;
+
+    constexpr explicit Dfa(const std::array<char, Alphabet>& sigma, int start_state = 0)
+        : m_Start(static_cast<State>(start_state))
+    {
+        for (auto& cls : m_Symbol_Class)
+            cls = -1;
+        for (int i = 0; i < Alphabet; ++i) {
+            m_Alphabet[i] = sigma[i];
+            m_Symbol_Class[static_cast<unsigned char>(sigma[i])] = static_cast<signed char>(i);
+        }
+    }
+
+    constexpr void SetTransition(int from, char symbol, int to)
+    {
+        m_Delta[from][SymbolIndex(symbol)] = static_cast<State>(to);
+    }
+
+    constexpr void SetAccepting(int state)
+    {
+        m_Accepted[state / 64] |= uint64_t(1) << (state % 64);
+    }
+
+    constexpr int Start() const { return m_Start; }
+
+    constexpr char Symbol(int index) const { return m_Alphabet[index]; }
+
+    // Index of the symbol in Sigma, -1 if the symbol is not in Sigma
+    constexpr int SymbolIndex(char symbol) const
+    {
+        return m_Symbol_Class[static_cast<unsigned char>(symbol)];
+    }
+
+    constexpr int Next(int state, int symbol_index) const
+    {
+        return m_Delta[state][symbol_index];
+    }
+
+    constexpr bool IsAccepting(int state) const
+    {
+        return (m_Accepted[state / 64] >> (state % 64)) & 1;
+    }
+
+    // Runs the DFA over [first, last) starting from `state`.
+    // Returns the reached state or UNKNOWN_SYMBOL.
+    constexpr int Run(int state, const char* first, const char* last) const
+    {
+        for (; first != last; ++first) {
+            int symbol_index = SymbolIndex(*first);
+            if (symbol_index < 0)
+                return UNKNOWN_SYMBOL;
+            state = m_Delta[state][symbol_index];
+        }
+        return state;
+    }
+
+    // Runs [first, last) from every state at once: map[q] becomes the state
+    // reached from q (or UNKNOWN_SYMBOL for all q). Used to process a chunk
+    // of input when the state at its beginning is not known yet.
+    constexpr void RunFromAll(const char* first, const char* last, StateMap& map) const
+    {
+        for (int q = 0; q < States; ++q)
+            map[q] = q;
+        for (; first != last; ++first) {
+            int symbol_index = SymbolIndex(*first);
+            if (symbol_index < 0) {
+                for (int q = 0; q < States; ++q)
+                    map[q] = UNKNOWN_SYMBOL;
+                return;
+            }
+            for (int q = 0; q < States; ++q)
+                map[q] = m_Delta[map[q]][symbol_index];
+        }
+    }
+
+    constexpr bool Accepts(const char* first, const char* last) const
+    {
+        int state = Run(m_Start, first, last);
+        return state != UNKNOWN_SYMBOL && IsAccepting(state);
+    }
+
+private:
+    std::array<std::array<State, Alphabet>, States> m_Delta {};
+    std::array<signed char, 256> m_Symbol_Class {};
+    std::array<uint64_t, (States + 63) / 64> m_Accepted {};
+    std::array<char, Alphabet> m_Alphabet {};
+    State m_Start = 0;
+};
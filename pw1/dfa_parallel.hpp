@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "dfa.hpp"
+#include "dfa_simd.hpp"
+
+// Parallel run of a DFA over one long input (speculative execution).
+// Вход делится на куски; первый кусок выполняется от известного состояния,
+// остальные - сразу от всех состояний (RunFromAllFast, для ДКА до 32
+// состояний - SIMD-ядро), параллельно. Затем
+// отображения кусков последовательно композируются: state = map_k[state].
+template <int States, int Alphabet>
+int RunParallel(const Dfa<States, Alphabet>& dfa, int state,
+                const char* first, const char* last, int threads)
+{
+    using DfaType = Dfa<States, Alphabet>;
+
+    size_t length = static_cast<size_t>(last - first);
+    if (threads < 2 || length < static_cast<size_t>(threads) * States)
+        return dfa.Run(state, first, last);
+
+    size_t chunk = length / threads;
+    std::vector<typename DfaType::StateMap> maps(threads - 1);
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+
+    for (int t = 1; t < threads; ++t) {
+        const char* begin = first + chunk * t;
+        const char* end = (t == threads - 1) ? last : begin + chunk;
+        workers.emplace_back([&dfa, &maps, t, begin, end] {
+            RunFromAllFast(dfa, begin, end, maps[t - 1]);
+        });
+    }
+
+    state = dfa.Run(state, first, first + chunk);
+
+    for (auto& worker : workers)
+        worker.join();
+
+    for (const auto& map : maps) {
+        if (state == DfaType::UNKNOWN_SYMBOL)
+            break;
+        state = map[state];
+    }
+    return state;
+}
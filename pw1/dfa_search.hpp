@@ -0,0 +1,405 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include "compile.hpp"
+#include "dfa_simd.hpp"
+#include "nfa.hpp"
+
+// Unanchored search: every end position where the language of the NFA is
+// matched, with the leftmost start of that match.
+//
+// Минимальный ДКА языка L запускается с каждой позиции текста, и все живые
+// запуски идут вместе за один проход. Два запуска, пришедшие в одно
+// состояние, дальше неотличимы, и от них остается тот, что начался раньше:
+// живых запусков не больше, чем состояний, а их порядок - порядок начал.
+// Поэтому для каждого конца совпадения самое левое начало - начало первого
+// запуска в принимающем состоянии, без прохода назад: время O(n * k), где
+// k - число состояний, и в потоке между блоками переносятся только запуски
+// (состояние и смещение начала), а не байты текста. Упорядоченный список
+// состояний живых запусков заранее сводится в ДКА (BuildTuples), и байт
+// стоит одного перехода по нему; если таких списков слишком много, запуски
+// ведутся по одному. Символ вне Sigma убивает все запуски. Пока живых запусков нет, префильтр пропускает байты,
+// с которых не начинается ни одно совпадение (поиск по множеству байтов -
+// AVX2, 32 байта за итерацию). Совпадения пустой строкой не ищутся.
+class DfaSearcher {
+public:
+    struct Stats {
+        uint64_t bytes = 0;          // bytes scanned
+        uint64_t skipped = 0;        // bytes skipped by the prefilter
+        uint64_t matches = 0;
+        uint64_t run_steps = 0;      // transitions of live runs, <= bytes * States()
+    };
+
+    explicit DfaSearcher(const BitNfa& nfa, int kernel = DetectSimdKernel())
+    {
+        SetKernel(kernel);
+        BuildTables(CompileNfa(nfa));
+        BuildTuples();
+
+        // Bytes that start a live run (non-Sigma bytes never do)
+        for (int b = 0; b < 256; ++b) {
+            bool escape = m_Table[static_cast<size_t>(m_Start) * 256 + b] != m_Dead;
+            m_Escape[b] = escape;
+            if (escape)
+                (b < 128 ? m_Escape_low : m_Escape_high)[b & 15] |= static_cast<uint8_t>(1 << ((b >> 4) & 7));
+        }
+    }
+
+    // States of the DFA of L (with the dead state)
+    int States() const { return static_cast<int>(m_Accepting.size()); }
+    // States of the DFA over ordered sets of live runs, 0 - too many of them
+    int Tuples() const { return static_cast<int>(m_Tuple_size.size()); }
+    void SetTuples(bool enabled) { m_Use_tuples = enabled && !m_Tuple_size.empty(); }
+
+    int Kernel() const { return m_Kernel; }
+    // The prefilter has scalar and AVX2 versions (AVX-512 CPUs use AVX2)
+    void SetKernel(int kernel) { m_Kernel = kernel > KERNEL_AVX2 ? KERNEL_AVX2 : kernel; }
+    void SetPrefilter(bool enabled) { m_Prefilter = enabled; }
+
+    // Byte may start a match
+    bool IsEscapeByte(unsigned char byte) const { return m_Escape[byte]; }
+
+    // All matches in [first, last): on_match(start, end), offsets from `first`
+    template <class Callback>
+    Stats Search(const char* first, const char* last, Callback on_match) const
+    {
+        Stats stats;
+        Runs runs(States());
+        Scan(first, 0, static_cast<size_t>(last - first), 0, runs, on_match, stats);
+        return stats;
+    }
+
+    // The same for a stream read in blocks; offsets are from the beginning of
+    // the stream. Между блоками переносятся только живые запуски, поэтому
+    // память не зависит от длины совпадений
+    template <class Callback>
+    Stats SearchStream(FILE* in, Callback on_match, size_t block = 1 << 20) const
+    {
+        Stats stats;
+        std::vector<char> buffer(block);
+        Runs runs(States());
+        size_t base = 0;
+        for (;;) {
+            size_t got = std::fread(buffer.data(), 1, block, in);
+            if (got == 0)
+                break;
+            Scan(buffer.data(), 0, got, base, runs, on_match, stats);
+            base += got;
+        }
+        return stats;
+    }
+
+private:
+    // A run of the DFA started at offset `start`
+    struct Run {
+        int state;
+        size_t start;
+    };
+
+    // Live runs in the order of their starts; `seen` - the states already
+    // taken during the current byte (seen[q] == tick)
+    struct Runs {
+        explicit Runs(int states) : live(states), seen(states, 0), starts(states) {}
+
+        std::vector<Run> live;      // [0, count)
+        size_t count = 0;
+        std::vector<uint32_t> seen;
+        uint32_t tick = 0;
+
+        int tuple = 0;              // with the tuple DFA: its state and
+        std::vector<size_t> starts; // the start of the run in every slot
+    };
+
+    // A transition of the tuple DFA: the source slot of every slot of the
+    // target is m_Sources[sources + slot] (-1 - the run starting at the
+    // byte); sources < 0 - the slots stay, a new one may be added last
+    struct Move {
+        int target;
+        int sources;
+    };
+
+    // 256 transitions per state, indexed by the byte itself; a byte outside
+    // of Sigma goes to the dead state (added if the DFA has none)
+    void BuildTables(const DenseDfa& dfa)
+    {
+        int states = dfa.States();
+        m_Start = dfa.Start();
+        m_Table.assign(static_cast<size_t>(states) * 256, -1);
+        m_Accepting.assign(states, 0);
+
+        m_Dead = -1;
+        for (int q = 0; q < states && m_Dead < 0; ++q) {
+            bool self = !dfa.IsAccepting(q);
+            for (int a = 0; a < dfa.AlphabetSize() && self; ++a)
+                self = dfa.Next(q, a) == q;
+            if (self)
+                m_Dead = q;
+        }
+        for (int q = 0; q < states; ++q) {
+            m_Accepting[q] = dfa.IsAccepting(q);
+            for (int b = 0; b < 256; ++b) {
+                int a = dfa.SymbolIndex(static_cast<char>(b));
+                m_Table[static_cast<size_t>(q) * 256 + b] = a >= 0 ? dfa.Next(q, a) : m_Dead;
+            }
+        }
+        if (m_Dead < 0) {
+            m_Dead = states;
+            m_Table.insert(m_Table.end(), 256, m_Dead);
+            m_Accepting.push_back(0);
+            for (int& next : m_Table)
+                if (next < 0)
+                    next = m_Dead;
+        }
+    }
+
+    // The runs are the same for every text: the ordered list of their states
+    // after a byte depends only on the list before it and the byte. Такие
+    // списки - состояния ДКА, который строится заранее (если их не больше
+    // MAX_TUPLES), и шаг по тексту - один переход по нему плюс перестановка
+    // начал, которая для большинства переходов пустая
+    void BuildTuples()
+    {
+        // Byte classes: bytes with equal columns of m_Table
+        std::map<std::vector<int>, int> columns;
+        std::vector<int> representative;
+        int states = States();
+        for (int b = 0; b < 256; ++b) {
+            std::vector<int> column(states);
+            for (int q = 0; q < states; ++q)
+                column[q] = m_Table[static_cast<size_t>(q) * 256 + b];
+            auto inserted = columns.emplace(column, static_cast<int>(representative.size()));
+            if (inserted.second)
+                representative.push_back(b);
+            m_Class[b] = static_cast<uint8_t>(inserted.first->second);
+        }
+        m_Classes = static_cast<int>(representative.size());
+
+        std::vector<std::vector<int>> tuples = { {} };
+        std::map<std::vector<int>, int> index = { { {}, 0 } };
+        std::vector<uint8_t> taken(states, 0);
+        for (size_t t = 0; t < tuples.size(); ++t) {
+            if (tuples.size() > MAX_TUPLES) {
+                m_Moves.clear();
+                m_Sources.clear();
+                m_Tuple_size.clear();
+                m_Tuple_accept.clear();
+                m_Use_tuples = false;
+                return;
+            }
+            const std::vector<int> tuple = tuples[t];
+            int accept = -1;
+            for (size_t j = 0; j < tuple.size() && accept < 0; ++j)
+                if (m_Accepting[tuple[j]])
+                    accept = static_cast<int>(j);
+            m_Tuple_size.push_back(static_cast<int>(tuple.size()));
+            m_Tuple_accept.push_back(accept);
+
+            for (int c = 0; c < m_Classes; ++c) {
+                int b = representative[c];
+                std::vector<int> next, sources;
+                for (size_t j = 0; j <= tuple.size(); ++j) {
+                    int from = j < tuple.size() ? tuple[j] : m_Start;
+                    int q = m_Table[static_cast<size_t>(from) * 256 + b];
+                    if (q == m_Dead || taken[q])
+                        continue;
+                    taken[q] = 1;
+                    next.push_back(q);
+                    sources.push_back(j < tuple.size() ? static_cast<int>(j) : -1);
+                }
+                for (int q : next)
+                    taken[q] = 0;
+
+                auto found = index.emplace(next, static_cast<int>(tuples.size()));
+                if (found.second)
+                    tuples.push_back(next);
+                bool same = true;
+                for (size_t j = 0; j < sources.size() && same; ++j)
+                    same = sources[j] == static_cast<int>(j) || (sources[j] < 0 && j == tuple.size());
+                m_Moves.push_back({ found.first->second, same ? -1 : static_cast<int>(m_Sources.size()) });
+                if (!same)
+                    m_Sources.insert(m_Sources.end(), sources.begin(), sources.end());
+            }
+        }
+        m_Use_tuples = true;
+    }
+
+    template <class Callback>
+    void Scan(const char* buffer, size_t from, size_t to, size_t base, Runs& runs, Callback& on_match,
+              Stats& stats) const
+    {
+        if (m_Use_tuples)
+            ScanTuples(buffer, from, to, base, runs, on_match, stats);
+        else
+            ScanRuns(buffer, from, to, base, runs, on_match, stats);
+    }
+
+    template <class Callback>
+    void ScanTuples(const char* buffer, size_t from, size_t to, size_t base, Runs& runs, Callback& on_match,
+                    Stats& stats) const
+    {
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(buffer);
+        size_t* starts = runs.starts.data();
+        const Move* moves = m_Moves.data();
+        const int* size = m_Tuple_size.data();
+        const int* accept = m_Tuple_accept.data();
+        int t = runs.tuple;
+        stats.bytes += to - from;
+
+        size_t i = from;
+        while (i < to) {
+            if (t == 0 && m_Prefilter) {
+                size_t next = Skip(data, i, to);
+                stats.skipped += next - i;
+                i = next;
+                if (i == to)
+                    break;
+            }
+            const Move& move = moves[static_cast<size_t>(t) * m_Classes + m_Class[data[i]]];
+            int target = move.target;
+            if (move.sources < 0) {
+                if (size[target] > size[t])
+                    starts[size[t]] = base + i;
+            } else {
+                // Slots only move to the front, so the copy can go in place
+                const int* sources = m_Sources.data() + move.sources;
+                for (int j = 0; j < size[target]; ++j)
+                    starts[j] = sources[j] < 0 ? base + i : starts[sources[j]];
+            }
+            stats.run_steps += size[t] + 1;
+            t = target;
+            ++i;
+            if (accept[t] >= 0) {
+                ++stats.matches;
+                on_match(starts[accept[t]], base + i);
+            }
+        }
+        runs.tuple = t;
+    }
+
+    template <class Callback>
+    void ScanRuns(const char* buffer, size_t from, size_t to, size_t base, Runs& runs, Callback& on_match,
+                  Stats& stats) const
+    {
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(buffer);
+        Run* live = runs.live.data();
+        uint32_t* seen = runs.seen.data();
+        const int* table = m_Table.data();
+        const uint8_t* accepting = m_Accepting.data();
+        stats.bytes += to - from;
+
+        size_t i = from;
+        while (i < to) {
+            if (runs.count == 0 && m_Prefilter) {
+                size_t next = Skip(data, i, to);
+                stats.skipped += next - i;
+                i = next;
+                if (i == to)
+                    break;
+            }
+            uint32_t tick = ++runs.tick;
+            if (tick == 0) {
+                std::fill(runs.seen.begin(), runs.seen.end(), 0);
+                tick = runs.tick = 1;
+            }
+            const int* column = table + data[i];
+
+            // Every live run and then the one starting here: the first run
+            // that takes a state keeps it, and the first accepting run gives
+            // the leftmost start of the match ending after this byte
+            size_t count = 0;
+            size_t start = SIZE_MAX;
+            for (size_t k = 0; k < runs.count; ++k) {
+                int q = column[static_cast<size_t>(live[k].state) * 256];
+                if (q == m_Dead || seen[q] == tick)
+                    continue;
+                seen[q] = tick;
+                live[count] = { q, live[k].start };
+                if (accepting[q] && start == SIZE_MAX)
+                    start = live[count].start;
+                ++count;
+            }
+            stats.run_steps += runs.count + 1;
+            int q = column[static_cast<size_t>(m_Start) * 256];
+            if (q != m_Dead && seen[q] != tick) {
+                live[count++] = { q, base + i };
+                if (accepting[q] && start == SIZE_MAX)
+                    start = base + i;
+            }
+            runs.count = count;
+            ++i;
+            if (start != SIZE_MAX) {
+                ++stats.matches;
+                on_match(start, base + i);
+            }
+        }
+    }
+
+    size_t Skip(const unsigned char* data, size_t from, size_t to) const
+    {
+#ifdef DFA_SIMD_X86
+        if (m_Kernel != KERNEL_SCALAR)
+            from = SkipAvx2(data, from, to);
+#endif
+        while (from < to && !m_Escape[data[from]])
+            ++from;
+        return from;
+    }
+
+#ifdef DFA_SIMD_X86
+    // Byte-set membership for 32 bytes at once: the set is a 16 x 16 bit
+    // table, low nibble selects the row (pshufb), bits 4..6 select the bit,
+    // bit 7 selects one of two tables
+    __attribute__((target("avx2")))
+    size_t SkipAvx2(const unsigned char* data, size_t from, size_t to) const
+    {
+        const __m256i low = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(m_Escape_low)));
+        const __m256i high = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(m_Escape_high)));
+        const __m256i bit = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+                                             1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+        const __m256i top = _mm256_set1_epi8(static_cast<char>(0x80));
+        const __m256i seven = _mm256_set1_epi8(7);
+        const __m256i zero = _mm256_setzero_si256();
+
+        for (; from + 32 <= to; from += 32) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + from));
+            // pshufb gives 0 for indices with bit 7 set, so each table only
+            // answers for its own half of the bytes
+            __m256i row = _mm256_or_si256(_mm256_shuffle_epi8(low, v),
+                                          _mm256_shuffle_epi8(high, _mm256_xor_si256(v, top)));
+            __m256i mask = _mm256_shuffle_epi8(bit, _mm256_and_si256(_mm256_srli_epi16(v, 4), seven));
+            __m256i miss = _mm256_cmpeq_epi8(_mm256_and_si256(row, mask), zero);
+            uint32_t hits = ~static_cast<uint32_t>(_mm256_movemask_epi8(miss));
+            if (hits)
+                return from + __builtin_ctz(hits);
+        }
+        return from;
+    }
+#endif
+
+    int m_Kernel = KERNEL_SCALAR;
+    bool m_Prefilter = true;
+
+    std::vector<int> m_Table;               // 256 transitions per state of the DFA of L
+    std::vector<uint8_t> m_Accepting;
+    int m_Start = 0;
+    int m_Dead = 0;
+
+    static constexpr size_t MAX_TUPLES = 1 << 14;
+    bool m_Use_tuples = false;
+    uint8_t m_Class[256] = {};
+    int m_Classes = 0;
+    std::vector<Move> m_Moves;              // tuples x classes
+    std::vector<int> m_Sources;
+    std::vector<int> m_Tuple_size;          // live runs of every tuple
+    std::vector<int> m_Tuple_accept;        // first accepting slot or -1
+
+    bool m_Escape[256] = {};
+    uint8_t m_Escape_low[16] = {};          // bytes 0x00-0x7F: bit (b >> 4) of row (b & 15)
+    uint8_t m_Escape_high[16] = {};         // bytes 0x80-0xFF
+};
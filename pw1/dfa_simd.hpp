@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "dfa.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DFA_SIMD_X86 1
+#endif
+
+// SIMD kernel for small DFAs (up to 32 states): all 32 candidate states are
+// kept in one vector, one byte of input is one shuffle.
+// Вектор v хранит для каждого начального состояния q текущее состояние v[q];
+// шаг по символу a - это v[q] = delta(v[q], a), т.е. перестановка столбца
+// таблицы переходов по индексам v (pshufb / vpermb).
+enum SIMD_KERNEL {
+    KERNEL_SCALAR      = 0,
+    KERNEL_AVX2        = 1,
+    KERNEL_AVX512_VBMI = 2
+};
+
+inline const char* SimdKernelName(int kernel)
+{
+    switch (kernel) {
+        case KERNEL_AVX2:        return "avx2";
+        case KERNEL_AVX512_VBMI: return "avx512vbmi";
+        default:                 return "scalar";
+    }
+}
+
+// Best kernel supported by the running CPU
+inline int DetectSimdKernel()
+{
+#ifdef DFA_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512vbmi") && __builtin_cpu_supports("avx512vl"))
+        return KERNEL_AVX512_VBMI;
+    if (__builtin_cpu_supports("avx2"))
+        return KERNEL_AVX2;
+#endif
+    return KERNEL_SCALAR;
+}
+
+namespace dfa_simd {
+
+// Column a of the transition table: column[a][q] = delta(q, a), 32 bytes
+template <int States, int Alphabet>
+void BuildColumns(const Dfa<States, Alphabet>& dfa, uint8_t (&column)[Alphabet][32])
+{
+    for (int a = 0; a < Alphabet; ++a)
+        for (int q = 0; q < 32; ++q)
+            column[a][q] = static_cast<uint8_t>(q < States ? dfa.Next(q, a) : q);
+}
+
+#ifdef DFA_SIMD_X86
+
+template <int States, int Alphabet>
+__attribute__((target("avx2")))
+bool RunAvx2(const Dfa<States, Alphabet>& dfa, const char* first, const char* last, uint8_t (&out)[32])
+{
+    uint8_t column[Alphabet][32];
+    BuildColumns(dfa, column);
+
+    // pshufb works inside 128-bit lanes: both halves of the column are
+    // broadcast to the two lanes and the result is selected by bit 4 of v
+    __m256i lo[Alphabet], hi[Alphabet];
+    for (int a = 0; a < Alphabet; ++a) {
+        lo[a] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(column[a])));
+        hi[a] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(column[a] + 16)));
+    }
+
+    __m256i v = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+                                 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31);
+    for (; first != last; ++first) {
+        int a = dfa.SymbolIndex(*first);
+        if (a < 0)
+            return false;
+        __m256i from_lo = _mm256_shuffle_epi8(lo[a], v);
+        if (States > 16) {
+            __m256i from_hi = _mm256_shuffle_epi8(hi[a], v);
+            v = _mm256_blendv_epi8(from_lo, from_hi, _mm256_slli_epi16(v, 3));
+        } else {
+            v = from_lo;
+        }
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), v);
+    return true;
+}
+
+template <int States, int Alphabet>
+__attribute__((target("avx512vbmi,avx512vl")))
+bool RunAvx512(const Dfa<States, Alphabet>& dfa, const char* first, const char* last, uint8_t (&out)[32])
+{
+    uint8_t column[Alphabet][32];
+    BuildColumns(dfa, column);
+
+    __m256i table[Alphabet];
+    for (int a = 0; a < Alphabet; ++a)
+        table[a] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column[a]));
+
+    __m256i v = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+                                 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31);
+    for (; first != last; ++first) {
+        int a = dfa.SymbolIndex(*first);
+        if (a < 0)
+            return false;
+        // maskz form with a full mask: same vpermb, but no undefined source
+        // operand (gcc 12 warns on _mm256_permutexvar_epi8)
+        v = _mm256_maskz_permutexvar_epi8(static_cast<__mmask32>(-1), v, table[a]);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), v);
+    return true;
+}
+
+#endif
+
+} // namespace dfa_simd
+
+// Same result as Dfa::RunFromAll(), computed with the given kernel
+template <int States, int Alphabet>
+void RunFromAllSimd(const Dfa<States, Alphabet>& dfa, const char* first, const char* last,
+                    typename Dfa<States, Alphabet>::StateMap& map, int kernel)
+{
+    static_assert(States <= 32, "RunFromAllSimd: the DFA must have at most 32 states");
+
+#ifdef DFA_SIMD_X86
+    if (kernel != KERNEL_SCALAR) {
+        uint8_t out[32];
+        bool ok = (kernel == KERNEL_AVX512_VBMI) ? dfa_simd::RunAvx512(dfa, first, last, out)
+                                                 : dfa_simd::RunAvx2(dfa, first, last, out);
+        for (int q = 0; q < States; ++q)
+            map[q] = ok ? out[q] : Dfa<States, Alphabet>::UNKNOWN_SYMBOL;
+        return;
+    }
+#endif
+    dfa.RunFromAll(first, last, map);
+}
+
+// RunFromAll() with the best kernel available (SIMD for DFAs up to 32 states)
+template <int States, int Alphabet>
+void RunFromAllFast(const Dfa<States, Alphabet>& dfa, const char* first, const char* last,
+                    typename Dfa<States, Alphabet>::StateMap& map)
+{
+    if constexpr (States <= 32) {
+        static const int kernel = DetectSimdKernel();
+        RunFromAllSimd(dfa, first, last, map, kernel);
+    } else {
+        dfa.RunFromAll(first, last, map);
+    }
+}
@@ -1,8 +1,11 @@
 #include <iostream>
 #include <vector>
 #include <array>
-#include <stack>
-#include <unordered_set>
+#include <cstdio>
+#include <cstring>
+
+#include "lazy_dfa.hpp"
+#include "nfa.hpp"
 
 enum RESULT
 {
@@ -27,67 +30,26 @@ std::array<int, ACCEPTED_STATES> g_Accepted_states{q1, q2};
 // The set Sigma (a - 0, b - 1)
 std::array<char, ALPHABET_CHARCTERS> g_Alphabet{'a', 'b'};
 
-// Transition functions
-// (сначала пустой со всеми возможными переходами, потом будем его заполнять)
-std::vector<int> g_Transitions[TOTAL_STATES][ALPHABET_CHARCTERS];
-std::vector<int> g_Epsilon[TOTAL_STATES];
+// Transition functions, ε-transitions and the set of start states
+// (состояния хранятся битовыми масками, см. nfa.hpp)
+BitNfa g_NFA(TOTAL_STATES, std::string(g_Alphabet.begin(), g_Alphabet.end()));
 
 // Current states 
 // (может быть несколько из-за NFA)
-std::unordered_set<int> g_CurrentStates;
+NfaRunner g_CurrentStates(g_NFA);
 
 // Symbol transition function
 void AddSymbolTransition(int from, char symbol, int to)
 {
-    int idx = (symbol == 'a') ? 0 : 1;
-    g_Transitions[from][idx].push_back(to);
+    g_NFA.AddTransition(from, symbol, to);
 }
 
 // Epsilon transition function
+// (ε-замыкания состояний вычисляются один раз в BuildENFA, шаг только
+// объединяет готовые замыкания)
 void AddEpsilonTransition(int from, int to)
 {
-    g_Epsilon[from].push_back(to);
-}
-
-// Computing ε-closure of set os States
-// Нужно для того, чтобы вычислить все доступные состояния из состояний в S, 
-// в которые можно попасть с помощью ε-перехода - ε-замыкание
-std::unordered_set<int> EpsilonClosure(const std::unordered_set<int> &S)
-{
-    std::unordered_set<int> closure = S;
-    std::stack<int> st;
-    for (int s : S)
-        st.push(s);
-
-    while (!st.empty())
-    {
-        int v = st.top();
-        st.pop();
-        for (int nxt : g_Epsilon[v])
-        {
-            if (!closure.count(nxt))
-            {
-                closure.insert(nxt);
-                st.push(nxt);
-            }
-        }
-    }
-    return closure;
-}
-
-// Checking for states in Accepted_states
-// (по условию NFA нужно, чтобы хотя бы одно состояние из текущих было принимающим)
-bool IsAccepting(const std::unordered_set<int> &states)
-{
-    for (int s : states)
-    {
-        for (int acc : g_Accepted_states)
-        {
-            if (s == acc)
-                return true;
-        }
-    }
-    return false;
+    g_NFA.AddEpsilon(from, to);
 }
 
 void BuildENFA()
@@ -97,67 +59,72 @@ void BuildENFA()
     AddSymbolTransition(q1, 'a', q1);
     AddSymbolTransition(q2, 'b', q2);
     AddSymbolTransition(q2, 'a', q1);
+
+    g_NFA.AddStart(q0);
+    for (int st : g_Accepted_states)
+        g_NFA.SetAccepting(st);
+
+    g_NFA.ComputeClosures();
 }
 
 int ENFA_Step(char current_symbol)
 {
-    int symbol_index = -1;
-
-    for (char symbol : g_Alphabet) {
-        if (symbol == current_symbol) {
-            symbol_index = (symbol == 'a') ? 0 : 1;
-        }
-    }
-
-    if (symbol_index == -1)
-    {
-        g_CurrentStates.clear();
+    if (!g_CurrentStates.Step(current_symbol))
         return UNKNOWN_SYMBOL_ERR;
-    }
 
-    std::unordered_set<int> nextStates;
-    for (int s : g_CurrentStates)
+    if (g_CurrentStates.IsAccepting())
+        return REACHED_FINAL_STATE;
+    return NOT_REACHED_FINAL_STATE;
+}
+
+// Bulk mode: the ε-NFA is turned into a plain NFA, every line of the file is
+// classified by the DFA lazily built from it, cache statistics go to stderr
+int RunBulk(const char *path)
+{
+    FILE *in = (std::strcmp(path, "-") == 0) ? stdin : std::fopen(path, "rb");
+    if (!in)
     {
-        for (int tgt : g_Transitions[s][symbol_index])
-        {
-            nextStates.insert(tgt);
-        }
+        std::perror(path);
+        return 1;
     }
 
-    nextStates = EpsilonClosure(nextStates);
+    BitNfa nfa = g_NFA.RemoveEpsilon();
+    LazyDfa dfa(nfa);
+    ClassifyLines(dfa, in, stdout);
 
-    g_CurrentStates = std::move(nextStates);
+    LazyDfa::Stats stats = dfa.GetStats();
+    std::fprintf(stderr, "DFA cache: %zu states (%zu bytes), %llu interned, hit rate %.6f, %llu misses, %llu flushes\n",
+                 stats.states, stats.bytes, (unsigned long long)stats.interned, stats.HitRate(),
+                 (unsigned long long)stats.misses, (unsigned long long)stats.flushes);
 
-    if (IsAccepting(g_CurrentStates))
-        return REACHED_FINAL_STATE;
-    return NOT_REACHED_FINAL_STATE;
+    if (in != stdin)
+        std::fclose(in);
+    return 0;
 }
 
 int main(int argc, char *argv[])
 {
 
     BuildENFA();
+    g_CurrentStates.Reset();
 
-    g_CurrentStates.clear();
-    g_CurrentStates.insert(q0);
-    g_CurrentStates = EpsilonClosure(g_CurrentStates);
+    if (argc > 1)
+        return RunBulk(argv[1]);
 
     std::cout << "Enter a string with 'a's and 'b's:\nPress Enter Key to stop\n";
 
     char ch;
-    int result = IsAccepting(g_CurrentStates) ? REACHED_FINAL_STATE : NOT_REACHED_FINAL_STATE;
+    int result = g_CurrentStates.IsAccepting() ? REACHED_FINAL_STATE : NOT_REACHED_FINAL_STATE;
 
     while (std::cin.get(ch) && ch != '\n')
     {
         result = ENFA_Step(ch);
-        if (result == UNKNOWN_SYMBOL_ERR || g_CurrentStates.empty())
+        if (result == UNKNOWN_SYMBOL_ERR || g_CurrentStates.IsEmpty())
         {
             break;
         }
     }
 
-    bool accepted = IsAccepting(g_CurrentStates);
-
     if (result == REACHED_FINAL_STATE)
     {
         std::cout << "\nAccepted! The string belongs to the language b* a* ({a^n : n >= 1} U {b^m a^k : m,k >= 0}).\n";
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "../common/jff.hpp"
+#include "nfa.hpp"
+
+// Finite automaton (<type>fa</type>) from a .jff file as a BitNfa.
+// Пустой <read/> - ε-переход; метка из нескольких символов разворачивается
+// в цепочку промежуточных состояний. Алфавит - все символы из меток.
+inline bool BuildBitNfa(const JffDocument& doc, BitNfa& nfa, std::string* error = nullptr)
+{
+    if (doc.Type() != "fa") {
+        if (error)
+            *error = "not a finite automaton: <type>" + std::string(doc.Type()) + "</type>";
+        return false;
+    }
+
+    std::string alphabet;
+    int states = static_cast<int>(doc.States().size());
+    for (const auto& t : doc.Transitions()) {
+        std::string_view read = doc.Label(t, JFF_READ);
+        alphabet.append(read.begin(), read.end());
+        if (read.size() > 1)
+            states += static_cast<int>(read.size()) - 1;
+    }
+    std::sort(alphabet.begin(), alphabet.end());
+    alphabet.erase(std::unique(alphabet.begin(), alphabet.end()), alphabet.end());
+
+    nfa = BitNfa(states, alphabet);
+    int next_state = static_cast<int>(doc.States().size());
+    for (const auto& t : doc.Transitions()) {
+        std::string_view read = doc.Label(t, JFF_READ);
+        if (read.empty()) {
+            nfa.AddEpsilon(t.from, t.to);
+            continue;
+        }
+        int from = t.from;
+        for (size_t i = 0; i + 1 < read.size(); ++i) {
+            nfa.AddTransition(from, read[i], next_state);
+            from = next_state++;
+        }
+        nfa.AddTransition(from, read.back(), t.to);
+    }
+
+    for (size_t q = 0; q < doc.States().size(); ++q) {
+        if (doc.States()[q].initial)
+            nfa.AddStart(static_cast<int>(q));
+        if (doc.States()[q].final)
+            nfa.SetAccepting(static_cast<int>(q));
+    }
+    nfa.ComputeClosures();
+    return true;
+}
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "nfa.hpp"
+
+// On-the-fly subset construction over a BitNfa.
+// Каждое встреченное множество состояний НКА интернируется как состояние
+// ДКА, а его переходы запоминаются. Повторяющиеся входы идут со скоростью
+// ДКА (один lookup в таблице на символ). Если кэш превышает бюджет памяти,
+// он целиком сбрасывается, и построение продолжается с текущего состояния.
+class LazyDfa {
+public:
+    static constexpr int NOT_COMPUTED = -1;
+
+    struct Stats {
+        uint64_t hits = 0;      // transitions taken from the cache
+        uint64_t misses = 0;    // transitions computed by the NFA step
+        uint64_t flushes = 0;   // cache resets because of the memory budget
+        uint64_t interned = 0;  // states interned over the whole run
+        size_t states = 0;      // states currently in the cache
+        size_t bytes = 0;       // memory currently used by the cache
+
+        double HitRate() const
+        {
+            uint64_t total = hits + misses;
+            return total ? static_cast<double>(hits) / total : 0.0;
+        }
+    };
+
+    explicit LazyDfa(const BitNfa& nfa, size_t memory_budget = 16 << 20)
+        : m_Nfa(nfa), m_Words(nfa.Words()), m_Alphabet_size(nfa.AlphabetSize()),
+          m_Budget(memory_budget), m_Scratch(nfa.Words())
+    {
+        Flush();
+        m_Stats.flushes = 0;
+    }
+
+    const BitNfa& Nfa() const { return m_Nfa; }
+
+    int Start() const { return m_Start; }
+
+    // Number of DFA states currently in the cache
+    int States() const { return static_cast<int>(m_Flags.size()); }
+
+    int SymbolIndex(char symbol) const { return m_Nfa.SymbolIndex(symbol); }
+
+    bool IsAccepting(int state) const { return m_Flags[state] & FLAG_ACCEPTING; }
+
+    // The state is the empty set: no input can lead to acceptance
+    bool IsDead(int state) const { return m_Flags[state] & FLAG_DEAD; }
+
+    const uint64_t* StateSet(int state) const
+    {
+        return m_Sets.data() + static_cast<size_t>(state) * m_Words;
+    }
+
+    // Number of flushes so far: state ids from an older generation are invalid
+    uint64_t Generation() const { return m_Stats.flushes; }
+
+    int Next(int state, int symbol_index)
+    {
+        int next = m_Next[static_cast<size_t>(state) * m_Alphabet_size + symbol_index];
+        if (next != NOT_COMPUTED) {
+            ++m_Stats.hits;
+            return next;
+        }
+        return Compute(state, symbol_index);
+    }
+
+    // Runs [first, last) from the start state; false on symbols outside of Sigma
+    bool Accepts(const char* first, const char* last)
+    {
+        int state = m_Start;
+        for (; first != last; ++first) {
+            int symbol_index = m_Nfa.SymbolIndex(*first);
+            if (symbol_index < 0)
+                return false;
+            state = Next(state, symbol_index);
+        }
+        return IsAccepting(state);
+    }
+
+    Stats GetStats() const
+    {
+        Stats stats = m_Stats;
+        stats.states = m_Flags.size();
+        stats.bytes = MemoryUsed();
+        return stats;
+    }
+
+private:
+    enum STATE_FLAGS { FLAG_ACCEPTING = 1, FLAG_DEAD = 2 };
+
+    int Compute(int state, int symbol_index)
+    {
+        ++m_Stats.misses;
+        m_Nfa.Step(StateSet(state), symbol_index, m_Scratch.data());
+
+        int next = Find(m_Scratch.data());
+        if (next == NOT_COMPUTED) {
+            if (MemoryUsed() + StateBytes() > m_Budget) {
+                // The source set must survive the flush: it is re-interned first
+                std::vector<uint64_t> source(StateSet(state), StateSet(state) + m_Words);
+                Flush();
+                state = FindOrIntern(source.data());
+                next = FindOrIntern(m_Scratch.data());
+            } else {
+                next = Intern(m_Scratch.data());
+            }
+        }
+        m_Next[static_cast<size_t>(state) * m_Alphabet_size + symbol_index] = next;
+        return next;
+    }
+
+    void Flush()
+    {
+        ++m_Stats.flushes;
+        m_Sets.clear();
+        m_Next.clear();
+        m_Flags.clear();
+        m_Table.assign(1024, NOT_COMPUTED);
+
+        std::vector<uint64_t> start(m_Nfa.StartSet(), m_Nfa.StartSet() + m_Words);
+        m_Nfa.Closure(start.data());
+        m_Start = Intern(start.data());
+    }
+
+    uint64_t Hash(const uint64_t* set) const
+    {
+        uint64_t h = 0x9E3779B97F4A7C15ull;
+        for (int w = 0; w < m_Words; ++w) {
+            h ^= set[w];
+            h *= 0xFF51AFD7ED558CCDull;
+            h ^= h >> 32;
+        }
+        return h;
+    }
+
+    // Open addressing over state ids, NOT_COMPUTED marks a free slot
+    int Find(const uint64_t* set) const
+    {
+        size_t mask = m_Table.size() - 1;
+        for (size_t slot = Hash(set) & mask;; slot = (slot + 1) & mask) {
+            int id = m_Table[slot];
+            if (id == NOT_COMPUTED)
+                return NOT_COMPUTED;
+            if (std::memcmp(StateSet(id), set, sizeof(uint64_t) * m_Words) == 0)
+                return id;
+        }
+    }
+
+    int FindOrIntern(const uint64_t* set)
+    {
+        int id = Find(set);
+        return id != NOT_COMPUTED ? id : Intern(set);
+    }
+
+    int Intern(const uint64_t* set)
+    {
+        int id = static_cast<int>(m_Flags.size());
+        m_Sets.insert(m_Sets.end(), set, set + m_Words);
+        m_Next.insert(m_Next.end(), m_Alphabet_size, NOT_COMPUTED);
+        m_Flags.push_back((m_Nfa.IsAccepting(set) ? FLAG_ACCEPTING : 0) |
+                          (m_Nfa.IsEmpty(set) ? FLAG_DEAD : 0));
+        ++m_Stats.interned;
+
+        if (m_Flags.size() * 2 > m_Table.size())
+            Rehash();
+        else
+            Insert(id);
+        return id;
+    }
+
+    void Insert(int id)
+    {
+        size_t mask = m_Table.size() - 1;
+        size_t slot = Hash(StateSet(id)) & mask;
+        while (m_Table[slot] != NOT_COMPUTED)
+            slot = (slot + 1) & mask;
+        m_Table[slot] = id;
+    }
+
+    void Rehash()
+    {
+        m_Table.assign(m_Table.size() * 2, NOT_COMPUTED);
+        for (int id = 0; id < static_cast<int>(m_Flags.size()); ++id)
+            Insert(id);
+    }
+
+    size_t StateBytes() const
+    {
+        return sizeof(uint64_t) * m_Words + sizeof(int) * (m_Alphabet_size + 2) + 1;
+    }
+
+    size_t MemoryUsed() const
+    {
+        return m_Flags.size() * StateBytes() + m_Table.size() * sizeof(int);
+    }
+
+    const BitNfa& m_Nfa;
+    int m_Words;
+    int m_Alphabet_size;
+    size_t m_Budget;
+
+    int m_Start = 0;
+    std::vector<uint64_t> m_Sets;   // state sets, m_Words per DFA state
+    std::vector<int> m_Next;        // memoized transitions, m_Alphabet_size per DFA state
+    std::vector<uint8_t> m_Flags;   // STATE_FLAGS per DFA state
+    std::vector<int> m_Table;       // hash table: set -> DFA state
+    std::vector<uint64_t> m_Scratch;
+    Stats m_Stats;
+};
+
+// Bulk mode shared by the NFA programs: every line of `in` is a separate
+// input string, one verdict per line ('1' - accepted, '0' - rejected)
+inline void ClassifyLines(LazyDfa& dfa, FILE* in, FILE* out)
+{
+    std::vector<char> block(1 << 20);
+    std::vector<char> verdicts;
+    verdicts.reserve(block.size());
+
+    int state = dfa.Start();
+    bool bad_symbol = false;
+    bool line_open = false;
+
+    size_t got;
+    while ((got = std::fread(block.data(), 1, block.size(), in)) > 0) {
+        for (size_t i = 0; i < got; ++i) {
+            char ch = block[i];
+            if (ch == '\n') {
+                bool accepted = !bad_symbol && dfa.IsAccepting(state);
+                verdicts.push_back(accepted ? '1' : '0');
+                verdicts.push_back('\n');
+                state = dfa.Start();
+                bad_symbol = false;
+                line_open = false;
+                continue;
+            }
+            line_open = true;
+            if (bad_symbol || ch == '\r')
+                continue;
+            int symbol_index = dfa.SymbolIndex(ch);
+            if (symbol_index < 0) {
+                bad_symbol = true;
+                continue;
+            }
+            state = dfa.Next(state, symbol_index);
+        }
+        std::fwrite(verdicts.data(), 1, verdicts.size(), out);
+        verdicts.clear();
+    }
+
+    if (line_open) {
+        bool accepted = !bad_symbol && dfa.IsAccepting(state);
+        std::fputs(accepted ? "1\n" : "0\n", out);
+    }
+}
@@ -1,8 +1,15 @@
 #include <iostream>
 #include <vector>
 #include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
 #include <unordered_set>
 
+#include "lazy_dfa.hpp"
+#include "nfa.hpp"
+
 enum RESULT
 {
     UNKNOWN_SYMBOL_ERR = 0,
@@ -26,34 +33,18 @@ std::array<int, ACCEPTED_STATES> g_Accepted_states{q0, q1};
 // The set Sigma (a - 0, b - 1)
 std::array<char, ALPHABET_CHARCTERS> g_Alphabet{'a', 'b'};
 
-// Transition functions
-// (сначала пустой со всеми возможными переходами, потом будем его заполнять)
-std::vector<int> g_Transitions[TOTAL_STATES][ALPHABET_CHARCTERS];
+// Transition functions and the set of start states
+// (состояния хранятся битовыми масками, см. nfa.hpp)
+BitNfa g_NFA(TOTAL_STATES, std::string(g_Alphabet.begin(), g_Alphabet.end()));
 
 // Current states 
 // (может быть несколько из-за NFA)
-std::unordered_set<int> g_CurrentStates{q0};
+NfaRunner g_CurrentStates(g_NFA);
 
 // Symbol transition function
 void AddSymbolTransition(int from, char symbol, int to)
 {
-    int idx = (symbol == 'a') ? 0 : 1;
-    g_Transitions[from][idx].push_back(to);
-}
-
-// Checking for states in Accepted_states
-// (по условию NFA нужно, чтобы хотя бы одно состояние из текущих было принимающим)
-bool IsAccepting(const std::unordered_set<int> &states)
-{
-    for (int s : states)
-    {
-        for (int acc : g_Accepted_states)
-        {
-            if (s == acc)
-                return true;
-        }
-    }
-    return false;
+    g_NFA.AddTransition(from, symbol, to);
 }
 
 void BuildNFA()
@@ -65,38 +56,160 @@ void BuildNFA()
     AddSymbolTransition(q1, 'b', q2);
     AddSymbolTransition(q2, 'a', q2);
     AddSymbolTransition(q2, 'b', q2);
+
+    g_NFA.AddStart(q0);
+    for (int st : g_Accepted_states)
+        g_NFA.SetAccepting(st);
+    g_CurrentStates.Reset();
 }
 
 int NFA_Step(char current_symbol)
 {
-    int symbol_index = -1;
+    if (!g_CurrentStates.Step(current_symbol))
+        return UNKNOWN_SYMBOL_ERR;
 
-    for (char symbol : g_Alphabet) {
-        if (symbol == current_symbol) {
-            symbol_index = (symbol == 'a') ? 0 : 1;
-        }
+    if (g_CurrentStates.IsAccepting())
+        return REACHED_FINAL_STATE;
+    return NOT_REACHED_FINAL_STATE;
+}
+
+// Bulk mode: every line of the file is classified by the lazily built DFA,
+// cache statistics go to stderr
+int RunBulk(const char *path)
+{
+    FILE *in = (std::strcmp(path, "-") == 0) ? stdin : std::fopen(path, "rb");
+    if (!in)
+    {
+        std::perror(path);
+        return 1;
     }
 
-    if (symbol_index == -1)
-    {   
-        g_CurrentStates = {};
-        return UNKNOWN_SYMBOL_ERR;
+    LazyDfa dfa(g_NFA);
+    ClassifyLines(dfa, in, stdout);
+
+    LazyDfa::Stats stats = dfa.GetStats();
+    std::fprintf(stderr, "DFA cache: %zu states (%zu bytes), %llu interned, hit rate %.6f, %llu misses, %llu flushes\n",
+                 stats.states, stats.bytes, (unsigned long long)stats.interned, stats.HitRate(),
+                 (unsigned long long)stats.misses, (unsigned long long)stats.flushes);
+
+    if (in != stdin)
+        std::fclose(in);
+    return 0;
+}
+
+// Previous NFA representation (lists of successors and std::unordered_set
+// of current states), kept as the baseline for the benchmark
+struct SetNFA
+{
+    int total_states;
+    std::vector<int> accepted_states;
+    std::vector<std::array<std::vector<int>, ALPHABET_CHARCTERS>> transitions;
+    std::unordered_set<int> current_states;
+
+    bool IsAccepting(const std::unordered_set<int> &states) const
+    {
+        for (int s : states)
+        {
+            for (int acc : accepted_states)
+            {
+                if (s == acc)
+                    return true;
+            }
+        }
+        return false;
     }
 
-    std::unordered_set<int> nextStates;
-    for (int s : g_CurrentStates)
+    int Step(char current_symbol)
     {
-        for (int tgt : g_Transitions[s][symbol_index])
+        int symbol_index = -1;
+
+        for (char symbol : g_Alphabet) {
+            if (symbol == current_symbol) {
+                symbol_index = (symbol == 'a') ? 0 : 1;
+            }
+        }
+
+        if (symbol_index == -1)
         {
-            nextStates.insert(tgt);
+            current_states = {};
+            return UNKNOWN_SYMBOL_ERR;
         }
+
+        std::unordered_set<int> nextStates;
+        for (int s : current_states)
+        {
+            for (int tgt : transitions[s][symbol_index])
+            {
+                nextStates.insert(tgt);
+            }
+        }
+
+        current_states = std::move(nextStates);
+
+        if (IsAccepting(current_states))
+            return REACHED_FINAL_STATE;
+        return NOT_REACHED_FINAL_STATE;
     }
+};
 
-    g_CurrentStates = std::move(nextStates);
+// Benchmark: BitNfa against SetNFA on random NFAs with 3, 64, 512 and 4096
+// states (2 random successors per state and symbol, every 8th state accepting)
+int RunBenchmark()
+{
+    const int sizes[] = { 3, 64, 512, 4096 };
+    std::mt19937 rng(42);
 
-    if (IsAccepting(g_CurrentStates))
-        return REACHED_FINAL_STATE;
-    return NOT_REACHED_FINAL_STATE;
+    for (int n : sizes)
+    {
+        SetNFA reference{ n, {}, std::vector<std::array<std::vector<int>, ALPHABET_CHARCTERS>>(n), {} };
+        BitNfa nfa(n, std::string(g_Alphabet.begin(), g_Alphabet.end()));
+
+        for (int q = 0; q < n; ++q)
+        {
+            for (int a = 0; a < ALPHABET_CHARCTERS; ++a)
+            {
+                for (int k = 0; k < 2; ++k)
+                {
+                    int to = (int)(rng() % n);
+                    reference.transitions[q][a].push_back(to);
+                    nfa.AddTransitionByIndex(q, a, to);
+                }
+            }
+            if (q % 8 == n % 8)
+            {
+                reference.accepted_states.push_back(q);
+                nfa.SetAccepting(q);
+            }
+        }
+        nfa.AddStart(0);
+
+        size_t length = std::min<size_t>(1 << 20, (1 << 22) / n);
+        std::string input(length, 'a');
+        for (char &ch : input)
+            ch = g_Alphabet[rng() % ALPHABET_CHARCTERS];
+
+        long long ref_sum = 0, bit_sum = 0;
+
+        auto begin = std::chrono::steady_clock::now();
+        reference.current_states = {0};
+        for (char ch : input)
+            ref_sum += reference.Step(ch);
+        double t_ref = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+        begin = std::chrono::steady_clock::now();
+        NfaRunner runner(nfa);
+        for (char ch : input)
+        {
+            runner.Step(ch);
+            bit_sum += runner.IsAccepting() ? REACHED_FINAL_STATE : NOT_REACHED_FINAL_STATE;
+        }
+        double t_bit = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+        std::printf("%5d states, %8zu symbols:  unordered_set: %10.3f Msym/s   bitset: %10.3f Msym/s   speedup: %7.2fx  %s\n",
+                    n, length, length / t_ref / 1e6, length / t_bit / 1e6, t_ref / t_bit,
+                    ref_sum == bit_sum ? "ok" : "MISMATCH");
+    }
+    return 0;
 }
 
 int main(int argc, char *argv[])
@@ -104,21 +217,26 @@ int main(int argc, char *argv[])
 
     BuildNFA();
 
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0)
+        return RunBenchmark();
+
+    if (argc > 1)
+        return RunBulk(argv[1]);
+
     std::cout << "Enter a string with 'a's and 'b's:\nPress Enter Key to stop\n";
     char ch;
-    int result = IsAccepting(g_CurrentStates) ? REACHED_FINAL_STATE : NOT_REACHED_FINAL_STATE;
+    int result = g_CurrentStates.IsAccepting() ? REACHED_FINAL_STATE : NOT_REACHED_FINAL_STATE;
 
     while (std::cin.get(ch) && ch != '\n')
     {
         result = NFA_Step(ch);
 
-        if (result == UNKNOWN_SYMBOL_ERR || g_CurrentStates.empty())
+        if (result == UNKNOWN_SYMBOL_ERR || g_CurrentStates.IsEmpty())
         {
             break;
         }
     }
 
-    bool accepted = IsAccepting(g_CurrentStates);
     if (result == REACHED_FINAL_STATE)
     {
         std::cout << "\nAccepted! The string belongs to the language b* a* ({a^n : n >= 1} U {b^m a^k : m,k >= 0}).\n";
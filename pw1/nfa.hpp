@@ -0,0 +1,341 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Bit-parallel NFA.
+// Множество состояний - битовый вектор из Words() 64-битных слов (размер
+// фиксируется при построении автомата). Для каждой пары (состояние, символ)
+// заранее хранится маска последователей, поэтому шаг - это OR масок
+// активных состояний, без выделения памяти. ε-переходы (если есть)
+// учитываются замыканием после каждого шага; замыкания отдельных состояний
+// вычисляются заранее (ComputeClosures) или убираются совсем (RemoveEpsilon).
+class BitNfa {
+public:
+    static constexpr int UNKNOWN_SYMBOL = -1;
+
+    BitNfa() = default;
+
+    BitNfa(int states, const std::string& alphabet)
+        : m_States(states), m_Words((states + 63) / 64), m_Alphabet(alphabet)
+    {
+        m_Symbol_Class.fill(-1);
+        for (size_t i = 0; i < alphabet.size(); ++i)
+            m_Symbol_Class[static_cast<unsigned char>(alphabet[i])] = static_cast<int>(i);
+
+        m_Successors.assign(static_cast<size_t>(m_States) * alphabet.size() * m_Words, 0);
+        m_Epsilon.assign(static_cast<size_t>(m_States) * m_Words, 0);
+        m_Start.assign(m_Words, 0);
+        m_Accepted.assign(m_Words, 0);
+    }
+
+    int States() const { return m_States; }
+    int Words() const { return m_Words; }
+    int AlphabetSize() const { return static_cast<int>(m_Alphabet.size()); }
+    const std::string& Alphabet() const { return m_Alphabet; }
+
+    // Index of the symbol in Sigma, -1 if the symbol is not in Sigma
+    int SymbolIndex(char symbol) const
+    {
+        return m_Symbol_Class[static_cast<unsigned char>(symbol)];
+    }
+
+    void AddTransition(int from, char symbol, int to)
+    {
+        AddTransitionByIndex(from, SymbolIndex(symbol), to);
+    }
+
+    void AddTransitionByIndex(int from, int symbol_index, int to)
+    {
+        SetBit(Row(from, symbol_index), to);
+    }
+
+    void AddEpsilon(int from, int to)
+    {
+        SetBit(m_Epsilon.data() + static_cast<size_t>(from) * m_Words, to);
+        m_Has_Epsilon = true;
+        m_Closures.clear();
+    }
+
+    bool HasEpsilon() const { return m_Has_Epsilon; }
+
+    void AddStart(int state) { SetBit(m_Start.data(), state); }
+    void SetAccepting(int state) { SetBit(m_Accepted.data(), state); }
+
+    const uint64_t* StartSet() const { return m_Start.data(); }
+    const uint64_t* AcceptingSet() const { return m_Accepted.data(); }
+
+    // Successor mask of `state` by symbol number `symbol_index`
+    // (masks are stored symbol-major, so a step reads one contiguous block)
+    const uint64_t* Successors(int state, int symbol_index) const
+    {
+        return m_Successors.data() + (static_cast<size_t>(symbol_index) * m_States + state) * m_Words;
+    }
+
+    // Precomputes the ε-closure of every state; call after the last AddEpsilon().
+    // ε-граф сжимается по компонентам сильной связности (Тарьян), замыкания
+    // компонент считаются в обратном топологическом порядке как битовые маски.
+    void ComputeClosures()
+    {
+        m_Closures.assign(static_cast<size_t>(m_States) * m_Words, 0);
+        if (!m_Has_Epsilon) {
+            for (int q = 0; q < m_States; ++q)
+                SetBit(ClosureRow(q), q);
+            return;
+        }
+
+        std::vector<int> index(m_States, -1), low(m_States, 0), component(m_States, -1);
+        std::vector<int> scc_stack, call_stack, edge_pos(m_States, 0);
+        std::vector<uint64_t> scc_closure(m_Words);
+        int counter = 0;
+
+        for (int root = 0; root < m_States; ++root) {
+            if (index[root] >= 0)
+                continue;
+            call_stack.push_back(root);
+            while (!call_stack.empty()) {
+                int v = call_stack.back();
+                if (index[v] < 0) {
+                    index[v] = low[v] = counter++;
+                    scc_stack.push_back(v);
+                }
+                // Next ε-successor of v that has not been examined yet
+                const uint64_t* row = EpsilonRow(v);
+                int w = -1;
+                for (int& pos = edge_pos[v]; (pos = NextBit(row, pos)) < m_States; ++pos) {
+                    if (index[pos] < 0) {
+                        w = pos++;
+                        break;
+                    }
+                    if (component[pos] < 0)
+                        low[v] = std::min(low[v], index[pos]);
+                }
+                if (w >= 0) {
+                    call_stack.push_back(w);
+                    continue;
+                }
+
+                call_stack.pop_back();
+                if (!call_stack.empty())
+                    low[call_stack.back()] = std::min(low[call_stack.back()], low[v]);
+                if (low[v] != index[v])
+                    continue;
+
+                // v is the root of an SCC; all SCCs it reaches are already closed
+                std::fill(scc_closure.begin(), scc_closure.end(), 0);
+                size_t first = scc_stack.size();
+                do {
+                    --first;
+                } while (scc_stack[first] != v);
+                for (size_t i = first; i < scc_stack.size(); ++i) {
+                    int q = scc_stack[i];
+                    component[q] = v;
+                    SetBit(scc_closure.data(), q);
+                }
+                for (size_t i = first; i < scc_stack.size(); ++i) {
+                    const uint64_t* eps = EpsilonRow(scc_stack[i]);
+                    for (int t = NextBit(eps, 0); t < m_States; t = NextBit(eps, t + 1))
+                        if (component[t] != v)
+                            OrInto(scc_closure.data(), ClosureRow(t));
+                }
+                for (size_t i = first; i < scc_stack.size(); ++i)
+                    std::memcpy(ClosureRow(scc_stack[i]), scc_closure.data(), sizeof(uint64_t) * m_Words);
+                scc_stack.resize(first);
+            }
+        }
+    }
+
+    // ε-closure of a single state (after ComputeClosures())
+    const uint64_t* StateClosure(int state) const
+    {
+        return m_Closures.data() + static_cast<size_t>(state) * m_Words;
+    }
+
+    // Extends `set` with everything reachable by ε-transitions (in place).
+    // With precomputed closures this is a union of StateClosure(q) for q in set.
+    void Closure(uint64_t* set) const
+    {
+        if (!m_Has_Epsilon)
+            return;
+        if (!m_Closures.empty()) {
+            for (int w = 0; w < m_Words; ++w) {
+                uint64_t bits = set[w];
+                while (bits) {
+                    int q = w * 64 + __builtin_ctzll(bits);
+                    bits &= bits - 1;
+                    OrInto(set, StateClosure(q));
+                }
+            }
+            return;
+        }
+
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (int w = 0; w < m_Words; ++w) {
+                uint64_t bits = set[w];
+                while (bits) {
+                    int q = w * 64 + __builtin_ctzll(bits);
+                    bits &= bits - 1;
+                    const uint64_t* row = EpsilonRow(q);
+                    for (int i = 0; i < m_Words; ++i) {
+                        uint64_t added = row[i] & ~set[i];
+                        if (added) {
+                            set[i] |= added;
+                            changed = true;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // ε-elimination: an equivalent NFA without ε-transitions. Successor masks
+    // and the start set are replaced by their ε-closures, so every reachable
+    // set is already closed and a step is a plain union of masks.
+    BitNfa RemoveEpsilon() const
+    {
+        BitNfa nfa(*this);
+        if (!m_Has_Epsilon)
+            return nfa;
+        if (nfa.m_Closures.empty())
+            nfa.ComputeClosures();
+
+        for (int a = 0; a < AlphabetSize(); ++a)
+            for (int q = 0; q < m_States; ++q)
+                nfa.Closure(nfa.Row(q, a));
+        nfa.Closure(nfa.m_Start.data());
+
+        std::fill(nfa.m_Epsilon.begin(), nfa.m_Epsilon.end(), 0);
+        nfa.m_Has_Epsilon = false;
+        nfa.m_Closures.clear();
+        return nfa;
+    }
+
+    // next = ε-closure of the union of Successors(q, symbol_index) for q in current
+    void Step(const uint64_t* current, int symbol_index, uint64_t* next) const
+    {
+        std::memset(next, 0, sizeof(uint64_t) * m_Words);
+        for (int w = 0; w < m_Words; ++w) {
+            uint64_t bits = current[w];
+            while (bits) {
+                int q = w * 64 + __builtin_ctzll(bits);
+                bits &= bits - 1;
+                const uint64_t* row = Successors(q, symbol_index);
+                for (int i = 0; i < m_Words; ++i)
+                    next[i] |= row[i];
+            }
+        }
+        if (m_Has_Epsilon)
+            Closure(next);
+    }
+
+    bool IsAccepting(const uint64_t* set) const
+    {
+        for (int w = 0; w < m_Words; ++w)
+            if (set[w] & m_Accepted[w])
+                return true;
+        return false;
+    }
+
+    bool IsEmpty(const uint64_t* set) const
+    {
+        for (int w = 0; w < m_Words; ++w)
+            if (set[w])
+                return false;
+        return true;
+    }
+
+private:
+    uint64_t* Row(int state, int symbol_index)
+    {
+        return m_Successors.data() + (static_cast<size_t>(symbol_index) * m_States + state) * m_Words;
+    }
+
+    uint64_t* ClosureRow(int state)
+    {
+        return m_Closures.data() + static_cast<size_t>(state) * m_Words;
+    }
+
+    const uint64_t* EpsilonRow(int state) const
+    {
+        return m_Epsilon.data() + static_cast<size_t>(state) * m_Words;
+    }
+
+    // First state >= from in the set, m_States if there is none
+    int NextBit(const uint64_t* set, int from) const
+    {
+        for (int w = from / 64; w < m_Words; ++w) {
+            uint64_t bits = set[w];
+            if (w == from / 64)
+                bits &= ~uint64_t(0) << (from % 64);
+            if (bits)
+                return w * 64 + __builtin_ctzll(bits);
+        }
+        return m_States;
+    }
+
+    void OrInto(uint64_t* set, const uint64_t* other) const
+    {
+        for (int i = 0; i < m_Words; ++i)
+            set[i] |= other[i];
+    }
+
+    static void SetBit(uint64_t* set, int state)
+    {
+        set[state / 64] |= uint64_t(1) << (state % 64);
+    }
+
+    int m_States = 0;
+    int m_Words = 0;
+    std::string m_Alphabet;
+    std::array<int, 256> m_Symbol_Class {};
+    std::vector<uint64_t> m_Successors;
+    std::vector<uint64_t> m_Epsilon;
+    bool m_Has_Epsilon = false;
+    std::vector<uint64_t> m_Closures;   // ε-closure of every state (ComputeClosures)
+    std::vector<uint64_t> m_Start;
+    std::vector<uint64_t> m_Accepted;
+};
+
+// Current and next state sets for running a BitNfa, allocated once
+class NfaRunner {
+public:
+    explicit NfaRunner(const BitNfa& nfa)
+        : m_Nfa(nfa), m_Current(nfa.Words()), m_Next(nfa.Words())
+    {
+        Reset();
+    }
+
+    void Reset()
+    {
+        std::memcpy(m_Current.data(), m_Nfa.StartSet(), sizeof(uint64_t) * m_Current.size());
+        m_Nfa.Closure(m_Current.data());
+    }
+
+    // Returns false if the symbol is not in Sigma (the set becomes empty)
+    bool Step(char symbol)
+    {
+        int symbol_index = m_Nfa.SymbolIndex(symbol);
+        if (symbol_index < 0) {
+            std::fill(m_Current.begin(), m_Current.end(), 0);
+            return false;
+        }
+        m_Nfa.Step(m_Current.data(), symbol_index, m_Next.data());
+        m_Current.swap(m_Next);
+        return true;
+    }
+
+    bool IsAccepting() const { return m_Nfa.IsAccepting(m_Current.data()); }
+    bool IsEmpty() const { return m_Nfa.IsEmpty(m_Current.data()); }
+    const uint64_t* Current() const { return m_Current.data(); }
+
+private:
+    const BitNfa& m_Nfa;
+    std::vector<uint64_t> m_Current;
+    std::vector<uint64_t> m_Next;
+};
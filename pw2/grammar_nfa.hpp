@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../common/jff.hpp"
+#include "../pw1/nfa.hpp"
+
+// Regular grammar (<type>grammar</type>) from a .jff file as a BitNfa.
+//
+// Как в JFLAP: нетерминалы - заглавные латинские буквы, начальный символ -
+// левая часть первого правила, пустая правая часть - ε. Праволинейная
+// грамматика (A -> wB | w): состояние на каждый нетерминал и одно
+// заключительное, A -> wB - цепочка переходов по w из A в B. Леволинейная
+// (A -> Bw | w): состояние на каждый нетерминал и одно начальное, A -> Bw -
+// цепочка по w из B в A, принимает состояние начального символа.
+// Промежуточные состояния цепочек добавляются для правил с |w| > 1.
+
+enum GRAMMAR_KIND {
+    GRAMMAR_RIGHT_LINEAR = 0,
+    GRAMMAR_LEFT_LINEAR  = 1
+};
+
+inline bool IsGrammarVariable(char ch) { return ch >= 'A' && ch <= 'Z'; }
+
+inline bool BuildGrammarNfa(const JffDocument& doc, BitNfa& nfa, std::string* error = nullptr,
+                            int* kind = nullptr)
+{
+    auto fail = [error](const std::string& message) {
+        if (error)
+            *error = message;
+        return false;
+    };
+
+    if (doc.Type() != "grammar")
+        return fail("not a grammar: <type>" + std::string(doc.Type()) + "</type>");
+    if (doc.Productions().empty())
+        return fail("no productions");
+
+    // Variable of every production side, the shape of the grammar, Sigma
+    bool right_ok = true, left_ok = true;
+    std::string alphabet;
+    int variable_state[26];
+    std::fill(variable_state, variable_state + 26, -1);
+    int variables = 0;
+
+    for (const auto& p : doc.Productions()) {
+        std::string_view left = doc.Text(p.left);
+        std::string_view right = doc.Text(p.right);
+        if (left.size() != 1 || !IsGrammarVariable(left[0]))
+            return fail("not a regular grammar: left side \"" + std::string(left) + "\"");
+
+        int count = 0;
+        for (size_t i = 0; i < right.size(); ++i) {
+            if (IsGrammarVariable(right[i])) {
+                ++count;
+                right_ok = right_ok && i + 1 == right.size();
+                left_ok = left_ok && i == 0;
+            } else {
+                alphabet += right[i];
+            }
+        }
+        if (count > 1)
+            right_ok = left_ok = false;
+        if (!right_ok && !left_ok)
+            return fail("not a regular grammar: " + std::string(left) + " -> " + std::string(right));
+    }
+
+    for (const auto& p : doc.Productions()) {
+        char variables_of[2] = { doc.Text(p.left)[0], 0 };
+        std::string_view right = doc.Text(p.right);
+        if (!right.empty())
+            variables_of[1] = right_ok ? right.back() : right.front();
+        for (char v : variables_of)
+            if (IsGrammarVariable(v) && variable_state[v - 'A'] < 0)
+                variable_state[v - 'A'] = variables++;
+    }
+
+    std::sort(alphabet.begin(), alphabet.end());
+    alphabet.erase(std::unique(alphabet.begin(), alphabet.end()), alphabet.end());
+
+    // Variables, the extra (final or initial) state, intermediate chain states
+    int extra = variables;
+    int states = variables + 1;
+    for (const auto& p : doc.Productions()) {
+        std::string_view right = doc.Text(p.right);
+        int terminals = static_cast<int>(right.size());
+        if (!right.empty() && IsGrammarVariable(right_ok ? right.back() : right.front()))
+            --terminals;
+        if (terminals > 1)
+            states += terminals - 1;
+    }
+
+    nfa = BitNfa(states, alphabet);
+    int next_state = variables + 1;
+    auto chain = [&nfa, &next_state](int from, std::string_view word, int to) {
+        if (word.empty()) {
+            nfa.AddEpsilon(from, to);
+            return;
+        }
+        for (size_t i = 0; i + 1 < word.size(); ++i) {
+            nfa.AddTransition(from, word[i], next_state);
+            from = next_state++;
+        }
+        nfa.AddTransition(from, word.back(), to);
+    };
+
+    int start = variable_state[doc.Text(doc.Productions()[0].left)[0] - 'A'];
+    for (const auto& p : doc.Productions()) {
+        int head = variable_state[doc.Text(p.left)[0] - 'A'];
+        std::string_view right = doc.Text(p.right);
+        if (right_ok) {
+            bool tail = !right.empty() && IsGrammarVariable(right.back());
+            int to = tail ? variable_state[right.back() - 'A'] : extra;
+            chain(head, tail ? right.substr(0, right.size() - 1) : right, to);
+        } else {
+            bool front = !right.empty() && IsGrammarVariable(right.front());
+            int from = front ? variable_state[right.front() - 'A'] : extra;
+            chain(from, front ? right.substr(1) : right, head);
+        }
+    }
+
+    if (right_ok) {
+        nfa.AddStart(start);
+        nfa.SetAccepting(extra);
+    } else {
+        nfa.AddStart(extra);
+        nfa.SetAccepting(start);
+    }
+    nfa.ComputeClosures();
+
+    if (kind)
+        *kind = right_ok ? GRAMMAR_RIGHT_LINEAR : GRAMMAR_LEFT_LINEAR;
+    return true;
+}
@@ -0,0 +1,204 @@
+// Many regular expressions, one pass over every record.
+//
+//   multi <patterns> [input]   - `patterns` has one expression per line (JFLAP
+//                                syntax, see regex.hpp); for every line of `input`
+//                                (stdin by default) prints the numbers of the
+//                                matching expressions or `-`
+//   multi --bench              - 10, 100 and 1000 patterns against one DFA and
+//                                against running every pattern separately
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../common/record_reader.hpp"
+#include "multi_regex.hpp"
+
+int Run(const char *patterns_path, const char *input)
+{
+    RecordReader patterns;
+    std::string error;
+    if (!patterns.Open(patterns_path, &error))
+    {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    MultiRegex multi;
+    std::string_view line;
+    while (patterns.Next(line))
+    {
+        if (multi.Add(std::string(line), &error) < 0)
+        {
+            std::fprintf(stderr, "%s:%zu: %s\n", patterns_path, patterns.Records(), error.c_str());
+            return 1;
+        }
+    }
+    multi.Compile();
+
+    RecordReader in;
+    if (!in.Open(input ? input : "-", &error))
+    {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    std::string out;
+    while (in.Next(line))
+    {
+        auto matches = multi.Matches(multi.Run(line.data(), line.data() + line.size()));
+        if (matches.first == matches.second)
+            out += '-';
+        for (const int *id = matches.first; id != matches.second; ++id)
+        {
+            if (id != matches.first)
+                out += ' ';
+            out += std::to_string(*id);
+        }
+        out += '\n';
+        if (out.size() > (1 << 16))
+        {
+            std::fwrite(out.data(), 1, out.size(), stdout);
+            out.clear();
+        }
+    }
+    std::fwrite(out.data(), 1, out.size(), stdout);
+
+    LazyDfa::Stats stats = multi.Dfa().GetStats();
+    std::fprintf(stderr, "%d patterns, NFA %d states, DFA cache %zu states, hit rate %.6f, %llu flushes\n",
+                 multi.Patterns(), multi.Nfa().States(), stats.states, stats.HitRate(),
+                 (unsigned long long)stats.flushes);
+    return 0;
+}
+
+// Expressions shaped like pw2/RE.jff: (x+y)*z(u+v)* with random literals
+std::string RandomLiteral(std::mt19937 &rng)
+{
+    std::string literal;
+    int length = 1 + (int)(rng() % 3);
+    for (int i = 0; i < length; ++i)
+        literal += "01ab"[rng() % 4];
+    return literal;
+}
+
+std::string RandomPattern(std::mt19937 &rng)
+{
+    return "(" + RandomLiteral(rng) + "+" + RandomLiteral(rng) + ")*" + RandomLiteral(rng) + RandomLiteral(rng) +
+           "(" + RandomLiteral(rng) + "+" + RandomLiteral(rng) + ")*";
+}
+
+void Benchmark(int count, const std::vector<std::string> &records, size_t bytes)
+{
+    std::mt19937 rng(count);
+    std::vector<std::string> patterns(count);
+    for (auto &pattern : patterns)
+        pattern = RandomPattern(rng);
+
+    // One automaton for all patterns
+    MultiRegex multi;
+    for (const auto &pattern : patterns)
+        multi.Add(pattern);
+    multi.Compile(64 << 20);
+
+    // The first pass builds the DFA, the second one runs on the warm cache
+    double combined[2];
+    uint64_t combined_matches = 0;
+    for (double &seconds : combined)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        combined_matches = 0;
+        for (const auto &record : records)
+        {
+            auto matches = multi.Matches(multi.Run(record.data(), record.data() + record.size()));
+            combined_matches += matches.second - matches.first;
+        }
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    }
+    LazyDfa::Stats stats = multi.Dfa().GetStats();
+
+    // Every pattern separately: one lazy DFA and one pass per pattern
+    // (on a part of the records, so that 1000 passes take reasonable time)
+    std::vector<std::unique_ptr<BitNfa>> nfas;
+    std::vector<std::unique_ptr<LazyDfa>> dfas;
+    for (const auto &pattern : patterns)
+    {
+        Regex re;
+        re.Parse(pattern);
+        nfas.emplace_back(new BitNfa(BuildGlushkov(re, "01ab")));
+        dfas.emplace_back(new LazyDfa(*nfas.back()));
+    }
+
+    size_t sample = std::min(records.size(), records.size() * 10 / count);
+    size_t sample_bytes = 0;
+    auto begin = std::chrono::steady_clock::now();
+    uint64_t separate_matches = 0;
+    for (size_t r = 0; r < sample; ++r)
+    {
+        const std::string &record = records[r];
+        for (auto &dfa : dfas)
+            separate_matches += dfa->Accepts(record.data(), record.data() + record.size());
+        sample_bytes += record.size() + 1;
+    }
+    double separate = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    uint64_t expected = 0;
+    for (size_t r = 0; r < sample; ++r)
+    {
+        auto matches = multi.Matches(multi.Run(records[r].data(), records[r].data() + records[r].size()));
+        expected += matches.second - matches.first;
+    }
+
+    // A single pattern for reference
+    begin = std::chrono::steady_clock::now();
+    uint64_t single_matches = 0;
+    for (const auto &record : records)
+        single_matches += dfas[0]->Accepts(record.data(), record.data() + record.size());
+    double single = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    double mb = bytes / 1e6;
+    std::printf("%5d patterns: combined %7.1f MB/s, warm %7.1f MB/s (%6zu DFA states, hit rate %.6f, %llu flushes) | "
+                "separate %7.2f MB/s | single pattern %7.1f MB/s (%llu matches) | %llu matches %s\n",
+                count, mb / combined[0], mb / combined[1], stats.states, stats.HitRate(),
+                (unsigned long long)stats.flushes, sample_bytes / 1e6 / separate, mb / single,
+                (unsigned long long)single_matches, (unsigned long long)combined_matches,
+                expected == separate_matches ? "ok" : "MISMATCH");
+}
+
+int RunBenchmark()
+{
+    std::mt19937 rng(5);
+    std::vector<std::string> records(1 << 20);
+    size_t bytes = 0;
+    for (auto &record : records)
+    {
+        int length = 8 + (int)(rng() % 25);
+        for (int i = 0; i < length; ++i)
+            record += "01ab"[rng() % 4];
+        bytes += record.size() + 1;
+    }
+    std::printf("%zu records, %.1f MB\n", records.size(), bytes / 1e6);
+
+    Benchmark(10, records, bytes);
+    Benchmark(100, records, bytes);
+    Benchmark(1000, records, bytes);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0)
+        return RunBenchmark();
+
+    if (argc < 2)
+    {
+        std::cout << "Usage: multi <patterns> [input] | multi --bench\n";
+        return 1;
+    }
+    return Run(argv[1], argc > 2 ? argv[2] : nullptr);
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../pw1/lazy_dfa.hpp"
+#include "regex.hpp"
+
+// Many regular expressions matched in one pass over every record.
+//
+// Автоматы Глушкова всех выражений объединяются в один НКА с общим начальным
+// состоянием 0; каждое остальное состояние помечено номером выражения, которому
+// принадлежит его позиция. ДКА по подмножествам строится лениво (LazyDfa), так
+// что на символ приходится один переход, как у одного ДКА. Списки номеров для
+// принимающих состояний ДКА вычисляются при первом обращении и запоминаются.
+class MultiRegex {
+public:
+    MultiRegex() = default;
+    MultiRegex(const MultiRegex&) = delete;
+    MultiRegex& operator=(const MultiRegex&) = delete;
+
+    // Pattern id (0, 1, ...) or -1 with `error` set
+    int Add(const std::string& expression, std::string* error = nullptr)
+    {
+        Regex re;
+        if (!re.Parse(expression, error))
+            return -1;
+        m_Patterns.push_back(ComputeGlushkov(re));
+        return static_cast<int>(m_Patterns.size()) - 1;
+    }
+
+    int Patterns() const { return static_cast<int>(m_Patterns.size()); }
+
+    // Builds the combined NFA over the union of all pattern alphabets.
+    // `memory_budget` bounds the lazy DFA cache (see LazyDfa)
+    void Compile(size_t memory_budget = 16 << 20)
+    {
+        std::string alphabet;
+        int states = 1;
+        for (const auto& sets : m_Patterns) {
+            alphabet.append(sets.symbol.begin() + 1, sets.symbol.end());
+            states += sets.Positions();
+        }
+        std::sort(alphabet.begin(), alphabet.end());
+        alphabet.erase(std::unique(alphabet.begin(), alphabet.end()), alphabet.end());
+
+        m_Nfa = BitNfa(states, alphabet);
+        m_Owner.assign(states, -1);
+        m_Nullable.clear();
+
+        int offset = 0;
+        for (int id = 0; id < Patterns(); ++id) {
+            const GlushkovSets& sets = m_Patterns[id];
+            AddGlushkov(sets, m_Nfa, 0, offset);
+            std::fill(m_Owner.begin() + offset + 1, m_Owner.begin() + offset + 1 + sets.Positions(), id);
+            if (sets.nullable) {
+                m_Nullable.push_back(id);
+                m_Nfa.SetAccepting(0);
+            }
+            offset += sets.Positions();
+        }
+        m_Nfa.AddStart(0);
+
+        m_Dfa.reset(new LazyDfa(m_Nfa, memory_budget));
+        m_Generation = m_Dfa->Generation();
+        m_Match_first.clear();
+        m_Match_ids.clear();
+    }
+
+    // Explores every reachable DFA state up front (at most `max_states`);
+    // false if the automaton is larger, the rest is then built lazily.
+    // Кэш в этом режиме не ограничен по памяти
+    bool CompileAll(int max_states = std::numeric_limits<int>::max())
+    {
+        Compile(std::numeric_limits<size_t>::max());
+        LazyDfa& dfa = *m_Dfa;
+        for (int state = 0; state < dfa.States(); ++state) {
+            if (state >= max_states)
+                return false;
+            for (int a = 0; a < dfa.Nfa().AlphabetSize(); ++a)
+                dfa.Next(state, a);
+            if (dfa.IsAccepting(state))
+                Matches(state);
+        }
+        return true;
+    }
+
+    const BitNfa& Nfa() const { return m_Nfa; }
+    LazyDfa& Dfa() { return *m_Dfa; }
+
+    // Runs one record from the start state; the DFA state after it, or
+    // LazyDfa::NOT_COMPUTED if the record has a symbol outside of Sigma
+    int Run(const char* first, const char* last)
+    {
+        LazyDfa& dfa = *m_Dfa;
+        int state = dfa.Start();
+        for (; first != last; ++first) {
+            int symbol_index = dfa.SymbolIndex(*first);
+            if (symbol_index < 0)
+                return LazyDfa::NOT_COMPUTED;
+            state = dfa.Next(state, symbol_index);
+        }
+        return state;
+    }
+
+    // Ids of the patterns accepting in DFA `state`, in increasing order.
+    // Valid until the next Run / Next call (кэш ДКА может быть сброшен)
+    std::pair<const int*, const int*> Matches(int state)
+    {
+        if (m_Generation != m_Dfa->Generation()) {
+            m_Generation = m_Dfa->Generation();
+            m_Match_first.clear();
+            m_Match_ids.clear();
+        }
+        if (state < 0 || !m_Dfa->IsAccepting(state))
+            return { nullptr, nullptr };
+
+        if (static_cast<size_t>(state) >= m_Match_first.size())
+            m_Match_first.resize(m_Dfa->States(), NOT_LISTED);
+        if (m_Match_first[state] == NOT_LISTED)
+            m_Match_first[state] = List(state);
+
+        const int* list = m_Match_ids.data() + m_Match_first[state];
+        return { list + 1, list + 1 + list[0] };
+    }
+
+private:
+    static constexpr int NOT_LISTED = -1;
+
+    // Appends [count, id...] for `state` to m_Match_ids
+    int List(int state)
+    {
+        const uint64_t* set = m_Dfa->StateSet(state);
+        const uint64_t* accepting = m_Nfa.AcceptingSet();
+
+        int begin = static_cast<int>(m_Match_ids.size());
+        m_Match_ids.push_back(0);
+        if (set[0] & 1)
+            m_Match_ids.insert(m_Match_ids.end(), m_Nullable.begin(), m_Nullable.end());
+        int previous = -1;
+        for (int w = 0; w < m_Nfa.Words(); ++w) {
+            for (uint64_t bits = set[w] & accepting[w]; bits; bits &= bits - 1) {
+                int q = w * 64 + __builtin_ctzll(bits);
+                if (q != 0 && m_Owner[q] != previous)
+                    m_Match_ids.push_back(previous = m_Owner[q]);
+            }
+        }
+        std::sort(m_Match_ids.begin() + begin + 1, m_Match_ids.end());
+        auto end = std::unique(m_Match_ids.begin() + begin + 1, m_Match_ids.end());
+        m_Match_ids.erase(end, m_Match_ids.end());
+        m_Match_ids[begin] = static_cast<int>(m_Match_ids.size()) - begin - 1;
+        return begin;
+    }
+
+    std::vector<GlushkovSets> m_Patterns;
+    BitNfa m_Nfa;
+    std::vector<int> m_Owner;       // pattern id of every NFA state (-1 for state 0)
+    std::vector<int> m_Nullable;    // patterns that accept the empty string
+    std::unique_ptr<LazyDfa> m_Dfa;
+
+    uint64_t m_Generation = 0;
+    std::vector<int> m_Match_first; // offset in m_Match_ids per DFA state
+    std::vector<int> m_Match_ids;   // [count, id, id, ...] per listed DFA state
+};
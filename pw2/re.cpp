@@ -0,0 +1,245 @@
+// Regular expression from a JFLAP file (pw2/RE.jff) compiled into automata.
+//
+//   re                          - RE.jff, strings are entered from the keyboard
+//   re <file.jff> [input]       - expression from the file; with `input` every
+//                                 line of it is classified ('1' / '0')
+//   re -e <expression> [input]  - the same for an expression from the command line
+//   re --bench [patterns]       - compile throughput on random expressions
+//   re --test                   - long and deeply nested expressions
+
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../common/jff.hpp"
+#include "../pw1/lazy_dfa.hpp"
+#include "regex.hpp"
+
+bool LoadExpression(const char *path, std::string &expression)
+{
+    JffDocument doc;
+    std::string error;
+    if (!doc.Load(path, &error))
+    {
+        std::fprintf(stderr, "%s: %s\n", path, error.c_str());
+        return false;
+    }
+    if (doc.Type() != "re")
+    {
+        std::fprintf(stderr, "%s: not a regular expression: <type>%s</type>\n", path, std::string(doc.Type()).c_str());
+        return false;
+    }
+    expression = std::string(doc.Expression());
+    return true;
+}
+
+int Run(const std::string &expression, const char *input)
+{
+    Regex re;
+    std::string error;
+    if (!re.Parse(expression, &error))
+    {
+        std::fprintf(stderr, "%s: %s\n", expression.c_str(), error.c_str());
+        return 1;
+    }
+
+    BitNfa thompson = BuildThompson(re);
+    BitNfa glushkov = BuildGlushkov(re);
+    std::fprintf(stderr, "%s: Thompson eps-NFA %d states, Glushkov NFA %d states\n",
+                 expression.c_str(), thompson.States(), glushkov.States());
+
+    LazyDfa dfa(glushkov);
+    if (input)
+    {
+        FILE *in = (std::strcmp(input, "-") == 0) ? stdin : std::fopen(input, "rb");
+        if (!in)
+        {
+            std::perror(input);
+            return 1;
+        }
+        ClassifyLines(dfa, in, stdout);
+        if (in != stdin)
+            std::fclose(in);
+        return 0;
+    }
+
+    std::cout << "Enter a string over {" << re.Alphabet() << "}:\nPress Enter Key to stop\n";
+    std::string line;
+    std::getline(std::cin, line);
+    if (dfa.Accepts(line.data(), line.data() + line.size()))
+        std::cout << "\nAccepted! The string belongs to the language " << expression << ".\n";
+    else
+        std::cout << "\nRejected! The string does not belong to the language " << expression << ".\n";
+    return 0;
+}
+
+// Random expression with `symbols` symbol occurrences over "01ab"
+std::string RandomExpression(std::mt19937 &rng, int symbols)
+{
+    if (symbols <= 1)
+    {
+        std::string atom(1, "01ab"[rng() % 4]);
+        return (rng() % 4 == 0) ? atom + "*" : atom;
+    }
+    int left = 1 + (int)(rng() % (symbols - 1));
+    std::string a = RandomExpression(rng, left);
+    std::string b = RandomExpression(rng, symbols - left);
+    switch (rng() % 3)
+    {
+    case 0:
+        return "(" + a + "+" + b + ")";
+    case 1:
+        return a + b;
+    default:
+        return "(" + a + b + ")*";
+    }
+}
+
+bool SameLanguage(const BitNfa &a, const BitNfa &b, std::mt19937 &rng)
+{
+    NfaRunner ra(a), rb(b);
+    const std::string &sigma = a.Alphabet();
+    for (int t = 0; t < 50; ++t)
+    {
+        ra.Reset();
+        rb.Reset();
+        int length = (int)(rng() % 16);
+        for (int i = 0; i < length; ++i)
+        {
+            char ch = sigma[rng() % sigma.size()];
+            ra.Step(ch);
+            rb.Step(ch);
+        }
+        if (ra.IsAccepting() != rb.IsAccepting())
+            return false;
+    }
+    return true;
+}
+
+int RunBenchmark(int patterns)
+{
+    std::mt19937 rng(11);
+    std::vector<std::string> expressions(patterns);
+    size_t total_length = 0;
+    for (auto &expression : expressions)
+    {
+        expression = RandomExpression(rng, 8 + (int)(rng() % 33));
+        total_length += expression.size();
+    }
+    std::printf("%d random expressions, %.1f characters on average\n",
+                patterns, (double)total_length / patterns);
+
+    size_t states = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (const auto &expression : expressions)
+    {
+        Regex re;
+        re.Parse(expression);
+        states += BuildThompson(re, "01ab").States();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::printf("Thompson: %9.0f patterns/s, %5.1f states on average\n", patterns / seconds, (double)states / patterns);
+
+    states = 0;
+    begin = std::chrono::steady_clock::now();
+    for (const auto &expression : expressions)
+    {
+        Regex re;
+        re.Parse(expression);
+        states += BuildGlushkov(re, "01ab").States();
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::printf("Glushkov: %9.0f patterns/s, %5.1f states on average\n", patterns / seconds, (double)states / patterns);
+
+    // Both constructions must describe the same language
+    int mismatches = 0;
+    for (int i = 0; i < patterns && i < 1000; ++i)
+    {
+        Regex re;
+        re.Parse(expressions[i]);
+        if (!SameLanguage(BuildThompson(re, "01ab"), BuildGlushkov(re, "01ab"), rng))
+            ++mismatches;
+    }
+    std::printf("Thompson vs Glushkov: %s\n", mismatches ? "MISMATCH" : "ok");
+    return mismatches ? 1 : 0;
+}
+
+// Parser limits: long chains are parsed by loops, nesting up to
+// Regex::MAX_DEPTH is accepted, deeper nesting is an error (not a crash)
+int RunTests()
+{
+    auto repeat = [](const std::string &text, int count)
+    {
+        std::string result;
+        result.reserve(text.size() * count);
+        for (int i = 0; i < count; ++i)
+            result += text;
+        return result;
+    };
+    const int n = 300000;
+    const int deep = Regex::MAX_DEPTH;
+    struct Case
+    {
+        const char *name;
+        std::string expression;
+        bool parsed;
+        std::string word;      // checked by the Glushkov DFA when not empty
+        bool accepted;
+    };
+    const Case cases[] = {
+        { "300k symbols", std::string(n, 'a'), true, "", false },
+        { "300k +", repeat("a+", n) + "b", true, "", false },
+        { "300k *", "a" + std::string(n, '*'), true, "aaa", true },
+        { "nesting at the limit", std::string(deep, '(') + "ab" + std::string(deep, ')') + "*", true, "abab", true },
+        { "nesting over the limit", std::string(deep + 1, '(') + "a" + std::string(deep + 1, ')'), false, "", false },
+        { "100k nested parentheses", std::string(100000, '(') + "a" + std::string(100000, ')'), false, "", false },
+        { "100k unclosed parentheses", std::string(100000, '('), false, "", false },
+        { "unbalanced ')'", "(a))", false, "", false },
+    };
+
+    int failures = 0;
+    for (const auto &c : cases)
+    {
+        Regex re;
+        std::string error;
+        bool parsed = re.Parse(c.expression, &error);
+        bool ok = parsed == c.parsed;
+        if (ok && parsed && !c.word.empty())
+        {
+            LazyDfa dfa(BuildGlushkov(re));
+            ok = dfa.Accepts(c.word.data(), c.word.data() + c.word.size()) == c.accepted;
+        }
+        std::printf("%-28s %-8s %s%s\n", c.name, parsed ? "parsed" : "rejected",
+                    ok ? "ok" : "MISMATCH", parsed ? "" : (" (" + error + ")").c_str());
+        failures += !ok;
+    }
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0)
+        return RunBenchmark(argc > 2 ? std::atoi(argv[2]) : 100000);
+    if (argc > 1 && std::strcmp(argv[1], "--test") == 0)
+        return RunTests();
+
+    std::string expression;
+    const char *input = nullptr;
+    if (argc > 2 && std::strcmp(argv[1], "-e") == 0)
+    {
+        expression = argv[2];
+        input = argc > 3 ? argv[3] : nullptr;
+    }
+    else
+    {
+        if (!LoadExpression(argc > 1 ? argv[1] : "RE.jff", expression))
+            return 1;
+        input = argc > 2 ? argv[2] : nullptr;
+    }
+    return Run(expression, input);
+}
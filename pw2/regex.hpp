@@ -0,0 +1,347 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "../pw1/nfa.hpp"
+
+// Regular expressions in JFLAP syntax and their automata.
+//
+//      UNION  -> CONCAT { + CONCAT }
+//      CONCAT -> STAR { STAR }
+//      STAR   -> ATOM { * }
+//      ATOM   -> symbol | ! | ( UNION )
+//
+// `!` - пустая строка (λ в JFLAP), `+` - объединение, `*` - итерация.
+// Дерево разбора хранится в одном массиве узлов (ссылки - индексы).
+// Из него строятся ε-НКА Томпсона и позиционный автомат Глушкова (без
+// ε-переходов, состояний = число символов + 1); оба - BitNfa из pw1.
+// Рекурсия разбора идет только по скобкам, и их вложенность ограничена
+// Regex::MAX_DEPTH: более глубокое выражение отвергается с ошибкой, а не
+// переполняет стек. Построения автоматов идут циклом по узлам.
+
+enum REGEX_NODE {
+    RE_EMPTY  = 0,   // !  (the empty string)
+    RE_SYMBOL = 1,
+    RE_UNION  = 2,
+    RE_CONCAT = 3,
+    RE_STAR   = 4
+};
+
+struct RegexNode {
+    int kind = RE_EMPTY;
+    int left = -1;
+    int right = -1;
+    char symbol = 0;
+};
+
+class Regex {
+public:
+    static const int MAX_DEPTH = 10000;   // nested parentheses
+
+    bool Parse(const std::string& expression, std::string* error = nullptr)
+    {
+        m_Nodes.clear();
+        m_Text = expression;
+        m_Pos = 0;
+        m_Depth = 0;
+        m_Error.clear();
+
+        m_Root = Union();
+        if (m_Error.empty() && m_Pos != m_Text.size())
+            SetError("unexpected ')'");
+        if (!m_Error.empty()) {
+            if (error)
+                *error = m_Error;
+            return false;
+        }
+        return true;
+    }
+
+    const std::vector<RegexNode>& Nodes() const { return m_Nodes; }
+    int Root() const { return m_Root; }
+
+    // Sorted distinct symbols of the expression
+    std::string Alphabet() const
+    {
+        std::string alphabet;
+        for (const auto& node : m_Nodes)
+            if (node.kind == RE_SYMBOL)
+                alphabet += node.symbol;
+        std::sort(alphabet.begin(), alphabet.end());
+        alphabet.erase(std::unique(alphabet.begin(), alphabet.end()), alphabet.end());
+        return alphabet;
+    }
+
+    int Positions() const
+    {
+        int positions = 0;
+        for (const auto& node : m_Nodes)
+            positions += node.kind == RE_SYMBOL;
+        return positions;
+    }
+
+private:
+    int Union()
+    {
+        int left = Concat();
+        while (m_Error.empty() && Peek() == '+') {
+            ++m_Pos;
+            int right = Concat();
+            left = Add(RE_UNION, left, right);
+        }
+        return left;
+    }
+
+    int Concat()
+    {
+        int left = Star();
+        while (m_Error.empty() && m_Pos < m_Text.size() && Peek() != '+' && Peek() != ')') {
+            int right = Star();
+            left = Add(RE_CONCAT, left, right);
+        }
+        return left;
+    }
+
+    int Star()
+    {
+        int node = Atom();
+        while (m_Error.empty() && Peek() == '*') {
+            ++m_Pos;
+            node = Add(RE_STAR, node, -1);
+        }
+        return node;
+    }
+
+    int Atom()
+    {
+        if (m_Pos >= m_Text.size()) {
+            SetError("unexpected end of expression");
+            return -1;
+        }
+        char ch = m_Text[m_Pos++];
+        if (ch == '(') {
+            if (++m_Depth > MAX_DEPTH) {
+                --m_Pos;
+                SetError("parentheses nested deeper than " + std::to_string(MAX_DEPTH));
+                return -1;
+            }
+            int node = Union();
+            --m_Depth;
+            if (m_Error.empty() && Peek() != ')')
+                SetError("missing ')'");
+            ++m_Pos;
+            return node;
+        }
+        if (ch == '!')
+            return Add(RE_EMPTY, -1, -1);
+        if (ch == '+' || ch == '*' || ch == ')') {
+            --m_Pos;
+            SetError(std::string("unexpected '") + ch + "'");
+            return -1;
+        }
+        int node = Add(RE_SYMBOL, -1, -1);
+        m_Nodes[node].symbol = ch;
+        return node;
+    }
+
+    int Add(int kind, int left, int right)
+    {
+        RegexNode node;
+        node.kind = kind;
+        node.left = left;
+        node.right = right;
+        m_Nodes.push_back(node);
+        return static_cast<int>(m_Nodes.size()) - 1;
+    }
+
+    char Peek() const { return m_Pos < m_Text.size() ? m_Text[m_Pos] : '\0'; }
+
+    void SetError(const std::string& message)
+    {
+        if (m_Error.empty())
+            m_Error = message + " at position " + std::to_string(m_Pos);
+    }
+
+    std::vector<RegexNode> m_Nodes;
+    int m_Root = -1;
+    std::string m_Text;
+    size_t m_Pos = 0;
+    int m_Depth = 0;                      // open parentheses
+    std::string m_Error;
+};
+
+// Thompson construction: ε-NFA with one start and one accepting state.
+// Every node gets its own pair of states (entry, exit); `alphabet` may be
+// wider than the alphabet of the expression (общий алфавит нескольких выражений);
+// symbols outside of `alphabet` get no transitions.
+inline BitNfa BuildThompson(const Regex& re, const std::string& alphabet)
+{
+    const auto& nodes = re.Nodes();
+    int states = 2 * static_cast<int>(nodes.size());
+    BitNfa nfa(states, alphabet);
+
+    // Children are always created before their parent, so one pass in
+    // index order sees every subautomaton before it is used
+    for (int i = 0; i < static_cast<int>(nodes.size()); ++i) {
+        int entry = 2 * i, exit = 2 * i + 1;
+        const RegexNode& node = nodes[i];
+        switch (node.kind) {
+            case RE_EMPTY:
+                nfa.AddEpsilon(entry, exit);
+                break;
+            case RE_SYMBOL:
+                if (nfa.SymbolIndex(node.symbol) >= 0)
+                    nfa.AddTransition(entry, node.symbol, exit);
+                break;
+            case RE_UNION:
+                nfa.AddEpsilon(entry, 2 * node.left);
+                nfa.AddEpsilon(entry, 2 * node.right);
+                nfa.AddEpsilon(2 * node.left + 1, exit);
+                nfa.AddEpsilon(2 * node.right + 1, exit);
+                break;
+            case RE_CONCAT:
+                nfa.AddEpsilon(entry, 2 * node.left);
+                nfa.AddEpsilon(2 * node.left + 1, 2 * node.right);
+                nfa.AddEpsilon(2 * node.right + 1, exit);
+                break;
+            case RE_STAR:
+                nfa.AddEpsilon(entry, exit);
+                nfa.AddEpsilon(entry, 2 * node.left);
+                nfa.AddEpsilon(2 * node.left + 1, 2 * node.left);
+                nfa.AddEpsilon(2 * node.left + 1, exit);
+                break;
+        }
+    }
+
+    nfa.AddStart(2 * re.Root());
+    nfa.SetAccepting(2 * re.Root() + 1);
+    nfa.ComputeClosures();
+    return nfa;
+}
+
+inline BitNfa BuildThompson(const Regex& re)
+{
+    return BuildThompson(re, re.Alphabet());
+}
+
+// Position sets of the Glushkov construction. Позиции - вхождения символов
+// в выражение, нумеруются с 1 (symbol[0] не используется).
+struct GlushkovSets {
+    std::vector<char> symbol;
+    std::vector<int> first;
+    std::vector<int> last;
+    std::vector<std::vector<int>> follow;
+    bool nullable = false;
+
+    int Positions() const { return static_cast<int>(symbol.size()) - 1; }
+};
+
+inline GlushkovSets ComputeGlushkov(const Regex& re)
+{
+    const auto& nodes = re.Nodes();
+    size_t count = nodes.size();
+    GlushkovSets sets;
+
+    std::vector<int> position(count, 0);
+    sets.symbol.push_back(0);
+    for (size_t i = 0; i < count; ++i) {
+        if (nodes[i].kind == RE_SYMBOL) {
+            position[i] = static_cast<int>(sets.symbol.size());
+            sets.symbol.push_back(nodes[i].symbol);
+        }
+    }
+
+    // nullable / first / last per node (children precede parents)
+    std::vector<char> nullable(count, 0);
+    std::vector<std::vector<int>> first(count), last(count);
+    auto& follow = sets.follow;
+    follow.resize(sets.symbol.size());
+
+    auto merge = [](std::vector<int>& to, const std::vector<int>& from) {
+        to.insert(to.end(), from.begin(), from.end());
+    };
+
+    for (size_t i = 0; i < count; ++i) {
+        const RegexNode& node = nodes[i];
+        switch (node.kind) {
+            case RE_EMPTY:
+                nullable[i] = 1;
+                break;
+            case RE_SYMBOL:
+                first[i] = last[i] = { position[i] };
+                break;
+            case RE_UNION:
+                nullable[i] = nullable[node.left] || nullable[node.right];
+                first[i] = first[node.left];
+                merge(first[i], first[node.right]);
+                last[i] = last[node.left];
+                merge(last[i], last[node.right]);
+                break;
+            case RE_CONCAT:
+                nullable[i] = nullable[node.left] && nullable[node.right];
+                first[i] = first[node.left];
+                if (nullable[node.left])
+                    merge(first[i], first[node.right]);
+                last[i] = last[node.right];
+                if (nullable[node.right])
+                    merge(last[i], last[node.left]);
+                for (int p : last[node.left])
+                    merge(follow[p], first[node.right]);
+                break;
+            case RE_STAR:
+                nullable[i] = 1;
+                first[i] = first[node.left];
+                last[i] = last[node.left];
+                for (int p : last[node.left])
+                    merge(follow[p], first[node.left]);
+                break;
+        }
+    }
+
+    int root = re.Root();
+    sets.first = std::move(first[root]);
+    sets.last = std::move(last[root]);
+    sets.nullable = nullable[root];
+    return sets;
+}
+
+// Adds the positions of `sets` to `nfa`: position p becomes state offset + p,
+// `initial` is the state the first symbols are read from. Последние позиции
+// становятся принимающими; пустую строку (sets.nullable) учитывает вызывающий.
+inline void AddGlushkov(const GlushkovSets& sets, BitNfa& nfa, int initial, int offset)
+{
+    int positions = sets.Positions();
+    std::vector<int> index(positions + 1, -1);
+    for (int p = 1; p <= positions; ++p)
+        index[p] = nfa.SymbolIndex(sets.symbol[p]);
+
+    for (int q : sets.first)
+        if (index[q] >= 0)
+            nfa.AddTransitionByIndex(initial, index[q], offset + q);
+    for (int p = 1; p <= positions; ++p)
+        for (int q : sets.follow[p])
+            if (index[q] >= 0)
+                nfa.AddTransitionByIndex(offset + p, index[q], offset + q);
+    for (int p : sets.last)
+        nfa.SetAccepting(offset + p);
+}
+
+// Glushkov (position) automaton: state 0 is initial, state p (1..n) means
+// "the p-th symbol of the expression was just read". No ε-transitions.
+inline BitNfa BuildGlushkov(const Regex& re, const std::string& alphabet)
+{
+    GlushkovSets sets = ComputeGlushkov(re);
+    BitNfa nfa(sets.Positions() + 1, alphabet);
+    AddGlushkov(sets, nfa, 0, 0);
+    nfa.AddStart(0);
+    if (sets.nullable)
+        nfa.SetAccepting(0);
+    return nfa;
+}
+
+inline BitNfa BuildGlushkov(const Regex& re)
+{
+    return BuildGlushkov(re, re.Alphabet());
+}
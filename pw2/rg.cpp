@@ -0,0 +1,175 @@
+// Regular grammar from a JFLAP file (pw2/RG.jff) converted into an NFA.
+//
+//   rg                               - RG.jff, a string is entered from the keyboard
+//   rg <file.jff> [input]            - grammar from the file; with `input` every
+//                                      line of it is classified ('1' / '0')
+//   rg --corpus <corpus> <file.jff>...
+//                                    - checks every grammar against the corpus
+//                                      (lines "<1|0> <string>") and prints timings
+
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../common/record_reader.hpp"
+#include "../pw1/lazy_dfa.hpp"
+#include "grammar_nfa.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::time_point from)
+{
+    return std::chrono::duration<double>(Clock::now() - from).count();
+}
+
+bool LoadGrammar(const char *path, BitNfa &nfa, int *kind = nullptr)
+{
+    JffDocument doc;
+    std::string error;
+    if (!doc.Load(path, &error) || !BuildGrammarNfa(doc, nfa, &error, kind))
+    {
+        std::fprintf(stderr, "%s: %s\n", path, error.c_str());
+        return false;
+    }
+    return true;
+}
+
+int Run(const char *path, const char *input)
+{
+    BitNfa nfa;
+    int kind = GRAMMAR_RIGHT_LINEAR;
+    if (!LoadGrammar(path, nfa, &kind))
+        return 1;
+    std::fprintf(stderr, "%s: %s grammar, NFA %d states\n", path,
+                 kind == GRAMMAR_RIGHT_LINEAR ? "right-linear" : "left-linear", nfa.States());
+
+    LazyDfa dfa(nfa);
+    if (input)
+    {
+        FILE *in = (std::strcmp(input, "-") == 0) ? stdin : std::fopen(input, "rb");
+        if (!in)
+        {
+            std::perror(input);
+            return 1;
+        }
+        ClassifyLines(dfa, in, stdout);
+        if (in != stdin)
+            std::fclose(in);
+        return 0;
+    }
+
+    std::cout << "Enter a string over {" << nfa.Alphabet() << "}:\nPress Enter Key to stop\n";
+    std::string line;
+    std::getline(std::cin, line);
+    if (dfa.Accepts(line.data(), line.data() + line.size()))
+        std::cout << "\nAccepted! The string is generated by the grammar.\n";
+    else
+        std::cout << "\nRejected! The string is not generated by the grammar.\n";
+    return 0;
+}
+
+// Corpus check and throughput of the lazy DFA against the NFA simulation
+int RunCorpus(const char *corpus_path, char **grammars, int count)
+{
+    RecordReader corpus;
+    std::string error;
+    if (!corpus.Open(corpus_path, &error))
+    {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    std::vector<std::string> strings;
+    std::vector<bool> expected;
+    std::string_view line;
+    while (corpus.Next(line))
+    {
+        if (line.empty())
+            continue;
+        expected.push_back(line[0] == '1');
+        strings.emplace_back(line.substr(line.size() > 1 ? 2 : 1));
+    }
+
+    // 64 MB of random lines over the grammar alphabet for the throughput
+    std::mt19937 rng(14);
+    std::vector<std::string> lines;
+    size_t bytes = 0;
+
+    int status = 0;
+    for (int g = 0; g < count; ++g)
+    {
+        auto begin = Clock::now();
+        BitNfa nfa;
+        int kind = GRAMMAR_RIGHT_LINEAR;
+        if (!LoadGrammar(grammars[g], nfa, &kind))
+            return 1;
+        double load = Seconds(begin);
+
+        LazyDfa dfa(nfa);
+        int passed = 0;
+        begin = Clock::now();
+        for (size_t i = 0; i < strings.size(); ++i)
+        {
+            const std::string &s = strings[i];
+            if (dfa.Accepts(s.data(), s.data() + s.size()) == expected[i])
+                ++passed;
+            else
+                std::printf("  FAIL: \"%s\" expected %d\n", s.c_str(), (int)expected[i]);
+        }
+        double check = Seconds(begin);
+
+        if (lines.empty())
+        {
+            const std::string &sigma = nfa.Alphabet();
+            while (bytes < (64u << 20))
+            {
+                std::string s;
+                int length = (int)(rng() % 64);
+                for (int i = 0; i < length; ++i)
+                    s += sigma[rng() % sigma.size()];
+                bytes += s.size() + 1;
+                lines.push_back(std::move(s));
+            }
+        }
+
+        begin = Clock::now();
+        size_t accepted_dfa = 0;
+        for (const auto &s : lines)
+            accepted_dfa += dfa.Accepts(s.data(), s.data() + s.size());
+        double t_dfa = Seconds(begin);
+
+        NfaRunner runner(nfa);
+        begin = Clock::now();
+        size_t accepted_nfa = 0;
+        for (const auto &s : lines)
+        {
+            runner.Reset();
+            for (char ch : s)
+                runner.Step(ch);
+            accepted_nfa += runner.IsAccepting();
+        }
+        double t_nfa = Seconds(begin);
+
+        std::printf("%s: %s, NFA %d states, loaded and converted in %.3f ms\n", grammars[g],
+                    kind == GRAMMAR_RIGHT_LINEAR ? "right-linear" : "left-linear", nfa.States(), load * 1e3);
+        std::printf("  corpus: %d/%zu passed in %.3f ms\n", passed, strings.size(), check * 1e3);
+        std::printf("  64 MB of random lines: lazy DFA %8.1f MB/s (%d states), NFA simulation %8.1f MB/s  %s\n",
+                    bytes / t_dfa / (1 << 20), dfa.States(), bytes / t_nfa / (1 << 20),
+                    accepted_dfa == accepted_nfa ? "ok" : "MISMATCH");
+        if (passed != (int)strings.size() || accepted_dfa != accepted_nfa)
+            status = 1;
+    }
+    return status;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 3 && std::strcmp(argv[1], "--corpus") == 0)
+        return RunCorpus(argv[2], argv + 3, argc - 3);
+
+    return Run(argc > 1 ? argv[1] : "RG.jff", argc > 2 ? argv[2] : nullptr);
+}
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../common/grammar.hpp"
+#include "pda.hpp"
+
+// Grammar -> pushdown automaton (the JFLAP "LL" construction).
+// q0 кладет начальный символ грамматики над Z; в q1 переменная на вершине
+// заменяется правой частью любого своего правила (ε-шаг), терминал на вершине
+// снимается при чтении того же символа; снятие Z ведет в заключительное
+// состояние q2 с пустым стеком, поэтому автомат допускает и по заключительному
+// состоянию, и по пустому стеку. В стеке переменные - их имена, если имя из
+// одной буквы не занято терминалом, иначе свободные байты.
+inline bool GrammarToPda(const Grammar& grammar, Pda& pda, std::string* error = nullptr)
+{
+    bool used[256] = {};
+    used[static_cast<unsigned char>(Pda::BOTTOM)] = true;
+    for (const auto& p : grammar.Productions())
+        for (int symbol : p.right)
+            if (Grammar::IsTerminal(symbol)) {
+                if (symbol == Pda::BOTTOM) {
+                    if (error)
+                        *error = std::string("terminal ") + Pda::BOTTOM + " is the bottom of the stack";
+                    return false;
+                }
+                used[symbol] = true;
+            }
+
+    std::vector<char> stack_symbol(grammar.Variables(), 0);
+    int next_free = 1;
+    for (int v = 0; v < grammar.Variables(); ++v) {
+        const std::string& name = grammar.VariableName(Grammar::Variable(v));
+        int code = name.size() == 1 ? static_cast<unsigned char>(name[0]) : 0;
+        if (code == 0 || used[code]) {
+            while (next_free < 256 && used[next_free])
+                ++next_free;
+            if (next_free == 256) {
+                if (error)
+                    *error = "too many stack symbols";
+                return false;
+            }
+            code = next_free;
+        }
+        used[code] = true;
+        stack_symbol[v] = static_cast<char>(code);
+    }
+    auto symbol_of = [&](int symbol) {
+        return Grammar::IsTerminal(symbol) ? static_cast<char>(symbol) : stack_symbol[Grammar::VariableIndex(symbol)];
+    };
+
+    pda.Clear();
+    int start = pda.AddState();
+    int loop = pda.AddState();
+    int done = pda.AddState(true);
+    pda.SetStart(start);
+    pda.AddTransition(start, loop, "", std::string(1, Pda::BOTTOM),
+                      std::string(1, symbol_of(grammar.Start())) + Pda::BOTTOM);
+    bool terminal[256] = {};
+    for (const auto& p : grammar.Productions()) {
+        std::string push;
+        for (int symbol : p.right) {
+            push += symbol_of(symbol);
+            if (Grammar::IsTerminal(symbol))
+                terminal[symbol] = true;
+        }
+        pda.AddTransition(loop, loop, "", std::string(1, symbol_of(p.left)), push);
+    }
+    for (int t = 0; t < 256; ++t)
+        if (terminal[t])
+            pda.AddTransition(loop, loop, std::string(1, static_cast<char>(t)), std::string(1, static_cast<char>(t)), "");
+    pda.AddTransition(loop, done, "", std::string(1, Pda::BOTTOM), "");
+    return true;
+}
+
+// Pushdown automaton -> grammar (the triple construction).
+// Переменная [p X q] выводит то, что автомат читает, начиная в p с X на
+// вершине, до момента, когда X снят и автомат в q. Строится по элементарным
+// шагам Pda: ε и чтение сохраняют вершину, снятие Y дает [p Y r] -> ε,
+// положить Y: [p X q] -> [r Y s][s X q] для всех s. Под Z лежит условный
+// символ ⊥, который никогда не снимается: S -> [start Z r][r ⊥ END].
+// Допуск по заключительному состоянию - через состояние сброса: из каждого
+// заключительного состояния ε-переход в него, там снимается все до ⊥. Затем
+// непорождающие и недостижимые переменные удаляются.
+inline bool PdaToGrammar(const Pda& pda, int accept, Grammar& grammar, std::string* error = nullptr)
+{
+    // Stack symbols, ⊥ last
+    std::vector<int> gamma;
+    int gamma_of[256];
+    for (int c = 0; c < 256; ++c)
+        gamma_of[c] = -1;
+    auto add_symbol = [&](int c) {
+        if (gamma_of[c] < 0) {
+            gamma_of[c] = static_cast<int>(gamma.size());
+            gamma.push_back(c);
+        }
+    };
+    add_symbol(static_cast<unsigned char>(Pda::BOTTOM));
+    for (int q = 0; q < pda.States(); ++q)
+        for (const auto& op : pda.Ops(q))
+            if (op.kind == Pda::OP_POP || op.kind == Pda::OP_PUSH)
+                add_symbol(op.symbol);
+    const int G = static_cast<int>(gamma.size()) + 1;
+    const int under = G - 1;
+
+    const int drain = pda.States();
+    const int end = pda.States() + 1;
+    const int Q = pda.States() + 2;
+    if (static_cast<double>(Q) * Q * G > 4e6) {
+        if (error)
+            *error = "too many triples";
+        return false;
+    }
+    auto triple = [&](int p, int x, int q) { return Grammar::Variable(1 + (p * G + x) * Q + q); };
+    const int start_symbol = Grammar::Variable(0);
+
+    std::vector<Production> productions;
+    auto add = [&](int left, std::vector<int> right) {
+        Production p;
+        p.left = left;
+        p.right = std::move(right);
+        productions.push_back(std::move(p));
+    };
+
+    for (int r = 0; r < Q; ++r)
+        add(start_symbol, { triple(pda.Start(), gamma_of[static_cast<unsigned char>(Pda::BOTTOM)], r), triple(r, under, end) });
+    for (int p = 0; p < pda.States(); ++p) {
+        for (const auto& op : pda.Ops(p)) {
+            switch (op.kind) {
+            case Pda::OP_POP:
+                add(triple(p, gamma_of[op.symbol], op.to), {});
+                break;
+            case Pda::OP_PUSH:
+                for (int x = 0; x < G; ++x)
+                    for (int q = 0; q < Q; ++q)
+                        for (int s = 0; s < Q; ++s)
+                            add(triple(p, x, q), { triple(op.to, gamma_of[op.symbol], s), triple(s, x, q) });
+                break;
+            default:
+                for (int x = 0; x < G; ++x)
+                    for (int q = 0; q < Q; ++q) {
+                        if (op.kind == Pda::OP_READ)
+                            add(triple(p, x, q), { op.symbol, triple(op.to, x, q) });
+                        else
+                            add(triple(p, x, q), { triple(op.to, x, q) });
+                    }
+                break;
+            }
+        }
+        if (accept == PDA_EMPTY_STACK) {
+            add(triple(p, under, end), {});
+        } else if (pda.IsFinal(p)) {
+            for (int x = 0; x < G; ++x)
+                for (int q = 0; q < Q; ++q)
+                    add(triple(p, x, q), { triple(drain, x, q) });
+        }
+    }
+    if (accept != PDA_EMPTY_STACK) {
+        for (int x = 0; x < under; ++x)
+            add(triple(drain, x, drain), {});
+        add(triple(drain, under, end), {});
+    }
+
+    // Generating variables, then the ones reachable from the start
+    const int variables = 1 + Q * G * Q;
+    std::vector<bool> generating(variables, false);
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (const auto& p : productions) {
+            if (generating[Grammar::VariableIndex(p.left)])
+                continue;
+            bool all = true;
+            for (int symbol : p.right)
+                all = all && (Grammar::IsTerminal(symbol) || generating[Grammar::VariableIndex(symbol)]);
+            if (all) {
+                generating[Grammar::VariableIndex(p.left)] = true;
+                changed = true;
+            }
+        }
+    }
+    std::vector<std::vector<int>> by_left(variables);
+    for (size_t i = 0; i < productions.size(); ++i) {
+        bool useful = generating[Grammar::VariableIndex(productions[i].left)];
+        for (int symbol : productions[i].right)
+            useful = useful && (Grammar::IsTerminal(symbol) || generating[Grammar::VariableIndex(symbol)]);
+        if (useful)
+            by_left[Grammar::VariableIndex(productions[i].left)].push_back(static_cast<int>(i));
+    }
+    std::vector<int> renamed(variables, -1);
+    std::vector<int> queue = { 0 };
+    grammar = Grammar();
+    grammar.SetStart(grammar.AddVariable("S"));
+    renamed[0] = grammar.Start();
+    auto name = [&](int v) {
+        int t = v - 1;
+        int q = t % Q, x = t / Q % G, p = t / Q / G;
+        auto state = [&](int s) { return s == drain ? std::string("drain") : s == end ? std::string("end") : std::to_string(s); };
+        std::string symbol = x == under ? std::string("⊥") : std::string(1, static_cast<char>(gamma[x]));
+        return "[" + state(p) + " " + symbol + " " + state(q) + "]";
+    };
+    for (size_t k = 0; k < queue.size(); ++k)
+        for (int i : by_left[queue[k]])
+            for (int symbol : productions[i].right)
+                if (!Grammar::IsTerminal(symbol) && renamed[Grammar::VariableIndex(symbol)] < 0) {
+                    renamed[Grammar::VariableIndex(symbol)] = grammar.AddVariable(name(Grammar::VariableIndex(symbol)));
+                    queue.push_back(Grammar::VariableIndex(symbol));
+                }
+    for (int v : queue)
+        for (int i : by_left[v]) {
+            std::vector<int> right;
+            for (int symbol : productions[i].right)
+                right.push_back(Grammar::IsTerminal(symbol) ? symbol : renamed[Grammar::VariableIndex(symbol)]);
+            grammar.AddProduction(renamed[v], std::move(right));
+        }
+    return true;
+}
+
+// The source states and transitions of `pda` as a JFLAP file
+inline void WritePdaJff(const Pda& pda, FILE* out)
+{
+    auto escape = [](const std::string& text) {
+        std::string result;
+        for (char ch : text) {
+            if (ch == '<') result += "&lt;";
+            else if (ch == '>') result += "&gt;";
+            else if (ch == '&') result += "&amp;";
+            else result += ch;
+        }
+        return result;
+    };
+    auto label = [&](const char* tag, const std::string& text) {
+        if (text.empty())
+            std::fprintf(out, "\t\t\t<%s/>&#13;\n", tag);
+        else
+            std::fprintf(out, "\t\t\t<%s>%s</%s>&#13;\n", tag, escape(text).c_str(), tag);
+    };
+
+    std::fprintf(out, "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?><!--Generated.--><structure>&#13;\n");
+    std::fprintf(out, "\t<type>pda</type>&#13;\n\t<automaton>&#13;\n");
+    for (int q = 0; q < pda.NamedStates(); ++q) {
+        std::fprintf(out, "\t\t<state id=\"%d\" name=\"q%d\">&#13;\n\t\t\t<x>%d.0</x>&#13;\n\t\t\t<y>130.0</y>&#13;\n",
+                     q, q, 70 + 130 * q);
+        if (q == pda.Start())
+            std::fprintf(out, "\t\t\t<initial/>&#13;\n");
+        if (pda.IsFinal(q))
+            std::fprintf(out, "\t\t\t<final/>&#13;\n");
+        std::fprintf(out, "\t\t</state>&#13;\n");
+    }
+    for (const auto& t : pda.Transitions()) {
+        std::fprintf(out, "\t\t<transition>&#13;\n\t\t\t<from>%d</from>&#13;\n\t\t\t<to>%d</to>&#13;\n", t.from, t.to);
+        label("read", t.read);
+        label("pop", t.pop);
+        label("push", t.push);
+        std::fprintf(out, "\t\t</transition>&#13;\n");
+    }
+    std::fprintf(out, "\t</automaton>&#13;\n</structure>\n");
+}
@@ -0,0 +1,290 @@
+// Earley parser with a shared packed parse forest for any context-free
+// grammar (pw3/CFG.jff by default), and conversions between grammars and
+// pushdown automata.
+//
+//   earley                          - the grammar of this work, a line is
+//                                     entered from the keyboard
+//   earley <file.jff> [input]       - grammar (or pushdown automaton, converted
+//                                     to a grammar) from the file; with `input`
+//                                     every line of it is checked ('1' / '0')
+//   earley --sppf <file.jff> <word> - the forest of the word
+//   earley --to-pda <file.jff>      - the grammar as a JFLAP pushdown automaton
+//   earley --to-cfg <file.jff>      - productions of the grammar of a pushdown
+//                                     automaton
+//   earley --bench [file.jff]       - time and chart size on growing inputs,
+//                                     conversions checked on random words
+
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../common/record_reader.hpp"
+#include "convert.hpp"
+#include "earley.hpp"
+#include "../pw5/random_sentence.hpp"
+
+const char *DEFAULT_GRAMMAR = "CFG.jff";
+
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::time_point from)
+{
+    return std::chrono::duration<double>(Clock::now() - from).count();
+}
+
+// Grammar from a grammar file or from a pushdown automaton file
+bool LoadGrammar(const char *path, Grammar &grammar)
+{
+    JffDocument doc;
+    std::string error;
+    bool ok = doc.Load(path, &error);
+    if (ok && doc.Type() == "pda")
+    {
+        Pda pda;
+        ok = pda.Load(doc, &error) && PdaToGrammar(pda, PDA_FINAL_STATE, grammar, &error);
+    }
+    else if (ok)
+    {
+        ok = grammar.FromJff(doc, &error);
+    }
+    if (!ok)
+        std::fprintf(stderr, "%s: %s\n", path, error.c_str());
+    return ok;
+}
+
+bool LoadPda(const char *path, Pda &pda)
+{
+    JffDocument doc;
+    std::string error;
+    if (!doc.Load(path, &error) || !pda.Load(doc, &error))
+    {
+        std::fprintf(stderr, "%s: %s\n", path, error.c_str());
+        return false;
+    }
+    return true;
+}
+
+int PrintSppf(const char *path, const char *word)
+{
+    Grammar grammar;
+    if (!LoadGrammar(path, grammar))
+        return 1;
+    EarleyParser parser;
+    parser.Build(grammar);
+    if (!parser.Parse(word, word + std::strlen(word)))
+    {
+        std::printf("Rejected.\n");
+        return 0;
+    }
+    int root = parser.BuildSppf();
+    for (size_t n = 0; n < parser.Nodes().size(); ++n)
+    {
+        const SppfNode &node = parser.Nodes()[n];
+        if (node.first_packed < 0)
+            continue;
+        std::printf("%s%s\n", parser.NodeText(static_cast<int>(n)).c_str(), (int)n == root ? "  <- root" : "");
+        for (int p = node.first_packed; p >= 0; p = parser.Packed()[p].next)
+        {
+            const SppfPacked &packed = parser.Packed()[p];
+            std::printf("    %s, split at %d:", parser.ItemText(packed.item).c_str(), packed.pivot);
+            if (packed.left >= 0)
+                std::printf(" %s", parser.NodeText(packed.left).c_str());
+            std::printf(" %s\n", parser.NodeText(packed.right).c_str());
+        }
+    }
+    std::printf("%zu nodes, %zu packed nodes, %.0f parse tree(s)\n", parser.Nodes().size(), parser.Packed().size(),
+                parser.CountTrees(root));
+    return 0;
+}
+
+int ToPda(const char *path)
+{
+    Grammar grammar;
+    std::string error;
+    Pda pda;
+    if (!grammar.Load(path, &error) || !GrammarToPda(grammar, pda, &error))
+    {
+        std::fprintf(stderr, "%s: %s\n", path, error.c_str());
+        return 1;
+    }
+    WritePdaJff(pda, stdout);
+    return 0;
+}
+
+int ToCfg(const char *path)
+{
+    Grammar grammar;
+    if (!LoadGrammar(path, grammar))
+        return 1;
+    for (const Production &p : grammar.Productions())
+        std::printf("%s\n", grammar.ToString(p).c_str());
+    std::fprintf(stderr, "%d variables, %zu productions\n", grammar.Variables(), grammar.Productions().size());
+    return 0;
+}
+
+void BenchCase(const char *name, EarleyParser &parser, const std::string &input, bool forest)
+{
+    auto begin = Clock::now();
+    bool ok = parser.Parse(input.data(), input.data() + input.size());
+    double seconds = Seconds(begin);
+    std::printf("%-14s n=%-8zu %-8s %9.3f ms (%6.2f MB/s), %5.1f items/char, %6zu Leo items, chart %8.1f KB (peak %8.1f KB)",
+                name, input.size(), ok ? "accepted" : "rejected", seconds * 1e3, input.size() / 1e6 / seconds,
+                (double)parser.Entries() / (input.size() + 1), parser.LeoItems(), parser.ChartBytes() / 1024.0,
+                parser.ReservedBytes() / 1024.0);
+    if (ok && forest)
+    {
+        begin = Clock::now();
+        int root = parser.BuildSppf();
+        seconds = Seconds(begin);
+        std::printf(", SPPF %9.3f ms %8zu nodes %8zu packed, %.3g tree(s)", seconds * 1e3, parser.Nodes().size(),
+                    parser.Packed().size(), parser.CountTrees(root));
+    }
+    std::printf("\n");
+}
+
+// Random words over the terminals of `grammar` checked by two recognizers
+template <class First, class Second>
+void Agreement(const char *name, const Grammar &grammar, std::mt19937 &rng, First first, Second second)
+{
+    std::string alphabet;
+    for (const Production &p : grammar.Productions())
+        for (int symbol : p.right)
+            if (Grammar::IsTerminal(symbol) && alphabet.find((char)symbol) == std::string::npos)
+                alphabet += (char)symbol;
+    int words = 0, accepted = 0, mismatches = 0;
+    for (int i = 0; i < 20000; ++i)
+    {
+        std::string word;
+        if (i % 2 == 0)
+            word = RandomSentence(grammar, rng, rng() % 16);
+        else
+            for (int n = rng() % 12; n > 0 && !alphabet.empty(); --n)
+                word += alphabet[rng() % alphabet.size()];
+        bool a = first(word), b = second(word);
+        ++words;
+        accepted += a;
+        mismatches += a != b;
+    }
+    std::printf("%-36s %d words, %d accepted, %d mismatch(es)\n", name, words, accepted, mismatches);
+}
+
+// Longest of several random sentences: with ε-productions a random derivation
+// often stops early
+std::string LongSentence(const Grammar &grammar, std::mt19937 &rng, size_t size)
+{
+    std::string best;
+    for (int i = 0; i < 100 && best.size() < size / 2; ++i)
+    {
+        std::string sentence = RandomSentence(grammar, rng, size);
+        if (sentence.size() > best.size())
+            best.swap(sentence);
+    }
+    return best;
+}
+
+int RunBenchmark(const char *path)
+{
+    Grammar grammar;
+    if (!LoadGrammar(path, grammar))
+        return 1;
+    EarleyParser parser;
+    parser.Build(grammar);
+    std::printf("%s: %d variables, %zu productions\n", path, grammar.Variables(), grammar.Productions().size());
+
+    std::mt19937 rng(22);
+    for (size_t n : { 100, 1000, 10000 })
+        BenchCase("random", parser, LongSentence(grammar, rng, n), true);
+
+    // Right recursion (A -> aA, E -> bE) without Leo items would be quadratic
+    for (size_t n : { 1000, 10000, 100000, 300000 })
+        BenchCase("a^n b^2n", parser, std::string(n, 'a') + std::string(2 * n, 'b'), true);
+    for (size_t n : { 1000, 10000, 100000, 300000 })
+        BenchCase("a^2n b^n", parser, std::string(2 * n, 'a') + std::string(n, 'b'), true);
+
+    // S -> SS | a: Catalan-many trees, cubic time
+    Grammar ambiguous;
+    int s = ambiguous.AddVariable("S");
+    ambiguous.SetStart(s);
+    ambiguous.AddProduction(s, { s, s });
+    ambiguous.AddProduction(s, { 'a' });
+    EarleyParser catalan;
+    catalan.Build(ambiguous);
+    for (size_t n : { 25, 50, 100, 200 })
+        BenchCase("S -> SS | a", catalan, std::string(n, 'a'), true);
+
+    // The conversions, each side by the other recognizer
+    Pda pda;
+    std::string error;
+    if (GrammarToPda(grammar, pda, &error))
+    {
+        PdaRunner runner(pda);
+        Agreement("grammar -> PDA (PDA run vs Earley)", grammar, rng,
+                  [&](const std::string &w) { return runner.Run(w.data(), w.data() + w.size()); },
+                  [&](const std::string &w) { return parser.Parse(w.data(), w.data() + w.size()); });
+    }
+    Pda source;
+    Grammar triples;
+    if (LoadPda("PDA.jff", source) && PdaToGrammar(source, PDA_FINAL_STATE, triples, &error))
+    {
+        PdaRunner runner(source);
+        EarleyParser triple_parser;
+        triple_parser.Build(triples);
+        std::printf("PDA.jff -> %d variables, %zu productions\n", triples.Variables(), triples.Productions().size());
+        Agreement("PDA -> grammar (Earley vs PDA run)", triples, rng,
+                  [&](const std::string &w) { return triple_parser.Parse(w.data(), w.data() + w.size()); },
+                  [&](const std::string &w) { return runner.Run(w.data(), w.data() + w.size()); });
+    }
+    return 0;
+}
+
+int Run(const char *path, const char *input)
+{
+    Grammar grammar;
+    if (!LoadGrammar(path, grammar))
+        return 1;
+    EarleyParser parser;
+    parser.Build(grammar);
+
+    if (input)
+    {
+        RecordReader reader;
+        std::string message;
+        if (!reader.Open(input, &message))
+        {
+            std::fprintf(stderr, "%s\n", message.c_str());
+            return 1;
+        }
+        std::string_view line;
+        while (reader.Next(line))
+            std::fputs(parser.Parse(line.data(), line.data() + line.size()) ? "1\n" : "0\n", stdout);
+        return 0;
+    }
+
+    std::cout << "Enter your input line: ";
+    std::string line;
+    std::getline(std::cin, line);
+    if (parser.Parse(line.data(), line.data() + line.size()))
+        std::cout << "Accepted (" << parser.CountTrees(parser.BuildSppf()) << " parse tree(s)).\n";
+    else
+        std::cout << "Rejected.\n";
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0)
+        return RunBenchmark(argc > 2 ? argv[2] : DEFAULT_GRAMMAR);
+    if (argc > 3 && std::strcmp(argv[1], "--sppf") == 0)
+        return PrintSppf(argv[2], argv[3]);
+    if (argc > 2 && std::strcmp(argv[1], "--to-pda") == 0)
+        return ToPda(argv[2]);
+    if (argc > 2 && std::strcmp(argv[1], "--to-cfg") == 0)
+        return ToCfg(argv[2]);
+
+    return Run(argc > 1 ? argv[1] : DEFAULT_GRAMMAR, argc > 2 ? argv[2] : nullptr);
+}
@@ -0,0 +1,608 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../common/grammar.hpp"
+#include "../common/layer_table.hpp"
+
+enum SPPF_KIND {
+    SPPF_TERMINAL = 0,      // label - byte
+    SPPF_SYMBOL = 1,        // label - variable
+    SPPF_INTERMEDIATE = 2,  // label - item (binarised right sides)
+    SPPF_EPSILON = 3        // label - nullable variable deriving ε here
+};
+
+// Node of a shared packed parse forest: `label` derives input [begin, end)
+struct SppfNode {
+    int kind = SPPF_SYMBOL;
+    int label = 0;
+    int begin = 0;
+    int end = 0;
+    int entry = -1;         // Earley item of an intermediate node
+    int first_packed = -1;
+};
+
+// One derivation of a node: item `item` split at `pivot` into the left part
+// (node or -1) and the last symbol (node)
+struct SppfPacked {
+    int item = 0;
+    int pivot = 0;
+    int left = -1;
+    int right = -1;
+    int next = -1;
+};
+
+// Earley parser for any context-free grammar, with a shared packed parse
+// forest.
+//
+// Пункт - (правило, позиция точки) одним числом: пункты правила p идут подряд
+// с m_Item_first[p]. Заранее вычислены: обнуляемые переменные, для каждой
+// переменной замыкание предсказаний (все пункты B -> •γ, которые появятся при
+// предсказании A, с переходом через обнуляемые префиксы) и для каждого пункта
+// следующий символ. Множество Earley - отрезок общего массива записей
+// (пункт, начало), дубликаты в текущем множестве отсекает LayerTable.
+//
+// Обнуляемые переменные - по Aycock-Horspool: точка сразу переносится через
+// обнуляемую переменную, завершения с началом в текущем множестве не нужны.
+// Правая рекурсия (A -> aA) - по Leo: если в множестве j единственный пункт
+// ждет A и A в нем последний символ, завершение A сразу дает верхний пункт
+// цепочки, а не всю цепочку, поэтому LR-регулярные грамматики (в том числе
+// однозначные части входа) разбираются за линейное время.
+//
+// Каждая запись хранит ссылки на то, как она получена (сдвиг, завершение,
+// перенос через ε, цепочка Leo). По ним после разбора сверху вниз строится
+// SPPF в бинаризованной форме Scott: узел символа (A, i, k), промежуточный
+// узел (пункт, i, k), упакованные узлы - варианты разбиения. ε-поддеревья
+// сворачиваются в один узел на обнуляемую переменную.
+class EarleyParser {
+public:
+    void Build(const Grammar& grammar)
+    {
+        m_Grammar = grammar;
+        const auto& productions = m_Grammar.Productions();
+        int variables = m_Grammar.Variables();
+
+        m_Item_first.clear();
+        m_Item_next.clear();
+        m_Item_left.clear();
+        m_Item_dot.clear();
+        for (size_t p = 0; p < productions.size(); ++p) {
+            m_Item_first.push_back(static_cast<int>(m_Item_next.size()));
+            const auto& right = productions[p].right;
+            for (size_t dot = 0; dot <= right.size(); ++dot) {
+                m_Item_next.push_back(dot < right.size() ? right[dot] : COMPLETE);
+                m_Item_left.push_back(productions[p].left);
+                m_Item_dot.push_back(static_cast<int>(dot));
+            }
+        }
+
+        m_Nullable.assign(variables, false);
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (const auto& p : productions) {
+                bool nullable = true;
+                for (int symbol : p.right)
+                    nullable = nullable && !Grammar::IsTerminal(symbol) && m_Nullable[Grammar::VariableIndex(symbol)];
+                if (nullable && !m_Nullable[Grammar::VariableIndex(p.left)]) {
+                    m_Nullable[Grammar::VariableIndex(p.left)] = true;
+                    changed = true;
+                }
+            }
+        }
+
+        // Prediction closures: variables that start a right side of a
+        // predicted variable after a nullable prefix
+        std::vector<std::vector<int>> by_left(variables);
+        for (size_t p = 0; p < productions.size(); ++p)
+            by_left[Grammar::VariableIndex(productions[p].left)].push_back(static_cast<int>(p));
+        m_Predict_first.assign(variables + 1, 0);
+        m_Predict_items.clear();
+        m_Predict_variables.clear();
+        m_Closure_first.assign(variables + 1, 0);
+        std::vector<int> seen(variables, -1);
+        for (int a = 0; a < variables; ++a) {
+            m_Predict_first[a] = static_cast<int>(m_Predict_items.size());
+            m_Closure_first[a] = static_cast<int>(m_Predict_variables.size());
+            std::vector<int> queue = { a };
+            seen[a] = a;
+            for (size_t k = 0; k < queue.size(); ++k) {
+                m_Predict_variables.push_back(queue[k]);
+                for (int p : by_left[queue[k]]) {
+                    m_Predict_items.push_back(m_Item_first[p]);
+                    for (int symbol : productions[p].right) {
+                        if (Grammar::IsTerminal(symbol))
+                            break;
+                        int v = Grammar::VariableIndex(symbol);
+                        if (seen[v] != a) {
+                            seen[v] = a;
+                            queue.push_back(v);
+                        }
+                        if (!m_Nullable[v])
+                            break;
+                    }
+                }
+            }
+        }
+        m_Predict_first[variables] = static_cast<int>(m_Predict_items.size());
+        m_Closure_first[variables] = static_cast<int>(m_Predict_variables.size());
+    }
+
+    // Recognizes [first, last); the chart stays for BuildSppf()
+    bool Parse(const char* first, const char* last)
+    {
+        const unsigned char* input = reinterpret_cast<const unsigned char*>(first);
+        int length = static_cast<int>(last - first);
+
+        m_Entries.clear();
+        m_Links.clear();
+        m_Set_first.assign(1, 0);
+        m_Waiting.clear();
+        m_Groups.clear();
+        m_Group_first.assign(1, 0);
+        m_Leo.clear();
+        m_Predicted.assign(m_Grammar.Variables(), -1);
+        m_Length = length;
+        m_Accepted = false;
+
+        m_Set.Clear();
+        Predict(Grammar::VariableIndex(m_Grammar.Start()), 0);
+
+        for (int k = 0;; ++k) {
+            m_Scanned.clear();
+            for (size_t e = m_Set_first[k]; e < m_Entries.size(); ++e) {
+                int item = m_Entries[e].item;
+                int origin = m_Entries[e].origin;
+                int symbol = m_Item_next[item];
+                if (symbol == COMPLETE) {
+                    if (origin == k)
+                        continue;
+                    int group = FindGroup(origin, m_Item_left[item]);
+                    if (group < 0)
+                        continue;
+                    int leo = LeoFor(group);
+                    if (leo >= 0) {
+                        Add(m_Leo[leo].top_item, m_Leo[leo].top_origin, LINK_LEO, leo, static_cast<int>(e));
+                        continue;
+                    }
+                    for (int w = m_Groups[group].first; w < m_Groups[group].first + m_Groups[group].count; ++w) {
+                        Entry waiting = m_Entries[m_Waiting[w]];
+                        Add(waiting.item + 1, waiting.origin, LINK_COMPLETE, m_Waiting[w], static_cast<int>(e));
+                    }
+                } else if (Grammar::IsTerminal(symbol)) {
+                    if (k < length && input[k] == symbol)
+                        m_Scanned.push_back(Scan{ item + 1, origin, static_cast<int>(e) });
+                } else {
+                    int v = Grammar::VariableIndex(symbol);
+                    if (m_Predicted[v] != k)
+                        Predict(v, k);
+                    if (m_Nullable[v])
+                        Add(item + 1, origin, LINK_NULL, static_cast<int>(e), symbol);
+                }
+            }
+            IndexWaiting(k);
+
+            if (k == length)
+                break;
+            m_Set_first.push_back(static_cast<int>(m_Entries.size()));
+            m_Set.Clear();
+            for (const Scan& s : m_Scanned)
+                Add(s.item, s.origin, LINK_SCAN, s.pred, -1);
+            if (m_Scanned.empty()) {
+                m_Set_first.push_back(static_cast<int>(m_Entries.size()));
+                return false;
+            }
+        }
+        m_Set_first.push_back(static_cast<int>(m_Entries.size()));
+
+        for (int e = m_Set_first[length]; e < m_Set_first[length + 1]; ++e)
+            if (m_Entries[e].origin == 0 && m_Item_next[m_Entries[e].item] == COMPLETE &&
+                m_Item_left[m_Entries[e].item] == m_Grammar.Start())
+                m_Accepted = true;
+        return m_Accepted;
+    }
+
+    // Forest of the last accepted input; returns the root (-1 if rejected)
+    int BuildSppf()
+    {
+        m_Nodes.clear();
+        m_Packed.clear();
+        m_Entry_node.assign(m_Entries.size(), -1);
+        m_Span_index.Clear();
+        m_Span_next.clear();
+        if (!m_Accepted)
+            return -1;
+
+        m_Expand.clear();
+        int root = SymbolNode(m_Grammar.Start(), 0, m_Length);
+        while (!m_Expand.empty()) {
+            int node = m_Expand.back();
+            m_Expand.pop_back();
+            int k = m_Nodes[node].end;
+            if (m_Nodes[node].kind == SPPF_INTERMEDIATE) {
+                ExpandEntry(node, m_Nodes[node].entry, k);
+                continue;
+            }
+            // Complete entries of the variable in the set of the end
+            for (int e = m_Set_first[k]; e < m_Set_first[k + 1]; ++e)
+                if (m_Entries[e].origin == m_Nodes[node].begin && m_Item_next[m_Entries[e].item] == COMPLETE &&
+                    m_Item_left[m_Entries[e].item] == m_Nodes[node].label)
+                    ExpandEntry(node, e, k);
+        }
+        return root;
+    }
+
+    // Number of parse trees under `node` (saturates at `limit`; a cycle in
+    // the forest - infinitely many - also gives `limit`)
+    double CountTrees(int node, double limit = 1e18) const
+    {
+        std::vector<double> count(m_Nodes.size(), -1);
+        std::vector<char> state(m_Nodes.size(), 0);     // 0 - new, 1 - on the stack, 2 - done
+        std::vector<std::pair<int, int>> stack = { { node, m_Nodes[node].first_packed } };
+        state[node] = 1;
+        bool cyclic = false;
+        while (!stack.empty()) {
+            int current = stack.back().first;
+            // First child not counted yet
+            int child = -1;
+            for (int& p = stack.back().second; p >= 0 && child < 0; p = child < 0 ? m_Packed[p].next : p) {
+                for (int c : { m_Packed[p].left, m_Packed[p].right }) {
+                    if (c < 0 || state[c] == 2)
+                        continue;
+                    if (state[c] == 1) {
+                        cyclic = true;
+                        continue;
+                    }
+                    child = c;
+                    break;
+                }
+            }
+            if (child >= 0) {
+                state[child] = 1;
+                stack.push_back({ child, m_Nodes[child].first_packed });
+                continue;
+            }
+
+            double total = m_Nodes[current].first_packed < 0 ? 1 : 0;
+            for (int p = m_Nodes[current].first_packed; p >= 0; p = m_Packed[p].next) {
+                double left = m_Packed[p].left < 0 ? 1 : count[m_Packed[p].left];
+                double right = count[m_Packed[p].right];
+                if (left < 0 || right < 0)
+                    left = limit;
+                total = std::min(limit, total + std::min(limit, left * right));
+            }
+            count[current] = total;
+            state[current] = 2;
+            stack.pop_back();
+        }
+        return cyclic ? limit : count[node];
+    }
+
+    bool Accepted() const { return m_Accepted; }
+    const Grammar& Source() const { return m_Grammar; }
+    bool Nullable(int variable) const { return m_Nullable[Grammar::VariableIndex(variable)]; }
+
+    // Chart size of the last parse
+    size_t Entries() const { return m_Entries.size(); }
+    size_t Links() const { return m_Links.size(); }
+    size_t LeoItems() const { return m_Leo.size(); }
+    size_t ChartBytes() const
+    {
+        return m_Entries.size() * sizeof(Entry) + m_Links.size() * sizeof(Link) +
+               m_Waiting.size() * sizeof(int) + m_Groups.size() * sizeof(Group) + m_Leo.size() * sizeof(LeoItem);
+    }
+
+    // Memory held by the chart: the buffers are reused from parse to parse,
+    // so this is the peak over all parses so far
+    size_t ReservedBytes() const
+    {
+        return m_Entries.capacity() * sizeof(Entry) + m_Links.capacity() * sizeof(Link) +
+               m_Waiting.capacity() * sizeof(int) + m_Groups.capacity() * sizeof(Group) +
+               m_Leo.capacity() * sizeof(LeoItem) + m_Set.Bytes();
+    }
+
+    const std::vector<SppfNode>& Nodes() const { return m_Nodes; }
+    const std::vector<SppfPacked>& Packed() const { return m_Packed; }
+
+    // "A -> a•B"
+    std::string ItemText(int item) const
+    {
+        const Production& p = m_Grammar.Productions()[ProductionOf(item)];
+        std::string text = m_Grammar.SymbolName(p.left) + " ->";
+        for (size_t k = 0; k <= p.right.size(); ++k) {
+            if (static_cast<int>(k) == m_Item_dot[item])
+                text += " •";
+            if (k < p.right.size())
+                text += " " + m_Grammar.SymbolName(p.right[k]);
+        }
+        return text;
+    }
+
+    // "(A, 0, 3)", "(A -> a•B, 0, 2)", "(ε A, 3)"
+    std::string NodeText(int node) const
+    {
+        const SppfNode& n = m_Nodes[node];
+        std::string span = ", " + std::to_string(n.begin) + ", " + std::to_string(n.end) + ")";
+        switch (n.kind) {
+        case SPPF_TERMINAL:
+            return "('" + std::string(1, static_cast<char>(n.label)) + "'" + span;
+        case SPPF_INTERMEDIATE:
+            return "(" + ItemText(n.label) + span;
+        case SPPF_EPSILON:
+            return "(ε " + m_Grammar.SymbolName(n.label) + ", " + std::to_string(n.begin) + ")";
+        default:
+            return "(" + m_Grammar.SymbolName(n.label) + span;
+        }
+    }
+
+private:
+    static constexpr int COMPLETE = -1;
+    static constexpr int UNKNOWN = -2;
+
+    enum LINK_KIND { LINK_SCAN, LINK_COMPLETE, LINK_NULL, LINK_LEO };
+
+    struct Entry {
+        int item;
+        int origin;
+        int first_link;
+    };
+
+    // How an entry was obtained: `pred` - the entry with the dot one symbol
+    // to the left (for LINK_LEO - the Leo item), `cause` - the completed
+    // entry of that symbol (for LINK_NULL - the nullable variable)
+    struct Link {
+        int kind;
+        int pred;
+        int cause;
+        int next;
+    };
+
+    struct Scan {
+        int item;
+        int origin;
+        int pred;
+    };
+
+    // Entries of set `set` waiting for `variable`: m_Waiting[first, first + count)
+    struct Group {
+        int variable;
+        int set;
+        int first;
+        int count;
+        int leo;                // Leo item, -1 - none, UNKNOWN - not computed yet
+    };
+
+    // Set `set` has one entry `entry` (B -> α•A) waiting for A; a completed
+    // A there completes the top of the chain at once
+    struct LeoItem {
+        int entry;
+        int set;
+        int parent;             // Leo item of B in the set where `entry` began
+        int top_item;
+        int top_origin;
+    };
+
+    int ProductionOf(int item) const
+    {
+        return static_cast<int>(std::upper_bound(m_Item_first.begin(), m_Item_first.end(), item) - m_Item_first.begin()) - 1;
+    }
+
+    // Entry (item, origin) of the current set, with a link if kind >= 0
+    void Add(int item, int origin, int kind, int pred, int cause)
+    {
+        bool inserted;
+        int e = m_Set.FindOrInsert(static_cast<uint64_t>(item) << 32 | static_cast<uint32_t>(origin),
+                                   static_cast<int>(m_Entries.size()), inserted);
+        if (inserted)
+            m_Entries.push_back(Entry{ item, origin, -1 });
+        if (kind >= 0) {
+            m_Links.push_back(Link{ kind, pred, cause, m_Entries[e].first_link });
+            m_Entries[e].first_link = static_cast<int>(m_Links.size()) - 1;
+        }
+    }
+
+    void Predict(int variable, int k)
+    {
+        for (int v = m_Closure_first[variable]; v < m_Closure_first[variable + 1]; ++v)
+            m_Predicted[m_Predict_variables[v]] = k;
+        for (int i = m_Predict_first[variable]; i < m_Predict_first[variable + 1]; ++i)
+            Add(m_Predict_items[i], k, -1, -1, -1);
+    }
+
+    // Entries of set k waiting for a variable, grouped by the variable
+    void IndexWaiting(int k)
+    {
+        m_Wait_sort.clear();
+        for (int e = m_Set_first[k]; e < static_cast<int>(m_Entries.size()); ++e) {
+            int symbol = m_Item_next[m_Entries[e].item];
+            if (symbol != COMPLETE && !Grammar::IsTerminal(symbol))
+                m_Wait_sort.push_back({ symbol, e });
+        }
+        std::sort(m_Wait_sort.begin(), m_Wait_sort.end());
+        for (size_t i = 0; i < m_Wait_sort.size(); ++i) {
+            if (i == 0 || m_Wait_sort[i].first != m_Wait_sort[i - 1].first)
+                m_Groups.push_back(Group{ m_Wait_sort[i].first, k, static_cast<int>(m_Waiting.size()), 0, UNKNOWN });
+            m_Waiting.push_back(m_Wait_sort[i].second);
+            ++m_Groups.back().count;
+        }
+        m_Group_first.push_back(static_cast<int>(m_Groups.size()));
+    }
+
+    int FindGroup(int set, int variable) const
+    {
+        for (int g = m_Group_first[set]; g < m_Group_first[set + 1]; ++g)
+            if (m_Groups[g].variable == variable)
+                return g;
+        return -1;
+    }
+
+    // Leo item of a group (-1 - none), computed on first use up the whole
+    // chain
+    int LeoFor(int group)
+    {
+        m_Leo_path.clear();
+        for (int g = group; g >= 0 && m_Groups[g].leo == UNKNOWN;) {
+            const Entry& waiting = m_Entries[m_Waiting[m_Groups[g].first]];
+            // The start variable in set 0 also waits for the accepting
+            // S' -> S•, so it never has a single waiting entry
+            bool start = m_Groups[g].set == 0 && m_Groups[g].variable == m_Grammar.Start();
+            if (start || m_Groups[g].count != 1 || m_Item_next[waiting.item + 1] != COMPLETE) {
+                m_Groups[g].leo = -1;
+                break;
+            }
+            m_Leo_path.push_back(g);
+            g = waiting.origin < m_Groups[g].set ? FindGroup(waiting.origin, m_Item_left[waiting.item]) : -1;
+        }
+
+        for (size_t t = m_Leo_path.size(); t-- > 0;) {
+            Group& g = m_Groups[m_Leo_path[t]];
+            int entry = m_Waiting[g.first];
+            Entry waiting = m_Entries[entry];
+            int parent_group = waiting.origin < g.set ? FindGroup(waiting.origin, m_Item_left[waiting.item]) : -1;
+            int parent = parent_group >= 0 ? m_Groups[parent_group].leo : -1;
+            LeoItem leo{ entry, g.set, parent, waiting.item + 1, waiting.origin };
+            if (parent >= 0) {
+                leo.top_item = m_Leo[parent].top_item;
+                leo.top_origin = m_Leo[parent].top_origin;
+            }
+            g.leo = static_cast<int>(m_Leo.size());
+            m_Leo.push_back(leo);
+        }
+        return m_Groups[group].leo;
+    }
+
+    // Node with these fields; intermediate nodes are found by their entry,
+    // the others by the span
+    int Node(int kind, int label, int begin, int end, int entry = -1)
+    {
+        int* slot;
+        if (kind == SPPF_INTERMEDIATE) {
+            slot = &m_Entry_node[entry];
+            if (*slot >= 0)
+                return *slot;
+        } else {
+            slot = &m_Span_index.At(static_cast<uint64_t>(begin) << 32 | static_cast<uint32_t>(end));
+            for (int n = *slot; n >= 0; n = m_Span_next[n])
+                if (m_Nodes[n].kind == kind && m_Nodes[n].label == label)
+                    return n;
+            m_Span_next.push_back(*slot);
+        }
+        if (kind == SPPF_INTERMEDIATE)
+            m_Span_next.push_back(-1);
+        *slot = static_cast<int>(m_Nodes.size());
+
+        SppfNode node;
+        node.kind = kind;
+        node.label = label;
+        node.begin = begin;
+        node.end = end;
+        node.entry = entry;
+        m_Nodes.push_back(node);
+        if (kind == SPPF_SYMBOL || kind == SPPF_INTERMEDIATE)
+            m_Expand.push_back(*slot);
+        return *slot;
+    }
+
+    int SymbolNode(int symbol, int begin, int end)
+    {
+        if (Grammar::IsTerminal(symbol))
+            return Node(SPPF_TERMINAL, symbol, begin, end);
+        if (begin == end)
+            return Node(SPPF_EPSILON, symbol, begin, end);
+        return Node(SPPF_SYMBOL, symbol, begin, end);
+    }
+
+    // Node of the part before the dot of entry e in set k (-1 - nothing)
+    int NodeFor(int e, int k)
+    {
+        int item = m_Entries[e].item;
+        int origin = m_Entries[e].origin;
+        if (m_Item_dot[item] == 0)
+            return -1;
+        if (m_Item_next[item] == COMPLETE)
+            return SymbolNode(m_Item_left[item], origin, k);
+        if (m_Item_dot[item] == 1)
+            return SymbolNode(m_Item_next[item - 1], origin, k);
+        return Node(SPPF_INTERMEDIATE, item, origin, k, e);
+    }
+
+    void AddPacked(int node, int item, int pivot, int left, int right)
+    {
+        for (int p = m_Nodes[node].first_packed; p >= 0; p = m_Packed[p].next)
+            if (m_Packed[p].item == item && m_Packed[p].pivot == pivot)
+                return;
+        m_Packed.push_back(SppfPacked{ item, pivot, left, right, m_Nodes[node].first_packed });
+        m_Nodes[node].first_packed = static_cast<int>(m_Packed.size()) - 1;
+    }
+
+    // Packed children of `node` from the links of entry e of set k
+    void ExpandEntry(int node, int e, int k)
+    {
+        int item = m_Entries[e].item;
+        for (int l = m_Entries[e].first_link; l >= 0; l = m_Links[l].next) {
+            const Link link = m_Links[l];
+            switch (link.kind) {
+            case LINK_SCAN:
+                AddPacked(node, item, k - 1, NodeFor(link.pred, k - 1), SymbolNode(m_Item_next[item - 1], k - 1, k));
+                break;
+            case LINK_COMPLETE: {
+                int j = m_Entries[link.cause].origin;
+                AddPacked(node, item, j, NodeFor(link.pred, j), SymbolNode(m_Item_left[m_Entries[link.cause].item], j, k));
+                break;
+            }
+            case LINK_NULL:
+                AddPacked(node, item, k, NodeFor(link.pred, k), SymbolNode(link.cause, k, k));
+                break;
+            case LINK_LEO: {
+                // The skipped completions of the chain, bottom up
+                int j = m_Entries[link.cause].origin;
+                int lower = SymbolNode(m_Item_left[m_Entries[link.cause].item], j, k);
+                for (int r = link.pred; r >= 0; r = m_Leo[r].parent) {
+                    const LeoItem leo = m_Leo[r];
+                    const Entry& waiting = m_Entries[leo.entry];
+                    int upper = SymbolNode(m_Item_left[waiting.item], waiting.origin, k);
+                    AddPacked(upper, waiting.item + 1, leo.set, NodeFor(leo.entry, leo.set), lower);
+                    lower = upper;
+                }
+                break;
+            }
+            }
+        }
+    }
+
+    Grammar m_Grammar;
+    std::vector<int> m_Item_first;          // first item of every production
+    std::vector<int> m_Item_next;           // symbol after the dot or COMPLETE
+    std::vector<int> m_Item_left;
+    std::vector<int> m_Item_dot;
+    std::vector<bool> m_Nullable;
+    std::vector<int> m_Predict_first;       // per variable, into m_Predict_items
+    std::vector<int> m_Predict_items;
+    std::vector<int> m_Closure_first;       // per variable, into m_Predict_variables
+    std::vector<int> m_Predict_variables;
+
+    std::vector<Entry> m_Entries;
+    std::vector<Link> m_Links;
+    std::vector<int> m_Set_first;           // entries of set k: [m_Set_first[k], m_Set_first[k + 1])
+    std::vector<Scan> m_Scanned;
+    std::vector<int> m_Predicted;           // set where the variable was predicted last
+    std::vector<int> m_Waiting;
+    std::vector<std::pair<int, int>> m_Wait_sort;
+    std::vector<int> m_Leo_path;            // groups of a chain being computed
+    std::vector<Group> m_Groups;
+    std::vector<int> m_Group_first;         // groups of set k: [m_Group_first[k], m_Group_first[k + 1])
+    std::vector<LeoItem> m_Leo;
+    LayerTable m_Set;                       // (item, origin) -> entry, current set
+    int m_Length = 0;
+    bool m_Accepted = false;
+
+    std::vector<SppfNode> m_Nodes;
+    std::vector<SppfPacked> m_Packed;
+    std::vector<int> m_Expand;              // nodes whose packed nodes are not built yet
+    std::vector<int> m_Entry_node;          // intermediate node of an entry
+    LayerTable m_Span_index;                // (begin, end) -> last other node of the span
+    std::vector<int> m_Span_next;           // previous node of the same span
+};
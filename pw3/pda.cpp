@@ -0,0 +1,285 @@
+// Pushdown automaton from a JFLAP file (pw3/PDA.jff by default).
+//
+//   pda                          - the automaton of this work, a line is
+//                                  entered from the keyboard
+//   pda <file.jff> [input]       - automaton from the file; with `input` every
+//                                  line of it is checked ('1' / '0'), the
+//                                  statistics go to stderr
+//   pda --empty <file.jff> ...   - the same, accepted by empty stack
+//   pda --bench                  - configurations per second and memory on
+//                                  growing inputs, the graph-structured stack
+//                                  against copied stacks
+
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "../common/record_reader.hpp"
+#include "pda.hpp"
+
+const char *DEFAULT_AUTOMATON = "PDA.jff";
+
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::time_point from)
+{
+    return std::chrono::duration<double>(Clock::now() - from).count();
+}
+
+bool LoadPda(const char *path, Pda &pda)
+{
+    JffDocument doc;
+    std::string error;
+    if (!doc.Load(path, &error) || !pda.Load(doc, &error))
+    {
+        std::fprintf(stderr, "%s: %s\n", path, error.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Every branch with its own copy of the stack, configurations of a position
+// deduplicated by (state, stack); the baseline for the benchmark. Gives up
+// when a position has more than `limit` configurations
+class CopyingRunner
+{
+public:
+    CopyingRunner(const Pda &pda, int accept, size_t limit) : m_Pda(pda), m_Accept(accept), m_Limit(limit) {}
+
+    // 1 - accepted, 0 - rejected, -1 - over the limit
+    int Run(const char *first, const char *last)
+    {
+        m_Configurations = 0;
+        std::vector<std::string> current, next;
+        std::unordered_set<std::string> current_set, next_set;
+        std::string start = Key(m_Pda.Start(), std::string(1, Pda::BOTTOM));
+        current.push_back(start);
+        current_set.insert(start);
+
+        for (const char *p = first;; ++p)
+        {
+            bool at_end = p == last;
+            for (size_t k = 0; k < current.size(); ++k)
+            {
+                if (current.size() > m_Limit)
+                    return -1;
+                int q;
+                std::memcpy(&q, current[k].data(), sizeof(q));
+                std::string stack = current[k].substr(sizeof(q));
+                if (at_end && (m_Accept == PDA_EMPTY_STACK ? stack.empty() : m_Pda.IsFinal(q)))
+                    return 1;
+                for (const Pda::Op &op : m_Pda.Ops(q))
+                {
+                    std::string top = stack;
+                    switch (op.kind)
+                    {
+                    case Pda::OP_EPSILON:
+                        Add(current, current_set, op.to, stack);
+                        break;
+                    case Pda::OP_READ:
+                        if (!at_end && static_cast<unsigned char>(*p) == op.symbol)
+                            Add(next, next_set, op.to, stack);
+                        break;
+                    case Pda::OP_POP:
+                        if (!stack.empty() && static_cast<unsigned char>(stack.back()) == op.symbol)
+                        {
+                            top.pop_back();
+                            Add(current, current_set, op.to, top);
+                        }
+                        break;
+                    case Pda::OP_PUSH:
+                        top.push_back(static_cast<char>(op.symbol));
+                        Add(current, current_set, op.to, top);
+                        break;
+                    }
+                }
+            }
+            m_Configurations += current.size();
+            if (at_end || next.empty())
+                return 0;
+            current.swap(next);
+            current_set.swap(next_set);
+            next.clear();
+            next_set.clear();
+        }
+    }
+
+    size_t Configurations() const { return m_Configurations; }
+
+private:
+    static std::string Key(int state, const std::string &stack)
+    {
+        return std::string(reinterpret_cast<const char *>(&state), sizeof(state)) + stack;
+    }
+
+    static void Add(std::vector<std::string> &layer, std::unordered_set<std::string> &set, int state,
+                    const std::string &stack)
+    {
+        std::string key = Key(state, stack);
+        if (set.insert(key).second)
+            layer.push_back(key);
+    }
+
+    const Pda &m_Pda;
+    int m_Accept;
+    size_t m_Limit;
+    size_t m_Configurations = 0;
+};
+
+// Even palindromes w w^R over {a, b}: the middle is guessed
+Pda PalindromePda()
+{
+    Pda pda;
+    int push = pda.AddState();
+    int pop = pda.AddState();
+    int done = pda.AddState(true);
+    pda.SetStart(push);
+    pda.AddTransition(push, push, "a", "", "A");
+    pda.AddTransition(push, push, "b", "", "B");
+    pda.AddTransition(push, pop, "", "", "");
+    pda.AddTransition(pop, pop, "a", "A", "");
+    pda.AddTransition(pop, pop, "b", "B", "");
+    pda.AddTransition(pop, done, "", "Z", "");
+    return pda;
+}
+
+// a^n b^n, but every `a` pushes X or Y at random and every `b` pops either:
+// 2^n different stacks
+Pda GuessingPda()
+{
+    Pda pda;
+    int push = pda.AddState();
+    int pop = pda.AddState();
+    int done = pda.AddState(true);
+    pda.SetStart(push);
+    pda.AddTransition(push, push, "a", "", "X");
+    pda.AddTransition(push, push, "a", "", "Y");
+    pda.AddTransition(push, pop, "", "", "");
+    pda.AddTransition(pop, pop, "b", "X", "");
+    pda.AddTransition(pop, pop, "b", "Y", "");
+    pda.AddTransition(pop, done, "", "Z", "");
+    return pda;
+}
+
+void BenchCase(const char *name, const Pda &pda, const std::string &input, bool copying)
+{
+    PdaRunner runner(pda);
+    auto begin = Clock::now();
+    bool ok = runner.Run(input.data(), input.data() + input.size());
+    double seconds = Seconds(begin);
+    const PdaStats &stats = runner.Stats();
+    std::printf("%-12s n=%-8zu %-8s %9.3f ms %10zu configs %7.1f M configs/s, %8zu nodes, peak layer %7zu, %8.1f KB",
+                name, input.size(), ok ? "accepted" : "rejected", seconds * 1e3, stats.configurations,
+                stats.configurations / 1e6 / seconds, stats.nodes, stats.peak_layer, stats.bytes / 1024.0);
+    if (copying)
+    {
+        CopyingRunner baseline(pda, PDA_FINAL_STATE, 1 << 18);
+        begin = Clock::now();
+        int verdict = baseline.Run(input.data(), input.data() + input.size());
+        seconds = Seconds(begin);
+        if (verdict < 0)
+            std::printf(" | copied stacks: over %d configs per position", 1 << 18);
+        else
+            std::printf(" | copied stacks: %9.3f ms %10zu configs%s", seconds * 1e3, baseline.Configurations(),
+                        verdict == ok ? "" : " MISMATCH");
+    }
+    std::printf("\n");
+}
+
+int RunBenchmark()
+{
+    Pda pda;
+    if (!LoadPda(DEFAULT_AUTOMATON, pda))
+        return 1;
+    std::printf("%s: %d states (%d with the intermediate ones), %zu transitions\n", DEFAULT_AUTOMATON,
+                pda.NamedStates(), pda.States(), pda.Transitions().size());
+
+    // a^n b^2n - the language of PDA.jff; deterministic in effect
+    for (size_t n : { 1000, 10000, 100000, 1000000 })
+        BenchCase("PDA.jff", pda, std::string(n, 'a') + std::string(2 * n, 'b'), n <= 10000);
+
+    // a^2n: every position may be the middle
+    Pda palindrome = PalindromePda();
+    for (size_t n : { 100, 300, 1000, 3000 })
+        BenchCase("palindrome", palindrome, std::string(2 * n, 'a'), n <= 1000);
+
+    // Random palindromes: few guesses survive
+    std::mt19937 rng(21);
+    for (size_t n : { 1000, 10000, 1000000 })
+    {
+        std::string half;
+        for (size_t i = 0; i < n; ++i)
+            half += "ab"[rng() % 2];
+        BenchCase("palindrome", palindrome, half + std::string(half.rbegin(), half.rend()), n <= 10000);
+    }
+
+    Pda guessing = GuessingPda();
+    for (size_t n : { 8, 12, 16, 20, 1000, 100000 })
+        BenchCase("guessing", guessing, std::string(n, 'a') + std::string(n, 'b'), n <= 20);
+    return 0;
+}
+
+int Run(const char *path, const char *input, int accept)
+{
+    Pda pda;
+    if (!LoadPda(path, pda))
+        return 1;
+    PdaRunner runner(pda, accept);
+
+    if (input)
+    {
+        RecordReader reader;
+        std::string message;
+        if (!reader.Open(input, &message))
+        {
+            std::fprintf(stderr, "%s\n", message.c_str());
+            return 1;
+        }
+        std::string_view line;
+        size_t lines = 0, accepted = 0, configurations = 0, bytes = 0;
+        auto begin = Clock::now();
+        while (reader.Next(line))
+        {
+            bool ok = runner.Run(line.data(), line.data() + line.size());
+            std::fputs(ok ? "1\n" : "0\n", stdout);
+            ++lines;
+            accepted += ok;
+            configurations += runner.Stats().configurations;
+            bytes = runner.Stats().bytes;
+        }
+        double seconds = Seconds(begin);
+        std::fprintf(stderr, "%zu lines, %zu accepted, %zu configurations in %.3f s (%.1f M/s), peak memory %.1f KB\n",
+                     lines, accepted, configurations, seconds, configurations / 1e6 / seconds, bytes / 1024.0);
+        return 0;
+    }
+
+    std::cout << "Enter your input line: ";
+    std::string line;
+    std::getline(std::cin, line);
+    if (runner.Run(line.data(), line.data() + line.size()))
+        std::cout << "Accepted.\n";
+    else
+        std::cout << "Rejected.\n";
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0)
+        return RunBenchmark();
+
+    int accept = PDA_FINAL_STATE;
+    if (argc > 1 && std::strcmp(argv[1], "--empty") == 0)
+    {
+        accept = PDA_EMPTY_STACK;
+        ++argv;
+        --argc;
+    }
+    return Run(argc > 1 ? argv[1] : DEFAULT_AUTOMATON, argc > 2 ? argv[2] : nullptr, accept);
+}
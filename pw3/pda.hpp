@@ -0,0 +1,317 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "../common/jff.hpp"
+#include "../common/layer_table.hpp"
+
+enum PDA_ACCEPT {
+    PDA_FINAL_STATE = 0,    // JFLAP default: a final state after the whole input
+    PDA_EMPTY_STACK = 1     // the whole input read and the stack empty
+};
+
+// Nondeterministic pushdown automaton (<type>pda</type>).
+// Переход JFLAP (прочитать строку, снять строку, положить строку) хранится
+// цепочкой элементарных шагов через служебные состояния: сначала снимаются
+// символы (первый символ метки - вершина), затем читаются символы входа,
+// затем кладутся символы (первый символ метки оказывается на вершине).
+// Переход без меток - ε-шаг. Начальный символ стека - 'Z', как в JFLAP.
+class Pda {
+public:
+    static constexpr char BOTTOM = 'Z';
+
+    enum OP_KIND { OP_EPSILON, OP_READ, OP_POP, OP_PUSH };
+
+    struct Op {
+        uint8_t kind = OP_EPSILON;
+        uint8_t symbol = 0;
+        int to = 0;
+    };
+
+    // Transition as in the file
+    struct Transition {
+        int from;
+        int to;
+        std::string read;
+        std::string pop;
+        std::string push;
+    };
+
+    bool Load(const JffDocument& doc, std::string* error = nullptr)
+    {
+        if (doc.Type() != "pda") {
+            if (error)
+                *error = "not a pushdown automaton: <type>" + std::string(doc.Type()) + "</type>";
+            return false;
+        }
+        if (doc.InitialState() < 0) {
+            if (error)
+                *error = "no initial state";
+            return false;
+        }
+        Clear();
+        for (const auto& state : doc.States())
+            AddState(state.final);
+        SetStart(doc.InitialState());
+        for (const auto& t : doc.Transitions())
+            AddTransition(t.from, t.to, doc.Label(t, JFF_READ), doc.Label(t, JFF_POP), doc.Label(t, JFF_PUSH));
+        return true;
+    }
+
+    void Clear()
+    {
+        m_Ops.clear();
+        m_Final.clear();
+        m_Start = 0;
+        m_Named = 0;
+        m_Transitions.clear();
+    }
+
+    int AddState(bool final = false)
+    {
+        if (m_Transitions.empty())
+            m_Named = States() + 1;
+        m_Ops.emplace_back();
+        m_Final.push_back(final);
+        return States() - 1;
+    }
+
+    void SetStart(int state) { m_Start = state; }
+
+    void AddTransition(int from, int to, std::string_view read, std::string_view pop, std::string_view push)
+    {
+        m_Transitions.push_back(Transition{ from, to, std::string(read), std::string(pop), std::string(push) });
+        std::vector<Op> chain;
+        for (char ch : pop)
+            chain.push_back(Op{ OP_POP, static_cast<uint8_t>(ch), 0 });
+        for (char ch : read)
+            chain.push_back(Op{ OP_READ, static_cast<uint8_t>(ch), 0 });
+        for (size_t k = push.size(); k-- > 0;)
+            chain.push_back(Op{ OP_PUSH, static_cast<uint8_t>(push[k]), 0 });
+        if (chain.empty())
+            chain.push_back(Op());
+
+        int state = from;
+        for (size_t k = 0; k < chain.size(); ++k) {
+            chain[k].to = k + 1 < chain.size() ? AddState() : to;
+            m_Ops[state].push_back(chain[k]);
+            state = chain[k].to;
+        }
+    }
+
+    // All states including the intermediate ones of the chains
+    int States() const { return static_cast<int>(m_Ops.size()); }
+    // States of the source automaton (added before the first transition)
+    int NamedStates() const { return m_Named; }
+    const std::vector<Transition>& Transitions() const { return m_Transitions; }
+    int Start() const { return m_Start; }
+    bool IsFinal(int state) const { return m_Final[state]; }
+    const std::vector<Op>& Ops(int state) const { return m_Ops[state]; }
+
+private:
+    std::vector<std::vector<Op>> m_Ops;
+    std::vector<bool> m_Final;
+    int m_Start = 0;
+    int m_Named = 0;
+    std::vector<Transition> m_Transitions;
+};
+
+struct PdaStats {
+    size_t configurations = 0;  // (state, position, stack node) processed
+    size_t nodes = 0;           // stack nodes
+    size_t edges = 0;           // node -> node below
+    size_t peak_layer = 0;      // most configurations at one input position
+    size_t bytes = 0;           // memory of the search structures (peak)
+};
+
+// Breadth-first run of a Pda over a graph-structured stack.
+//
+// Конфигурация - (состояние, позиция во входе, узел стека). Стеки всех ветвей
+// хранятся в общем графе: узел (символ X, позиция i, состояние q) - символ X,
+// положенный на позиции i с переходом в q; ребра ведут к узлам под ним.
+// Ветви, положившие один и тот же X в одном месте с одним итогом, делят узел,
+// даже если ниже у них разное содержимое: все, что происходит над X, от
+// содержимого ниже не зависит. Снятие X идет по всем ребрам сразу; снятия
+// запоминаются в узле, чтобы ребро, добавленное позже, получило их тоже
+// (как в GLL). Входные позиции обходятся по порядку, конфигурации и узлы
+// одной позиции различаются хэш-таблицами слоя. Узлов на позицию не больше
+// |Q|·|Г|, конфигураций на позицию - O(|Q|·узлы), то есть число конфигураций
+// полиномиально по длине входа, а не растет с числом ветвей.
+class PdaRunner {
+public:
+    explicit PdaRunner(const Pda& pda, int accept = PDA_FINAL_STATE)
+        : m_Pda(pda), m_Accept(accept)
+    {
+        m_First_op.assign(pda.States() + 1, 0);
+        for (int q = 0; q < pda.States(); ++q) {
+            m_First_op[q] = static_cast<int>(m_Ops.size());
+            m_Ops.insert(m_Ops.end(), pda.Ops(q).begin(), pda.Ops(q).end());
+        }
+        m_First_op[pda.States()] = static_cast<int>(m_Ops.size());
+    }
+
+    bool Run(const char* first, const char* last)
+    {
+        const unsigned char* input = reinterpret_cast<const unsigned char*>(first);
+        size_t length = static_cast<size_t>(last - first);
+
+        m_Nodes.clear();
+        m_Edges.clear();
+        m_Pops.clear();
+        m_Stats = PdaStats();
+
+        // Node 0 - below the bottom (empty stack), node 1 - the initial 'Z'
+        m_Nodes.push_back(Node{ -1, -1, -1 });
+        m_Nodes.push_back(Node{ static_cast<unsigned char>(Pda::BOTTOM), -1, -1 });
+        AddEdge(1, 0);
+
+        m_Current.clear();
+        m_Current_set.Clear();
+        m_Layer_nodes.Clear();
+        m_Layer_edges.Clear();
+        Add(m_Current, m_Current_set, m_Pda.Start(), 1);
+
+        bool accepted = false;
+        for (size_t i = 0;; ++i) {
+            bool at_end = i == length;
+            int symbol = at_end ? -1 : input[i];
+            m_Next.clear();
+            m_Next_set.Clear();
+
+            for (size_t k = 0; k < m_Current.size(); ++k) {
+                int q = m_Current[k].state;
+                int v = m_Current[k].node;
+                if (at_end && (m_Accept == PDA_EMPTY_STACK ? v == 0 : m_Pda.IsFinal(q))) {
+                    accepted = true;
+                    break;
+                }
+                for (int o = m_First_op[q]; o < m_First_op[q + 1]; ++o) {
+                    const Pda::Op& op = m_Ops[o];
+                    switch (op.kind) {
+                    case Pda::OP_EPSILON:
+                        Add(m_Current, m_Current_set, op.to, v);
+                        break;
+                    case Pda::OP_READ:
+                        if (op.symbol == symbol)
+                            Add(m_Next, m_Next_set, op.to, v);
+                        break;
+                    case Pda::OP_POP:
+                        if (m_Nodes[v].symbol == op.symbol) {
+                            m_Pops.push_back(Link{ op.to, m_Nodes[v].first_pop });
+                            m_Nodes[v].first_pop = static_cast<int>(m_Pops.size()) - 1;
+                            for (int e = m_Nodes[v].first_edge; e >= 0; e = m_Edges[e].next)
+                                Add(m_Current, m_Current_set, op.to, m_Edges[e].target);
+                        }
+                        break;
+                    case Pda::OP_PUSH:
+                        Push(op.symbol, op.to, v);
+                        break;
+                    }
+                }
+            }
+            m_Stats.configurations += m_Current.size();
+            if (m_Current.size() > m_Stats.peak_layer)
+                m_Stats.peak_layer = m_Current.size();
+            if (accepted || at_end || m_Next.empty())
+                break;
+
+            m_Current.swap(m_Next);
+            std::swap(m_Current_set, m_Next_set);
+            m_Layer_nodes.Clear();
+            m_Layer_edges.Clear();
+        }
+
+        m_Stats.nodes = m_Nodes.size();
+        m_Stats.edges = m_Edges.size();
+        size_t bytes = m_Nodes.capacity() * sizeof(Node) + m_Edges.capacity() * sizeof(Link) +
+                       m_Pops.capacity() * sizeof(Link) +
+                       (m_Current.capacity() + m_Next.capacity()) * sizeof(Configuration) +
+                       m_Current_set.Bytes() + m_Next_set.Bytes() + m_Layer_nodes.Bytes() + m_Layer_edges.Bytes();
+        if (bytes > m_Peak_bytes)
+            m_Peak_bytes = bytes;
+        m_Stats.bytes = m_Peak_bytes;
+        return accepted;
+    }
+
+    const PdaStats& Stats() const { return m_Stats; }
+
+private:
+    struct Configuration {
+        int state;
+        int node;
+    };
+
+    struct Node {
+        int symbol;                 // -1 for the node below the bottom
+        int first_edge;             // nodes below, -1 - none
+        int first_pop;              // states reached by popping this node
+    };
+
+    // Singly linked lists in flat arrays
+    struct Link {
+        int target;
+        int next;
+    };
+
+    void Add(std::vector<Configuration>& layer, LayerTable& set, int state, int node)
+    {
+        bool inserted;
+        set.FindOrInsert(static_cast<uint64_t>(state) << 32 | static_cast<uint32_t>(node), 0, inserted);
+        if (inserted)
+            layer.push_back(Configuration{ state, node });
+    }
+
+    bool AddEdge(int from, int to)
+    {
+        bool inserted;
+        m_Layer_edges.FindOrInsert(static_cast<uint64_t>(from) << 32 | static_cast<uint32_t>(to), 0, inserted);
+        if (inserted) {
+            m_Edges.push_back(Link{ to, m_Nodes[from].first_edge });
+            m_Nodes[from].first_edge = static_cast<int>(m_Edges.size()) - 1;
+        }
+        return inserted;
+    }
+
+    // `symbol` on top of node `below`, the automaton goes to `state`
+    void Push(int symbol, int state, int below)
+    {
+        bool created;
+        int node = m_Layer_nodes.FindOrInsert(static_cast<uint64_t>(state) << 8 | static_cast<uint64_t>(symbol),
+                                              static_cast<int>(m_Nodes.size()), created);
+        if (created)
+            m_Nodes.push_back(Node{ symbol, -1, -1 });
+        if (!AddEdge(node, below))
+            return;
+        if (created) {
+            Add(m_Current, m_Current_set, state, node);
+            return;
+        }
+        // The node was popped already: the new branch below gets the same
+        // continuations
+        for (int p = m_Nodes[node].first_pop; p >= 0; p = m_Pops[p].next)
+            Add(m_Current, m_Current_set, m_Pops[p].target, below);
+    }
+
+    const Pda& m_Pda;
+    int m_Accept;
+    std::vector<Pda::Op> m_Ops;             // ops of all states in a row
+    std::vector<int> m_First_op;
+
+    std::vector<Node> m_Nodes;
+    std::vector<Link> m_Edges;
+    std::vector<Link> m_Pops;
+
+    std::vector<Configuration> m_Current;   // configurations of the position
+    std::vector<Configuration> m_Next;      // of the next one
+    LayerTable m_Current_set;
+    LayerTable m_Next_set;
+    LayerTable m_Layer_nodes;               // (state, symbol) -> node pushed at the position
+    LayerTable m_Layer_edges;               // edges from the nodes of the position
+
+    PdaStats m_Stats;
+    size_t m_Peak_bytes = 0;
+};
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../common/grammar.hpp"
+
+// Grammar in Chomsky normal form: A -> BC and A -> a only (plus the flag for
+// the empty string). Переменные перенумерованы плотно 0..variables-1.
+struct CnfGrammar {
+    struct Binary {
+        int left;
+        int first;
+        int second;
+    };
+
+    int variables = 0;
+    int start = 0;
+    bool accepts_empty = false;
+    std::vector<std::string> names;
+    std::vector<Binary> binary;
+    std::array<std::vector<int>, 256> terminal;   // terminal[byte] - variables A with A -> byte
+};
+
+// Conversion to CNF: new start symbol, terminals of long rules moved into
+// their own variables, long rules split in two, ε-rules and unit rules
+// removed, useless variables dropped (порядок START, TERM, BIN, DEL, UNIT).
+inline CnfGrammar ToCnf(const Grammar& source)
+{
+    Grammar g = source;
+    using Rule = std::pair<int, std::vector<int>>;
+
+    // START
+    int start = g.AddFreshVariable("S0");
+    g.AddProduction(start, { source.Start() });
+    g.SetStart(start);
+
+    // TERM
+    std::array<int, 256> term_variable;
+    term_variable.fill(-1);
+    for (size_t i = 0; i < g.Productions().size(); ++i) {
+        if (g.Productions()[i].right.size() < 2)
+            continue;
+        for (size_t k = 0; k < g.Productions()[i].right.size(); ++k) {
+            int symbol = g.Productions()[i].right[k];
+            if (!Grammar::IsTerminal(symbol))
+                continue;
+            if (term_variable[symbol] < 0) {
+                term_variable[symbol] = g.AddFreshVariable(std::string("T") + static_cast<char>(symbol));
+                g.AddProduction(term_variable[symbol], { symbol });
+            }
+            g.Productions()[i].right[k] = term_variable[symbol];
+        }
+    }
+
+    // BIN
+    std::vector<Rule> rules;
+    for (const auto& p : g.Productions()) {
+        if (p.right.size() <= 2) {
+            rules.emplace_back(p.left, p.right);
+            continue;
+        }
+        int left = p.left;
+        for (size_t k = 0; k + 2 < p.right.size(); ++k) {
+            int rest = g.AddFreshVariable("X");
+            rules.emplace_back(left, std::vector<int>{ p.right[k], rest });
+            left = rest;
+        }
+        rules.emplace_back(left, std::vector<int>{ p.right[p.right.size() - 2], p.right.back() });
+    }
+
+    // DEL: nullable variables by fixpoint, then every nullable symbol of a
+    // binary rule may be dropped
+    int total = g.Variables();
+    std::vector<char> nullable(total, 0);
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (const auto& rule : rules) {
+            bool all = !nullable[Grammar::VariableIndex(rule.first)];
+            for (int symbol : rule.second)
+                all = all && !Grammar::IsTerminal(symbol) && nullable[Grammar::VariableIndex(symbol)];
+            if (all) {
+                nullable[Grammar::VariableIndex(rule.first)] = 1;
+                changed = true;
+            }
+        }
+    }
+
+    std::set<Rule> unique;
+    for (const auto& rule : rules) {
+        if (rule.second.empty())
+            continue;
+        unique.insert(rule);
+        if (rule.second.size() == 2) {
+            for (int k = 0; k < 2; ++k) {
+                int symbol = rule.second[k];
+                if (!Grammar::IsTerminal(symbol) && nullable[Grammar::VariableIndex(symbol)])
+                    unique.insert(Rule(rule.first, { rule.second[1 - k] }));
+            }
+        }
+    }
+
+    // UNIT: A =>* B by unit rules, then A gets every non-unit rule of B
+    std::vector<std::vector<char>> reach(total, std::vector<char>(total, 0));
+    for (int a = 0; a < total; ++a)
+        reach[a][a] = 1;
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (const auto& rule : unique) {
+            if (rule.second.size() != 1 || Grammar::IsTerminal(rule.second[0]))
+                continue;
+            int a = Grammar::VariableIndex(rule.first), b = Grammar::VariableIndex(rule.second[0]);
+            for (int x = 0; x < total; ++x) {
+                if (reach[x][a] && !reach[x][b]) {
+                    reach[x][b] = 1;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    std::set<Rule> cnf;
+    for (const auto& rule : unique) {
+        if (rule.second.size() == 1 && !Grammar::IsTerminal(rule.second[0]))
+            continue;
+        int b = Grammar::VariableIndex(rule.first);
+        for (int a = 0; a < total; ++a)
+            if (reach[a][b])
+                cnf.insert(Rule(Grammar::Variable(a), rule.second));
+    }
+
+    // Useless variables: not generating or not reachable from the start
+    std::vector<char> generating(total, 0), reachable(total, 0);
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (const auto& rule : cnf) {
+            bool all = !generating[Grammar::VariableIndex(rule.first)];
+            for (int symbol : rule.second)
+                all = all && (Grammar::IsTerminal(symbol) || generating[Grammar::VariableIndex(symbol)]);
+            if (all) {
+                generating[Grammar::VariableIndex(rule.first)] = 1;
+                changed = true;
+            }
+        }
+    }
+    reachable[Grammar::VariableIndex(start)] = 1;
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (const auto& rule : cnf) {
+            if (!reachable[Grammar::VariableIndex(rule.first)])
+                continue;
+            bool all = true;
+            for (int symbol : rule.second)
+                all = all && (Grammar::IsTerminal(symbol) || generating[Grammar::VariableIndex(symbol)]);
+            if (!all)
+                continue;
+            for (int symbol : rule.second) {
+                if (!Grammar::IsTerminal(symbol) && !reachable[Grammar::VariableIndex(symbol)]) {
+                    reachable[Grammar::VariableIndex(symbol)] = 1;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    CnfGrammar result;
+    std::vector<int> index(total, -1);
+    auto dense = [&](int symbol) {
+        int v = Grammar::VariableIndex(symbol);
+        if (index[v] < 0) {
+            index[v] = result.variables++;
+            result.names.push_back(g.VariableName(symbol));
+        }
+        return index[v];
+    };
+    result.start = dense(start);
+    result.accepts_empty = nullable[Grammar::VariableIndex(start)];
+
+    for (const auto& rule : cnf) {
+        int a = Grammar::VariableIndex(rule.first);
+        if (!reachable[a] || !generating[a])
+            continue;
+        if (rule.second.size() == 1) {
+            result.terminal[rule.second[0]].push_back(dense(rule.first));
+            continue;
+        }
+        int b = Grammar::VariableIndex(rule.second[0]), c = Grammar::VariableIndex(rule.second[1]);
+        if (!generating[b] || !generating[c])
+            continue;
+        result.binary.push_back({ dense(rule.first), dense(rule.second[0]), dense(rule.second[1]) });
+    }
+    return result;
+}
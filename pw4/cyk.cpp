@@ -0,0 +1,272 @@
+// CYK parser for the grammar of pw4 ("CFG (for CYK).jff").
+//
+//   cyk                         - the grammar of this work, a string is entered
+//                                 from the keyboard
+//   cyk <file.jff> [input]      - grammar from the file; with `input` every
+//                                 line of it is checked ('1' / '0')
+//   cyk --bench [file.jff]      - inputs of length 100, 1000 and 5000 against
+//                                 the set-based CYK
+//   cyk --bench-parallel [max_n] [file.jff]
+//                               - parallel CYK on 1..N threads and the
+//                                 row-by-row order, inputs of length 2000 to
+//                                 max_n (10000)
+
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../common/record_reader.hpp"
+#include "cyk.hpp"
+
+const char *DEFAULT_GRAMMAR = "CFG (for CYK).jff";
+
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::time_point from)
+{
+    return std::chrono::duration<double>(Clock::now() - from).count();
+}
+
+bool LoadCnf(const char *path, CnfGrammar &cnf)
+{
+    Grammar grammar;
+    std::string error;
+    if (!grammar.Load(path, &error))
+    {
+        std::fprintf(stderr, "%s: %s\n", path, error.c_str());
+        return false;
+    }
+    cnf = ToCnf(grammar);
+    return true;
+}
+
+// Textbook CYK: every cell is a std::set of variables, every split point
+// looks up all pairs (B, C); kept as the baseline for the benchmark
+bool NaiveCyk(const CnfGrammar &g, const std::string &input)
+{
+    int n = (int)input.size();
+    if (n == 0)
+        return g.accepts_empty;
+
+    std::map<std::pair<int, int>, std::vector<int>> heads;
+    for (const auto &rule : g.binary)
+        heads[{ rule.first, rule.second }].push_back(rule.left);
+
+    std::vector<std::vector<std::set<int>>> table(n, std::vector<std::set<int>>(n + 1));
+    for (int i = 0; i < n; ++i)
+        for (int a : g.terminal[(unsigned char)input[i]])
+            table[i][i + 1].insert(a);
+
+    for (int length = 2; length <= n; ++length)
+    {
+        for (int i = 0; i + length <= n; ++i)
+        {
+            int j = i + length;
+            for (int m = i + 1; m < j; ++m)
+            {
+                for (int b : table[i][m])
+                {
+                    for (int c : table[m][j])
+                    {
+                        auto it = heads.find({ b, c });
+                        if (it != heads.end())
+                            table[i][j].insert(it->second.begin(), it->second.end());
+                    }
+                }
+            }
+        }
+    }
+    return table[0][n].count(g.start) > 0;
+}
+
+// Random expression of the pw4 language with about `length` characters:
+// a=<operand> <op> <operand> ..., operands are numbers, variables, ~operand
+// and {expression}
+std::string RandomOperand(std::mt19937 &rng, int budget);
+
+std::string RandomExpression(std::mt19937 &rng, int budget)
+{
+    static const char *ops[] = { "|", "&", "^", "<<", ">>" };
+    std::string text = RandomOperand(rng, budget);
+    while ((int)text.size() < budget)
+        text += ops[rng() % 5] + RandomOperand(rng, budget - (int)text.size());
+    return text;
+}
+
+std::string RandomOperand(std::mt19937 &rng, int budget)
+{
+    int kind = (int)(rng() % 8);
+    if (kind == 0 && budget > 8)
+        return "{" + RandomExpression(rng, std::min(budget - 2, 4 + (int)(rng() % 40))) + "}";
+    if (kind == 1)
+        return "~" + RandomOperand(rng, budget - 1);
+    if (kind == 2)
+        return std::string(1, "abcdefghij"[rng() % 10]);
+    std::string number;
+    int digits = 1 + (int)(rng() % 4);
+    for (int i = 0; i < digits; ++i)
+        number += "01234"[rng() % 5];
+    return number;
+}
+
+// Statement of exactly n characters: padded with "|111..."
+std::string RandomInput(std::mt19937 &rng, int n)
+{
+    std::string input;
+    do
+        input = "a=" + RandomExpression(rng, n - 12);
+    while ((int)input.size() > n - 2);
+    return input + "|" + std::string(n - input.size() - 1, '1');
+}
+
+int RunBenchmark(const char *path)
+{
+    CnfGrammar cnf;
+    if (!LoadCnf(path, cnf))
+        return 1;
+    std::printf("%s: CNF with %d variables, %zu binary rules\n", path, cnf.variables, cnf.binary.size());
+
+    CykParser parser(cnf);
+    std::mt19937 rng(15);
+    for (int n : { 100, 1000, 5000 })
+    {
+        std::string input = RandomInput(rng, n);
+        // A broken copy: the result must be "rejected" but costs the same
+        std::string broken = input;
+        broken[n / 2] = '=';
+
+        for (const std::string *text : { &input, &broken })
+        {
+            auto begin = Clock::now();
+            bool fast = parser.Parse(text->data(), text->data() + text->size());
+            double t_fast = Seconds(begin);
+
+            parser.SetKernel(KERNEL_SCALAR);
+            begin = Clock::now();
+            bool scalar = parser.Parse(text->data(), text->data() + text->size());
+            double t_scalar = Seconds(begin);
+            parser.SetKernel(DetectSimdKernel());
+
+            std::printf("n = %4d %-9s bit-matrix: %9.3f ms (scalar %9.3f ms, arena %6.1f MB)",
+                        n, fast ? "accepted" : "rejected", t_fast * 1e3, t_scalar * 1e3,
+                        parser.ArenaBytes() / 1e6);
+            if (n <= 1000)
+            {
+                begin = Clock::now();
+                bool naive = NaiveCyk(cnf, *text);
+                double t_naive = Seconds(begin);
+                std::printf(" | set-based: %10.3f ms, speedup %7.1fx %s\n", t_naive * 1e3, t_naive / t_fast,
+                            naive == fast && scalar == fast ? "ok" : "MISMATCH");
+            }
+            else
+            {
+                std::printf(" | set-based: skipped (O(n^3) set operations)\n");
+            }
+        }
+    }
+    return 0;
+}
+
+// Anti-diagonal parallel CYK on 1, 2, 4, ... threads (up to the number of
+// cores, at least 2) and the row-by-row order, inputs of 2000 to max_n
+int RunParallelBenchmark(const char *path, int max_n)
+{
+    CnfGrammar cnf;
+    if (!LoadCnf(path, cnf))
+        return 1;
+    int cores = (int)std::thread::hardware_concurrency();
+    std::printf("%s: CNF with %d variables, %zu binary rules, %d hardware threads\n", path, cnf.variables,
+                cnf.binary.size(), cores);
+
+    std::vector<int> threads;
+    for (int t = 1; t < std::max(cores, 2); t *= 2)
+        threads.push_back(t);
+    threads.push_back(std::max(cores, 2));
+
+    CykParser parser(cnf);
+    std::mt19937 rng(16);
+    for (int n : { 2000, 5000, 10000 })
+    {
+        if (n > max_n)
+            break;
+        std::string input = RandomInput(rng, n);
+        const char *first = input.data(), *last = input.data() + input.size();
+
+        auto begin = Clock::now();
+        bool expected = parser.Parse(first, last);
+        double t_serial = Seconds(begin);
+        std::printf("n = %5d %-9s serial: %9.1f ms, arena %7.1f MB\n", n, expected ? "accepted" : "rejected",
+                    t_serial * 1e3, parser.ArenaBytes() / 1e6);
+
+        double t_one = 0;
+        for (int t : threads)
+        {
+            WorkPool pool(t);
+            begin = Clock::now();
+            bool result = parser.ParseParallel(first, last, pool);
+            double seconds = Seconds(begin);
+            if (t == 1)
+                t_one = seconds;
+            std::printf("          %2d thread(s): %9.1f ms, speedup %5.2fx %s\n", t, seconds * 1e3,
+                        t_one / seconds, result == expected ? "ok" : "MISMATCH");
+        }
+
+        begin = Clock::now();
+        bool result = parser.ParseByRows(first, last);
+        double t_rows = Seconds(begin);
+        std::printf("          by rows:      %9.1f ms, %5.2fx of serial %s\n", t_rows * 1e3, t_serial / t_rows,
+                    result == expected ? "ok" : "MISMATCH");
+    }
+    return 0;
+}
+
+int Run(const char *path, const char *input)
+{
+    CnfGrammar cnf;
+    if (!LoadCnf(path, cnf))
+        return 1;
+    CykParser parser(cnf);
+
+    if (input)
+    {
+        RecordReader reader;
+        std::string message;
+        if (!reader.Open(input, &message))
+        {
+            std::fprintf(stderr, "%s\n", message.c_str());
+            return 1;
+        }
+        std::string_view line;
+        while (reader.Next(line))
+            std::fputs(parser.Parse(line.data(), line.data() + line.size()) ? "1\n" : "0\n", stdout);
+        return 0;
+    }
+
+    std::cout << "Enter a string:\nPress Enter Key to stop\n";
+    std::string line;
+    std::getline(std::cin, line);
+    if (parser.Parse(line.data(), line.data() + line.size()))
+        std::cout << "\nAccepted! The string is generated by the grammar.\n";
+    else
+        std::cout << "\nRejected! The string is not generated by the grammar.\n";
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0)
+        return RunBenchmark(argc > 2 ? argv[2] : DEFAULT_GRAMMAR);
+    if (argc > 1 && std::strcmp(argv[1], "--bench-parallel") == 0)
+        return RunParallelBenchmark(argc > 3 ? argv[3] : DEFAULT_GRAMMAR, argc > 2 ? std::atoi(argv[2]) : 10000);
+
+    return Run(argc > 1 ? argv[1] : DEFAULT_GRAMMAR, argc > 2 ? argv[2] : nullptr);
+}
@@ -0,0 +1,336 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "../common/work_pool.hpp"
+#include "../pw1/dfa_simd.hpp"
+#include "cnf.hpp"
+
+// CYK over a grammar in CNF.
+//
+// Клетка таблицы (i, j) - битовое множество переменных, выводящих input[i, j).
+// Вся треугольная таблица лежит в одном массиве (клетки упорядочены по длине
+// отрезка). Для перебора точек разбиения есть еще две битовые матрицы:
+// Row(i, B) - множество концов m, для которых B выводит [i, m), Col(j, C) -
+// множество начал m, для которых C выводит [m, j). Правило A -> BC дает A в
+// клетке (i, j), если Row(i, B) & Col(j, C) != 0, т.е. проверка всех точек
+// разбиения сразу - это AND двух битовых строк (AVX2: 256 точек за инструкцию).
+// Для каждой строки матриц хранится диапазон ненулевых слов, AND идет только
+// по пересечению диапазонов. Память выделяется один раз под наибольшую длину входа и переиспользуется.
+class CykParser {
+    // Words [first, last) of a split-point row that have any bits set
+    struct Range {
+        int first = INT32_MAX;
+        int last = 0;
+
+        void Add(int word)
+        {
+            first = std::min(first, word);
+            last = std::max(last, word + 1);
+        }
+    };
+
+public:
+    explicit CykParser(const CnfGrammar& grammar, int kernel = DetectSimdKernel())
+        : m_Grammar(grammar), m_Var_words((grammar.variables + 63) / 64)
+    {
+        SetKernel(kernel);
+
+        // Binary rules grouped by their left side
+        m_Rules = grammar.binary;
+        std::sort(m_Rules.begin(), m_Rules.end(), [](const CnfGrammar::Binary& x, const CnfGrammar::Binary& y) {
+            return x.left < y.left;
+        });
+
+        // The same rules grouped by the first symbol of the right side
+        m_By_first = grammar.binary;
+        std::sort(m_By_first.begin(), m_By_first.end(), [](const CnfGrammar::Binary& x, const CnfGrammar::Binary& y) {
+            return x.first < y.first;
+        });
+        m_First_begin.assign(grammar.variables + 1, 0);
+        for (const auto& rule : m_By_first)
+            ++m_First_begin[rule.first + 1];
+        for (int b = 0; b < grammar.variables; ++b)
+            m_First_begin[b + 1] += m_First_begin[b];
+
+        m_Terminal_cells.assign(256 * static_cast<size_t>(m_Var_words), 0);
+        for (int byte = 0; byte < 256; ++byte)
+            for (int a : grammar.terminal[byte])
+                m_Terminal_cells[byte * static_cast<size_t>(m_Var_words) + a / 64] |= 1ull << (a % 64);
+    }
+
+    // The split-point test has scalar and AVX2 versions (AVX-512 CPUs use AVX2)
+    void SetKernel(int kernel) { m_Kernel = kernel > KERNEL_AVX2 ? KERNEL_AVX2 : kernel; }
+    int Kernel() const { return m_Kernel; }
+
+    const CnfGrammar& Grammar() const { return m_Grammar; }
+
+    bool Parse(const char* first, const char* last)
+    {
+        if (!Prepare(first, last))
+            return m_Grammar.accepts_empty;
+        int n = m_Length;
+        for (int length = 2; length <= n; ++length)
+            for (int i = 0; i + length <= n; ++i)
+                FillCell(i, i + length);
+        return Has(0, n, m_Grammar.start);
+    }
+
+    // The same chart, the cells of every diagonal (one span length) are
+    // split between the threads of the pool. A cell (i, j) writes only its own
+    // chart entry, Row(i, ·) and Col(j, ·), and reads only shorter spans, so the
+    // cells of one diagonal do not conflict
+    bool ParseParallel(const char* first, const char* last, WorkPool& pool)
+    {
+        if (!Prepare(first, last))
+            return m_Grammar.accepts_empty;
+        int n = m_Length;
+        for (int length = 2; length <= n; ++length) {
+            // Long spans cost more per cell: smaller pieces keep the threads busy
+            int cells = n - length + 1;
+            int grain = std::max(1, std::min(cells / (4 * pool.Threads()), 4096 / length));
+            pool.ParallelFor(0, cells, grain, [this, length](int from, int to) {
+                for (int i = from; i < to; ++i)
+                    FillCell(i, i + length);
+            });
+        }
+        return Has(0, n, m_Grammar.start);
+    }
+
+    // Valiant-style order: the chart is built row by row as products of
+    // boolean matrices instead of cell by cell.
+    // Строки i идут от конца входа к началу; в строке i концы m идут по
+    // возрастанию. Когда дошли до m, клетка (i, m) уже окончательна (все ее
+    // точки разбиения меньше m), и для каждой B из нее и правила A -> BC
+    // строка Row(i, A) |= Row(m, C) - OR целых битовых строк вместо проверки
+    // отдельных точек разбиения.
+    bool ParseByRows(const char* first, const char* last)
+    {
+        if (!Prepare(first, last))
+            return m_Grammar.accepts_empty;
+        int n = m_Length;
+        for (int i = n - 2; i >= 0; --i) {
+            for (int m = i + 1; m < n; ++m) {
+                uint64_t* cell = Cell(i, m);
+                for (int b = 0; b < m_Grammar.variables; ++b)
+                    if ((Row(i, b)[m / 64] >> (m % 64)) & 1)
+                        cell[b / 64] |= 1ull << (b % 64);
+
+                for (int w = 0; w < m_Var_words; ++w) {
+                    for (uint64_t bits = cell[w]; bits; bits &= bits - 1) {
+                        int b = w * 64 + __builtin_ctzll(bits);
+                        for (int r = m_First_begin[b]; r < m_First_begin[b + 1]; ++r) {
+                            const CnfGrammar::Binary& rule = m_By_first[r];
+                            const Range& source = m_Row_range[static_cast<size_t>(m) * m_Grammar.variables + rule.second];
+                            if (source.first >= source.last)
+                                continue;
+                            const uint64_t* from = Row(m, rule.second);
+                            uint64_t* to = Row(i, rule.left);
+                            for (int k = source.first; k < source.last; ++k)
+                                to[k] |= from[k];
+                            Range& target = m_Row_range[static_cast<size_t>(i) * m_Grammar.variables + rule.left];
+                            target.Add(source.first);
+                            target.Add(source.last - 1);
+                        }
+                    }
+                }
+            }
+            // The row has no split points left: spans [i, n)
+            uint64_t* cell = Cell(i, n);
+            for (int a = 0; a < m_Grammar.variables; ++a)
+                if ((Row(i, a)[n / 64] >> (n % 64)) & 1)
+                    cell[a / 64] |= 1ull << (a % 64);
+        }
+        return Has(0, n, m_Grammar.start);
+    }
+
+    int Length() const { return m_Length; }
+
+    // Variables deriving input[i, j), 0 <= i < j <= Length()
+    const uint64_t* Cell(int i, int j) const
+    {
+        return m_Chart.data() + CellIndex(i, j) * m_Var_words;
+    }
+
+    bool Has(int i, int j, int variable) const
+    {
+        return (Cell(i, j)[variable / 64] >> (variable % 64)) & 1;
+    }
+
+    // Memory of the chart and of both split-point matrices
+    size_t ArenaBytes() const
+    {
+        return (m_Chart.size() + m_Row.size() + m_Col.size()) * sizeof(uint64_t);
+    }
+
+private:
+    // Clears the arena for the input and fills the spans of length 1;
+    // false for the empty input
+    bool Prepare(const char* first, const char* last)
+    {
+        int n = static_cast<int>(last - first);
+        Reserve(n);
+        if (n == 0)
+            return false;
+
+        std::fill(m_Chart.begin(), m_Chart.begin() + ChartWords(n), 0);
+        std::fill(m_Row.begin(), m_Row.begin() + MatrixWords(n), 0);
+        std::fill(m_Col.begin(), m_Col.begin() + MatrixWords(n), 0);
+        std::fill(m_Row_range.begin(), m_Row_range.begin() + RangeCount(n), Range());
+        std::fill(m_Col_range.begin(), m_Col_range.begin() + RangeCount(n), Range());
+
+        for (int i = 0; i < n; ++i) {
+            const uint64_t* cell = &m_Terminal_cells[static_cast<unsigned char>(first[i]) * static_cast<size_t>(m_Var_words)];
+            std::copy(cell, cell + m_Var_words, Cell(i, i + 1));
+            Publish(i, i + 1);
+        }
+        return true;
+    }
+
+    // Cell (i, j) from the finished shorter spans
+    void FillCell(int i, int j)
+    {
+        uint64_t* cell = Cell(i, j);
+        int word_first = (i + 1) / 64, word_last = (j - 1) / 64 + 1;
+
+        for (size_t r = 0; r < m_Rules.size();) {
+            int a = m_Rules[r].left;
+            bool found = false;
+            for (; r < m_Rules.size() && m_Rules[r].left == a; ++r) {
+                if (found)
+                    continue;
+                // Only the words where both rows have bits at all
+                int b = m_Rules[r].first, c = m_Rules[r].second;
+                const Range& row = m_Row_range[static_cast<size_t>(i) * m_Grammar.variables + b];
+                const Range& col = m_Col_range[static_cast<size_t>(j) * m_Grammar.variables + c];
+                int from = std::max(word_first, std::max(row.first, col.first));
+                int to = std::min(word_last, std::min(row.last, col.last));
+                if (from < to && Intersects(Row(i, b), Col(j, c), from, to))
+                    found = true;
+            }
+            if (found)
+                cell[a / 64] |= 1ull << (a % 64);
+        }
+        Publish(i, j);
+    }
+
+    void Reserve(int n)
+    {
+        m_Length = n;
+        m_Pos_words = (n + 1 + 63) / 64;
+        if (ChartWords(n) > m_Chart.size())
+            m_Chart.resize(ChartWords(n));
+        if (MatrixWords(n) > m_Row.size()) {
+            m_Row.resize(MatrixWords(n));
+            m_Col.resize(MatrixWords(n));
+        }
+        if (RangeCount(n) > m_Row_range.size()) {
+            m_Row_range.resize(RangeCount(n));
+            m_Col_range.resize(RangeCount(n));
+        }
+    }
+
+    size_t RangeCount(int n) const
+    {
+        return static_cast<size_t>(n + 1) * m_Grammar.variables;
+    }
+
+    size_t ChartWords(int n) const
+    {
+        return static_cast<size_t>(n) * (n + 1) / 2 * m_Var_words;
+    }
+
+    size_t MatrixWords(int n) const
+    {
+        return static_cast<size_t>(n + 1) * m_Grammar.variables * ((n + 1 + 63) / 64);
+    }
+
+    // Cells are stored by span length: all spans of length 1, then 2, ...
+    size_t CellIndex(int i, int j) const
+    {
+        size_t length = j - i;
+        size_t before = (length - 1) * (m_Length + 1) - (length - 1) * length / 2;
+        return before + i;
+    }
+
+    uint64_t* Cell(int i, int j)
+    {
+        return m_Chart.data() + CellIndex(i, j) * m_Var_words;
+    }
+
+    uint64_t* Row(int i, int variable)
+    {
+        return m_Row.data() + (static_cast<size_t>(i) * m_Grammar.variables + variable) * m_Pos_words;
+    }
+
+    uint64_t* Col(int j, int variable)
+    {
+        return m_Col.data() + (static_cast<size_t>(j) * m_Grammar.variables + variable) * m_Pos_words;
+    }
+
+    // Copies the finished cell (i, j) into the split-point matrices
+    void Publish(int i, int j)
+    {
+        const uint64_t* cell = Cell(i, j);
+        for (int w = 0; w < m_Var_words; ++w) {
+            for (uint64_t bits = cell[w]; bits; bits &= bits - 1) {
+                int a = w * 64 + __builtin_ctzll(bits);
+                Row(i, a)[j / 64] |= 1ull << (j % 64);
+                Col(j, a)[i / 64] |= 1ull << (i % 64);
+                m_Row_range[static_cast<size_t>(i) * m_Grammar.variables + a].Add(j / 64);
+                m_Col_range[static_cast<size_t>(j) * m_Grammar.variables + a].Add(i / 64);
+            }
+        }
+    }
+
+    // (x & y) != 0 on words [first, last). Split points outside of (i, j)
+    // are always 0 here: those cells are longer and not filled yet
+    bool Intersects(const uint64_t* x, const uint64_t* y, int first, int last) const
+    {
+#ifdef DFA_SIMD_X86
+        if (m_Kernel != KERNEL_SCALAR)
+            return IntersectsAvx2(x, y, first, last);
+#endif
+        for (int w = first; w < last; ++w)
+            if (x[w] & y[w])
+                return true;
+        return false;
+    }
+
+#ifdef DFA_SIMD_X86
+    __attribute__((target("avx2")))
+    static bool IntersectsAvx2(const uint64_t* x, const uint64_t* y, int first, int last)
+    {
+        int w = first;
+        for (; w + 4 <= last; w += 4) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + w));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + w));
+            if (!_mm256_testz_si256(a, b))
+                return true;
+        }
+        for (; w < last; ++w)
+            if (x[w] & y[w])
+                return true;
+        return false;
+    }
+#endif
+
+    CnfGrammar m_Grammar;
+    std::vector<CnfGrammar::Binary> m_Rules;   // sorted by the left side
+    std::vector<CnfGrammar::Binary> m_By_first;   // sorted by the first symbol of the right side
+    std::vector<int> m_First_begin;            // rules of B: m_By_first[m_First_begin[B], m_First_begin[B + 1])
+    std::vector<uint64_t> m_Terminal_cells;    // cell of length 1 for every byte
+    int m_Var_words;
+    int m_Pos_words = 1;
+    int m_Length = 0;
+    int m_Kernel = KERNEL_SCALAR;
+
+    std::vector<uint64_t> m_Chart;             // triangular chart, m_Var_words per cell
+    std::vector<uint64_t> m_Row;               // Row(i, B): ends m of B-spans [i, m)
+    std::vector<uint64_t> m_Col;               // Col(j, C): starts m of C-spans [m, j)
+    std::vector<Range> m_Row_range;            // non-zero words of every Row(i, B)
+    std::vector<Range> m_Col_range;            // non-zero words of every Col(j, C)
+};
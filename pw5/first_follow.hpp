@@ -0,0 +1,103 @@
+#pragma once
+
+#include <bitset>
+#include <vector>
+
+#include "../common/grammar.hpp"
+
+// FIRST and FOLLOW sets of a grammar (for the LL(1) and LR tables).
+// Множества - битовые строки по байтам; бит END в FIRST означает, что строка
+// выводит ε, в FOLLOW - конец входа ($). Считаются итерацией до неподвижной
+// точки.
+class FirstFollow {
+public:
+    static constexpr int END = 256;
+    using Set = std::bitset<257>;
+
+    void Build(const Grammar& grammar)
+    {
+        ComputeFirst(grammar);
+        ComputeFollow(grammar);
+    }
+
+    const Set& First(int variable) const { return m_First[variable]; }
+    const Set& Follow(int variable) const { return m_Follow[variable]; }
+
+    // FIRST of the symbols [first, last), END if all of them derive ε
+    Set FirstOf(const int* first, const int* last) const
+    {
+        Set result;
+        for (; first != last; ++first) {
+            if (Grammar::IsTerminal(*first)) {
+                result[*first] = true;
+                return result;
+            }
+            Set set = m_First[Grammar::VariableIndex(*first)];
+            bool nullable = set[END];
+            set[END] = false;
+            result |= set;
+            if (!nullable)
+                return result;
+        }
+        result[END] = true;
+        return result;
+    }
+
+    Set FirstOf(const std::vector<int>& symbols) const
+    {
+        return FirstOf(symbols.data(), symbols.data() + symbols.size());
+    }
+
+private:
+    void ComputeFirst(const Grammar& grammar)
+    {
+        m_First.assign(grammar.Variables(), Set());
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (const auto& p : grammar.Productions()) {
+                Set& target = m_First[Grammar::VariableIndex(p.left)];
+                Set updated = target | FirstOf(p.right);
+                if (updated != target) {
+                    target = updated;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    void ComputeFollow(const Grammar& grammar)
+    {
+        m_Follow.assign(grammar.Variables(), Set());
+        m_Follow[Grammar::VariableIndex(grammar.Start())][END] = true;
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (const auto& p : grammar.Productions()) {
+                // Walk the right side backwards keeping FOLLOW of the suffix
+                Set tail = m_Follow[Grammar::VariableIndex(p.left)];
+                for (size_t k = p.right.size(); k-- > 0;) {
+                    int symbol = p.right[k];
+                    if (Grammar::IsTerminal(symbol)) {
+                        tail.reset();
+                        tail[symbol] = true;
+                        continue;
+                    }
+                    Set& follow = m_Follow[Grammar::VariableIndex(symbol)];
+                    if ((follow | tail) != follow) {
+                        follow |= tail;
+                        changed = true;
+                    }
+                    Set first = m_First[Grammar::VariableIndex(symbol)];
+                    if (first[END]) {
+                        first[END] = false;
+                        tail |= first;
+                    } else {
+                        tail = first;
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<Set> m_First;
+    std::vector<Set> m_Follow;
+};
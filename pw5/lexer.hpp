@@ -0,0 +1,532 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../pw1/dfa_simd.hpp"
+#include "../pw2/regex.hpp"
+
+// One lexeme: where it starts (offset from the start of the tokenized text)
+// and its kind; the length is not stored, Lexer::Length() finds it again
+struct Token {
+    uint32_t offset;
+    int32_t kind;
+};
+
+// Lexer generated from token definitions.
+//
+// Каждое определение - регулярное выражение в синтаксисе JFLAP (regex.hpp),
+// строка-литерал или класс из одного байта. Позиции всех выражений (как в
+// построении Глушкова, но с множеством байтов на позицию) сводятся в один ДКА
+// подмножеств; байты с одинаковыми столбцами объединяются в классы. Разбор -
+// самое длинное совпадение, при равной длине побеждает определение, добавленное
+// раньше. Байты из множества пропусков между лексемами пропускаются (AVX2 -
+// 32 байта за шаг), байт, с которого не начинается ни одна лексема, дает
+// лексему ERROR длины 1. Лексемы, которые всегда состоят из одного байта,
+// выдаются по таблице без прохода по ДКА. Если таких лексем и пропусков в
+// тексте подряд много (как в грамматике recursive_descent.cpp, где все
+// лексемы однобайтовые), они классифицируются блоком: код байта - вид
+// лексемы, пропуск или "нужен ДКА". AVX2 берет код pshufb из таблицы строки
+// старшего полубайта (по строке на каждый полубайт, где есть не только "нужен
+// ДКА"), 32 байта за шаг, и выписывает лексемы до первого байта "нужен ДКА"
+// по 8 без ветвлений (индексы установленных битов маски - из таблицы на 256
+// масок). AVX-512 VBMI берет код двумя vpermb из таблицы на 256 байтов, 64
+// байта за шаг, сжимает смещения и коды лексем vpcompressb и собирает из них
+// по 8 лексем одной перестановкой байтов.
+class Lexer {
+public:
+    static constexpr int32_t ERROR = -1;
+    static constexpr size_t MAX_TEXT = UINT32_MAX;      // longest text for Token::offset
+    static constexpr size_t TOO_LONG = SIZE_MAX;        // Tokenize() of a longer text
+
+    explicit Lexer(int kernel = DetectSimdKernel()) { SetKernel(kernel); }
+
+    bool AddRegex(int kind, const std::string& expression, std::string* error = nullptr)
+    {
+        Regex re;
+        if (!re.Parse(expression, error))
+            return false;
+        GlushkovSets sets = ComputeGlushkov(re);
+        if (sets.nullable)
+            return Fail(error, "token " + std::to_string(kind) + " matches the empty string");
+
+        int offset = static_cast<int>(m_Positions.size()) - 1;
+        for (int p = 1; p <= sets.Positions(); ++p) {
+            Position position;
+            position.bytes[static_cast<unsigned char>(sets.symbol[p])] = true;
+            for (int q : sets.follow[p])
+                position.follow.push_back(offset + q);
+            m_Positions.push_back(position);
+        }
+        for (int q : sets.first)
+            m_First.push_back(offset + q);
+        for (int q : sets.last)
+            m_Positions[offset + q].token = static_cast<int>(m_Kinds.size());
+        m_Kinds.push_back(kind);
+        return true;
+    }
+
+    void AddLiteral(int kind, const std::string& text)
+    {
+        if (text.empty())
+            return;
+        int first = static_cast<int>(m_Positions.size());
+        for (size_t k = 0; k < text.size(); ++k) {
+            Position position;
+            position.bytes[static_cast<unsigned char>(text[k])] = true;
+            if (k + 1 < text.size())
+                position.follow.push_back(first + static_cast<int>(k) + 1);
+            m_Positions.push_back(position);
+        }
+        m_First.push_back(first);
+        m_Positions.back().token = static_cast<int>(m_Kinds.size());
+        m_Kinds.push_back(kind);
+    }
+
+    // A token of one byte from `bytes`
+    void AddClass(int kind, const std::string& bytes)
+    {
+        Position position;
+        for (char ch : bytes)
+            position.bytes[static_cast<unsigned char>(ch)] = true;
+        position.token = static_cast<int>(m_Kinds.size());
+        m_First.push_back(static_cast<int>(m_Positions.size()));
+        m_Positions.push_back(position);
+        m_Kinds.push_back(kind);
+    }
+
+    // Bytes skipped between tokens (may still occur inside tokens)
+    void SetSkip(const std::string& bytes)
+    {
+        for (int b = 0; b < 256; ++b)
+            m_Skip[b] = false;
+        for (char ch : bytes)
+            m_Skip[static_cast<unsigned char>(ch)] = true;
+        std::fill(m_Stop_low, m_Stop_low + 16, 0);
+        std::fill(m_Stop_high, m_Stop_high + 16, 0);
+        for (int b = 0; b < 256; ++b)
+            if (!m_Skip[b])
+                (b < 128 ? m_Stop_low : m_Stop_high)[b & 15] |= static_cast<uint8_t>(1 << ((b >> 4) & 7));
+        if (m_States > 0)
+            BuildCodes();
+    }
+
+    // Subset construction over the positions of all definitions
+    bool Compile(std::string* error = nullptr)
+    {
+        if (m_Kinds.empty())
+            return Fail(error, "no token definitions");
+
+        // State 0 - dead, state 1 - start (set of no positions read yet)
+        std::vector<std::vector<int>> sets = { {}, {} };
+        std::map<std::vector<int>, int> index;
+        std::vector<int> next_by_byte;
+        m_Accept.assign(2, ERROR);
+        for (size_t s = 1; s < sets.size(); ++s) {
+            std::vector<int> successors;
+            if (s == 1) {
+                successors = m_First;
+            } else {
+                for (int p : sets[s])
+                    successors.insert(successors.end(), m_Positions[p].follow.begin(), m_Positions[p].follow.end());
+            }
+            std::sort(successors.begin(), successors.end());
+            successors.erase(std::unique(successors.begin(), successors.end()), successors.end());
+
+            next_by_byte.resize((s + 1) * 256, 0);
+            for (int b = 0; b < 256; ++b) {
+                std::vector<int> target;
+                for (int q : successors)
+                    if (m_Positions[q].bytes[b])
+                        target.push_back(q);
+                if (target.empty())
+                    continue;
+                auto found = index.find(target);
+                int t;
+                if (found == index.end()) {
+                    t = static_cast<int>(sets.size());
+                    index.emplace(target, t);
+                    sets.push_back(target);
+                    // Earliest definition among the finished ones
+                    int token = -1;
+                    for (int q : target)
+                        if (m_Positions[q].token >= 0 && (token < 0 || m_Positions[q].token < token))
+                            token = m_Positions[q].token;
+                    m_Accept.push_back(token < 0 ? ERROR : m_Kinds[token]);
+                } else {
+                    t = found->second;
+                }
+                next_by_byte[s * 256 + b] = t;
+            }
+        }
+        int states = static_cast<int>(sets.size());
+        next_by_byte.resize(static_cast<size_t>(states) * 256, 0);
+
+        // Byte classes: bytes with equal columns
+        std::map<std::vector<int>, int> columns;
+        m_Classes = 0;
+        for (int b = 0; b < 256; ++b) {
+            std::vector<int> column(states);
+            for (int s = 0; s < states; ++s)
+                column[s] = next_by_byte[static_cast<size_t>(s) * 256 + b];
+            auto inserted = columns.emplace(column, m_Classes);
+            if (inserted.second)
+                ++m_Classes;
+            m_Class[b] = static_cast<uint8_t>(inserted.first->second);
+        }
+        m_Next.assign(static_cast<size_t>(states) * m_Classes, 0);
+        for (int s = 0; s < states; ++s)
+            for (int b = 0; b < 256; ++b)
+                m_Next[static_cast<size_t>(s) * m_Classes + m_Class[b]] = next_by_byte[static_cast<size_t>(s) * 256 + b];
+
+        // Tokens that can only be one byte long
+        for (int b = 0; b < 256; ++b) {
+            int t = next_by_byte[256 + b];
+            bool final = t != 0;
+            for (int c = 0; c < m_Classes && final; ++c)
+                final = m_Next[static_cast<size_t>(t) * m_Classes + c] == 0;
+            m_Single[b] = final ? m_Accept[t] : ERROR;
+        }
+        m_States = states;
+        BuildCodes();
+        return true;
+    }
+
+    // Tokens of [first, last) into `out`, offsets from `first`; returns their
+    // number. Every token takes a byte at least, so `out` needs room for
+    // last - first tokens. Offsets are 32-bit: a text over MAX_TEXT bytes is
+    // not tokenized, the result is TOO_LONG
+    size_t Tokenize(const char* first, const char* last, Token* out) const
+    {
+        Token* begin = out;
+        size_t length = static_cast<size_t>(last - first);
+        if (length > MAX_TEXT)
+            return TOO_LONG;
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(first);
+
+        size_t i = 0;
+        while (i < length) {
+#ifdef DFA_SIMD_X86
+            if (m_Simd && m_Kernel != KERNEL_SCALAR) {
+                if (m_Kernel == KERNEL_AVX512_VBMI && length - i >= 64)
+                    i = TokenizeAvx512(data, i, length, out);
+                else if (length - i >= 32)
+                    i = TokenizeAvx2(data, i, length, out);
+                if (i == length)
+                    break;
+            }
+#endif
+            if (m_Skip[data[i]]) {
+                i = SkipFrom(data, i + 1, length);
+                if (i == length)
+                    break;
+            }
+            int32_t single = m_Single[data[i]];
+            if (single != ERROR) {
+                *out++ = { static_cast<uint32_t>(i), single };
+                ++i;
+                continue;
+            }
+            int32_t kind;
+            size_t end = Match(data, i, length, kind);
+            *out++ = { static_cast<uint32_t>(i), kind };
+            i = end;
+        }
+        return static_cast<size_t>(out - begin);
+    }
+
+    // Length of a token Tokenize() gave for [first, last)
+    size_t Length(const char* first, const char* last, const Token& token) const
+    {
+        if (m_Single[static_cast<unsigned char>(first[token.offset])] != ERROR)
+            return 1;
+        int32_t kind;
+        return Match(reinterpret_cast<const unsigned char*>(first), token.offset,
+                     static_cast<size_t>(last - first), kind) - token.offset;
+    }
+
+    // The same into tokens[0, returned); the vector only grows, so a reused
+    // one is not cleared again
+    size_t Tokenize(const char* first, const char* last, std::vector<Token>& tokens) const
+    {
+        if (static_cast<size_t>(last - first) > MAX_TEXT)
+            return TOO_LONG;
+        if (tokens.size() < static_cast<size_t>(last - first))
+            tokens.resize(static_cast<size_t>(last - first));
+        return Tokenize(first, last, tokens.data());
+    }
+
+    // The whitespace skip has scalar and AVX2 versions (AVX-512 CPUs use
+    // AVX2), the one-byte tokens - AVX-512 VBMI too (with VBMI2 for the byte
+    // compress, else AVX2)
+    void SetKernel(int kernel)
+    {
+        m_Kernel = kernel;
+#ifdef DFA_SIMD_X86
+        __builtin_cpu_init();
+        if (kernel == KERNEL_AVX512_VBMI && !__builtin_cpu_supports("avx512vbmi2"))
+            m_Kernel = KERNEL_AVX2;
+#endif
+    }
+    int Kernel() const { return m_Kernel; }
+
+    int States() const { return m_States; }
+    int Classes() const { return m_Classes; }
+
+private:
+    struct Position {
+        std::bitset<256> bytes;
+        std::vector<int> follow;
+        int token = -1;             // index into m_Kinds if a definition can end here
+    };
+
+    // Codes of the AVX2 classification besides the kind of a one-byte token
+    static constexpr uint8_t CODE_SKIP = 0xff;
+    static constexpr uint8_t CODE_DFA = 0xfe;
+
+    // Longest match from `from`: its end, the kind (ERROR and from + 1 if no
+    // token starts there)
+    size_t Match(const unsigned char* data, size_t from, size_t length, int32_t& kind) const
+    {
+        int state = 1;
+        kind = ERROR;
+        size_t end = from + 1;
+        for (size_t k = from; k < length; ++k) {
+            state = m_Next[static_cast<size_t>(state) * m_Classes + m_Class[data[k]]];
+            if (state == 0)
+                break;
+            if (m_Accept[state] != ERROR) {
+                kind = m_Accept[state];
+                end = k + 1;
+            }
+        }
+        return kind == ERROR ? from + 1 : end;
+    }
+
+    // Byte codes for the AVX2 classification, by rows of the high nibble;
+    // rows of CODE_DFA only are not looked up
+    void BuildCodes()
+    {
+        m_Simd = m_States > 0;
+        m_Rows = 0;
+        for (int row = 0; row < 16; ++row) {
+            bool used = false;
+            for (int low = 0; low < 16; ++low) {
+                int b = row << 4 | low;
+                uint8_t code = CODE_DFA;
+                if (m_Skip[b])
+                    code = CODE_SKIP;
+                else if (m_Single[b] >= 0 && m_Single[b] < CODE_DFA)
+                    code = static_cast<uint8_t>(m_Single[b]);
+                else if (m_Single[b] != ERROR)
+                    m_Simd = false;     // the kind does not fit a code
+                m_Code[m_Rows][low] = m_Byte_code[b] = code;
+                used = used || code != CODE_DFA;
+            }
+            if (used)
+                m_Row[m_Rows++] = static_cast<uint8_t>(row);
+        }
+    }
+
+    // Indexes of the set bits of every 8-bit mask, in order
+    static const uint64_t* CompressTable()
+    {
+        static const std::array<uint64_t, 256> table = [] {
+            std::array<uint64_t, 256> t = {};
+            for (int mask = 0; mask < 256; ++mask)
+                for (int bit = 0, n = 0; bit < 8; ++bit)
+                    if (mask >> bit & 1)
+                        t[mask] |= static_cast<uint64_t>(bit) << (8 * n++);
+            return t;
+        }();
+        return table.data();
+    }
+
+    // First byte at or after `from` that is not skipped. Most gaps are a
+    // byte or two, so the first bytes are checked one by one, and only a
+    // longer run goes to the 32-byte AVX2 loop
+    size_t SkipFrom(const unsigned char* data, size_t from, size_t to) const
+    {
+        for (size_t stop = std::min(to, from + 8); from < stop; ++from)
+            if (!m_Skip[data[from]])
+                return from;
+#ifdef DFA_SIMD_X86
+        if (m_Kernel != KERNEL_SCALAR && to - from >= 32)
+            from = SkipAvx2(data, from, to);
+#endif
+        while (from < to && m_Skip[data[from]])
+            ++from;
+        return from;
+    }
+
+#ifdef DFA_SIMD_X86
+    // Skips and one-byte tokens from `from` 32 bytes at a time, up to the
+    // first byte that needs the DFA or the last 32 bytes; gives the position
+    // it stopped at. Groups of 8 bytes are written as 8 tokens and the output
+    // moves by the real number, so `out` needs room for the bytes as usual
+    __attribute__((target("avx2")))
+    size_t TokenizeAvx2(const unsigned char* data, size_t from, size_t to, Token*& out) const
+    {
+        const uint64_t* compress = CompressTable();
+        const __m256i nibble = _mm256_set1_epi8(0x0f);
+        const __m256i dfa = _mm256_set1_epi8(static_cast<char>(CODE_DFA));
+        const __m256i skip = _mm256_set1_epi8(static_cast<char>(CODE_SKIP));
+        Token* o = out;
+        for (; from + 32 <= to; from += 32) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + from));
+            __m256i low = _mm256_and_si256(v, nibble);
+            __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+            __m256i code = dfa;
+            for (int r = 0; r < m_Rows; ++r) {
+                __m256i table = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(m_Code[r])));
+                __m256i in_row = _mm256_cmpeq_epi8(high, _mm256_set1_epi8(static_cast<char>(m_Row[r])));
+                code = _mm256_blendv_epi8(code, _mm256_shuffle_epi8(table, low), in_row);
+            }
+            uint32_t slow = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(code, dfa)));
+            uint32_t tokens = ~(slow | static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(code, skip))));
+            int stop = slow ? __builtin_ctz(slow) : 32;
+            if (stop < 32)
+                tokens &= (1u << stop) - 1;
+
+            alignas(32) uint8_t codes[32];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(codes), code);
+            for (int g = 0; g < stop; g += 8) {
+                uint32_t bits = tokens >> g & 0xff;
+                __m128i order = _mm_cvtsi64_si128(static_cast<long long>(compress[bits]));
+                __m128i kinds = _mm_shuffle_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(codes + g)), order);
+                __m256i offsets = _mm256_add_epi32(_mm256_cvtepu8_epi32(order),
+                                                   _mm256_set1_epi32(static_cast<int>(from + g)));
+                __m256i kind = _mm256_cvtepu8_epi32(kinds);
+                __m256i first = _mm256_unpacklo_epi32(offsets, kind);     // tokens 0, 1 | 4, 5
+                __m256i second = _mm256_unpackhi_epi32(offsets, kind);    // tokens 2, 3 | 6, 7
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(o), _mm256_permute2x128_si256(first, second, 0x20));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(o + 4), _mm256_permute2x128_si256(first, second, 0x31));
+                o += __builtin_popcount(bits);
+            }
+            if (stop < 32) {
+                from += stop;
+                break;
+            }
+        }
+        out = o;
+        return from;
+    }
+
+    // The same 64 bytes at a time
+    __attribute__((target("avx512f,avx512bw,avx512vbmi,avx512vbmi2")))
+    size_t TokenizeAvx512(const unsigned char* data, size_t from, size_t to, Token*& out) const
+    {
+        const __m512i codes0 = _mm512_loadu_si512(m_Byte_code);
+        const __m512i codes1 = _mm512_loadu_si512(m_Byte_code + 64);
+        const __m512i codes2 = _mm512_loadu_si512(m_Byte_code + 128);
+        const __m512i codes3 = _mm512_loadu_si512(m_Byte_code + 192);
+        const __m512i dfa = _mm512_set1_epi8(static_cast<char>(CODE_DFA));
+        const __m512i skip = _mm512_set1_epi8(static_cast<char>(CODE_SKIP));
+        // Byte numbers 0-63 and the sources of the bytes of 8 records
+        struct alignas(64) Indexes {
+            uint8_t lanes[64];
+            uint8_t place[64];
+        };
+        static const Indexes indexes = [] {
+            Indexes t = {};
+            for (int k = 0; k < 64; ++k) {
+                t.lanes[k] = static_cast<uint8_t>(k);
+                t.place[k] = static_cast<uint8_t>(k % 8 == 4 ? 64 + k / 8 : k / 8);
+            }
+            return t;
+        }();
+        const __m512i lanes = _mm512_load_si512(indexes.lanes);
+        const __m512i place = _mm512_load_si512(indexes.place);
+        const __m512i eight = _mm512_set1_epi8(8);
+        Token* o = out;
+        for (; from + 64 <= to; from += 64) {
+            __m512i v = _mm512_loadu_si512(data + from);
+            __m512i code = _mm512_mask_blend_epi8(_mm512_movepi8_mask(v), _mm512_permutex2var_epi8(codes0, v, codes1),
+                                                  _mm512_permutex2var_epi8(codes2, v, codes3));
+            uint64_t slow = _mm512_cmpeq_epi8_mask(code, dfa);
+            uint64_t tokens = ~(slow | _mm512_cmpeq_epi8_mask(code, skip));
+            int stop = slow ? __builtin_ctzll(slow) : 64;
+            if (stop < 64)
+                tokens &= (uint64_t(1) << stop) - 1;
+
+            // Offsets in the block and kinds of the tokens, packed; then 8
+            // records at a time: offset byte to byte 0, kind to byte 4
+            __m512i offsets = _mm512_maskz_compress_epi8(tokens, lanes);
+            __m512i kinds = _mm512_maskz_compress_epi8(tokens, code);
+            __m512i base = _mm512_set1_epi64(static_cast<long long>(from));
+            int count = __builtin_popcountll(tokens);
+            __m512i order = place;
+            for (int k = 0; k < count; k += 8) {
+                __m512i records = _mm512_maskz_permutex2var_epi8(0x1111111111111111ull, offsets, order, kinds);
+                _mm512_storeu_si512(o + k, _mm512_add_epi64(records, base));
+                order = _mm512_add_epi8(order, eight);
+            }
+            o += count;
+            if (stop < 64) {
+                from += stop;
+                break;
+            }
+        }
+        out = o;
+        return from;
+    }
+
+    // Membership in the set of non-skipped bytes, 32 bytes at once (the same
+    // nibble tables as DfaSearcher::SkipAvx2)
+    __attribute__((target("avx2")))
+    size_t SkipAvx2(const unsigned char* data, size_t from, size_t to) const
+    {
+        const __m256i low = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(m_Stop_low)));
+        const __m256i high = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(m_Stop_high)));
+        const __m256i bit = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+                                             1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+        const __m256i top = _mm256_set1_epi8(static_cast<char>(0x80));
+        const __m256i seven = _mm256_set1_epi8(7);
+        const __m256i zero = _mm256_setzero_si256();
+
+        for (; from + 32 <= to; from += 32) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + from));
+            __m256i row = _mm256_or_si256(_mm256_shuffle_epi8(low, v),
+                                          _mm256_shuffle_epi8(high, _mm256_xor_si256(v, top)));
+            __m256i mask = _mm256_shuffle_epi8(bit, _mm256_and_si256(_mm256_srli_epi16(v, 4), seven));
+            __m256i miss = _mm256_cmpeq_epi8(_mm256_and_si256(row, mask), zero);
+            uint32_t hits = ~static_cast<uint32_t>(_mm256_movemask_epi8(miss));
+            if (hits)
+                return from + __builtin_ctz(hits);
+        }
+        return from;
+    }
+#endif
+
+    static bool Fail(std::string* error, const std::string& message)
+    {
+        if (error)
+            *error = message;
+        return false;
+    }
+
+    std::vector<Position> m_Positions;
+    std::vector<int> m_First;               // positions a token can start with
+    std::vector<int> m_Kinds;               // kind of every definition
+
+    int m_States = 0;
+    int m_Classes = 0;
+    int m_Kernel = KERNEL_SCALAR;
+    uint8_t m_Class[256] = {};
+    std::vector<int> m_Next;                // states x classes, 0 - dead
+    std::vector<int32_t> m_Accept;          // token kind of every state or ERROR
+    int32_t m_Single[256] = {};             // kind of a one-byte-only token starting with the byte
+    bool m_Simd = false;                    // every one-byte kind fits a code
+    int m_Rows = 0;
+    uint8_t m_Row[16] = {};                 // high nibbles with codes other than CODE_DFA
+    uint8_t m_Code[16][16] = {};            // their codes by the low nibble
+    alignas(64) uint8_t m_Byte_code[256] = {};  // codes of all bytes
+    bool m_Skip[256] = {};
+    uint8_t m_Stop_low[16] = {};            // non-skipped bytes 0x00-0x7F: bit (b >> 4) of row (b & 15)
+    uint8_t m_Stop_high[16] = {};           // bytes 0x80-0xFF
+};
@@ -0,0 +1,241 @@
+// LL(1) parser generated from a JFLAP grammar (pw5/"LL(1) for program.jff" -
+// the grammar of recursive_descent.cpp).
+//
+//   ll1                         - the grammar of this work, a line is entered
+//                                 from the keyboard
+//   ll1 <file.jff> [input]      - grammar from the file; with `input` every
+//                                 line of it is checked ('1' / '0')
+//   ll1 --table [file.jff]      - FIRST, FOLLOW, conflicts and the parse table
+//   ll1 --bench [file.jff]      - explicit stack against recursive calls on
+//                                 random programs and on deep nesting
+
+#include <iostream>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../common/record_reader.hpp"
+#include "ll1.hpp"
+#include "random_sentence.hpp"
+
+const char *DEFAULT_GRAMMAR = "LL(1) for program.jff";
+
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::time_point from)
+{
+    return std::chrono::duration<double>(Clock::now() - from).count();
+}
+
+bool LoadTable(const char *path, Ll1Table &table)
+{
+    Grammar grammar;
+    std::string error;
+    if (!grammar.Load(path, &error) || !table.Build(grammar, &error))
+    {
+        std::fprintf(stderr, "%s: %s\n", path, error.c_str());
+        return false;
+    }
+    for (const std::string &conflict : table.Conflicts())
+        std::fprintf(stderr, "%s: LL(1) conflict at %s\n", path, conflict.c_str());
+    return true;
+}
+
+// The same table walked with one call per variable, as the hand-written
+// recursive descent does; the baseline for the benchmark
+class RecursiveParser
+{
+public:
+    explicit RecursiveParser(const Ll1Table &table) : m_Table(table) {}
+
+    bool Parse(const char *first, const char *last)
+    {
+        m_Pos = first;
+        m_Last = last;
+        Skip();
+        return Expand(m_Table.Start()) && m_Pos == m_Last;
+    }
+
+private:
+    bool Expand(int variable)
+    {
+        int t = m_Pos == m_Last ? Ll1Table::END : (unsigned char)*m_Pos;
+        int production = m_Table.Entry(variable, t);
+        if (production < 0)
+            return false;
+        for (const int *p = m_Table.RhsEnd(production); p != m_Table.RhsBegin(production);)
+        {
+            int symbol = *--p;
+            if (!Grammar::IsTerminal(symbol))
+            {
+                if (!Expand(Grammar::VariableIndex(symbol)))
+                    return false;
+                continue;
+            }
+            if (m_Pos == m_Last || (unsigned char)*m_Pos != symbol)
+                return false;
+            ++m_Pos;
+            Skip();
+        }
+        return true;
+    }
+
+    void Skip()
+    {
+        while (m_Pos != m_Last && std::isspace((unsigned char)*m_Pos))
+            ++m_Pos;
+    }
+
+    const Ll1Table &m_Table;
+    const char *m_Pos = nullptr;
+    const char *m_Last = nullptr;
+};
+
+void PrintSet(const Ll1Table::Set &set, const char *empty)
+{
+    for (int t = 0; t <= Ll1Table::END; ++t)
+        if (set[t])
+            std::printf(" %s", t == Ll1Table::END ? empty : Ll1Table::TerminalName(t).c_str());
+    std::printf("\n");
+}
+
+int PrintTable(const char *path)
+{
+    Ll1Table table;
+    if (!LoadTable(path, table))
+        return 1;
+    const Grammar &g = table.Source();
+    for (int a = 0; a < table.Variables(); ++a)
+    {
+        std::printf("FIRST(%s) =", g.VariableName(Grammar::Variable(a)).c_str());
+        PrintSet(table.First(a), "ε");
+        std::printf("FOLLOW(%s) =", g.VariableName(Grammar::Variable(a)).c_str());
+        PrintSet(table.Follow(a), "$");
+    }
+    std::printf("\n");
+    for (int a = 0; a < table.Variables(); ++a)
+        for (int t = 0; t <= Ll1Table::END; ++t)
+            if (table.Entry(a, t) >= 0)
+                std::printf("M[%s, %s] = %s\n", g.VariableName(Grammar::Variable(a)).c_str(),
+                            Ll1Table::TerminalName(t).c_str(), g.ToString(g.Productions()[table.Entry(a, t)]).c_str());
+    std::printf("\n%s, %zu conflict(s), table %zu bytes\n", table.IsLl1() ? "LL(1)" : "not LL(1)",
+                table.Conflicts().size(), table.TableBytes());
+    return table.IsLl1() ? 0 : 2;
+}
+
+int RunBenchmark(const char *path)
+{
+    Ll1Table table;
+    if (!LoadTable(path, table))
+        return 1;
+    std::printf("%s: %d variables, %zu productions, %s, table %zu bytes\n", path, table.Variables(),
+                table.Source().Productions().size(), table.IsLl1() ? "LL(1)" : "not LL(1)", table.TableBytes());
+
+    Ll1Parser parser(table);
+    RecursiveParser recursive(table);
+    std::mt19937 rng(17);
+
+    // Many random sentences of the grammar, about 16 MB together, and a copy
+    // with one character changed in each: both parsers must agree on every line
+    std::vector<std::string> sentences, broken;
+    size_t bytes = 0;
+    while (bytes < (16u << 20))
+    {
+        sentences.push_back(RandomSentence(table.Source(), rng, 20 + rng() % 2000));
+        bytes += sentences.back().size();
+        broken.push_back(sentences.back());
+        broken.back()[rng() % broken.back().size()] = "gx0f;=|&~()"[rng() % 11];
+    }
+
+    std::vector<int> stack_verdicts, recursive_verdicts;
+    auto begin = Clock::now();
+    for (const auto &s : sentences)
+        stack_verdicts.push_back(parser.Parse(s.data(), s.data() + s.size()));
+    double t_stack = Seconds(begin);
+    begin = Clock::now();
+    for (const auto &s : sentences)
+        recursive_verdicts.push_back(recursive.Parse(s.data(), s.data() + s.size()));
+    double t_recursive = Seconds(begin);
+    int accepted = 0, rejected = 0;
+    for (int verdict : stack_verdicts)
+        accepted += verdict;
+    for (const auto &s : broken)
+    {
+        stack_verdicts.push_back(parser.Parse(s.data(), s.data() + s.size()));
+        recursive_verdicts.push_back(recursive.Parse(s.data(), s.data() + s.size()));
+        rejected += !stack_verdicts.back();
+    }
+    std::printf("%zu sentences, %.1f MB: explicit stack %8.1f MB/s, recursive calls %8.1f MB/s, accepted %d/%zu, "
+                "changed rejected %d/%zu %s\n",
+                sentences.size(), bytes / 1e6, bytes / 1e6 / t_stack, bytes / 1e6 / t_recursive, accepted,
+                sentences.size(), rejected, broken.size(), stack_verdicts == recursive_verdicts ? "ok" : "MISMATCH");
+
+    // g=((((...g...)))): every '(' costs a few stack entries or call frames
+    for (int depth : { 1000, 100000, 1000000, 10000000 })
+    {
+        std::string input = "g=" + std::string(depth, '(') + "g" + std::string(depth, ')');
+        begin = Clock::now();
+        bool ok = parser.Parse(input.data(), input.data() + input.size());
+        double seconds = Seconds(begin);
+        std::printf("nesting %8d: explicit stack %-8s %8.1f ms, max stack %9zu",
+                    depth, ok ? "accepted" : "rejected", seconds * 1e3, parser.MaxDepth());
+        if (depth <= 1000)
+        {
+            begin = Clock::now();
+            bool same = recursive.Parse(input.data(), input.data() + input.size()) == ok;
+            std::printf(" | recursive calls %8.1f ms %s\n", Seconds(begin) * 1e3, same ? "ok" : "MISMATCH");
+        }
+        else
+        {
+            std::printf(" | recursive calls: skipped (call stack overflow)\n");
+        }
+    }
+    return 0;
+}
+
+int Run(const char *path, const char *input)
+{
+    Ll1Table table;
+    if (!LoadTable(path, table))
+        return 1;
+    Ll1Parser parser(table);
+
+    if (input)
+    {
+        RecordReader reader;
+        std::string message;
+        if (!reader.Open(input, &message))
+        {
+            std::fprintf(stderr, "%s\n", message.c_str());
+            return 1;
+        }
+        std::string_view line;
+        while (reader.Next(line))
+            std::fputs(parser.Parse(line.data(), line.data() + line.size()) ? "1\n" : "0\n", stdout);
+        return 0;
+    }
+
+    std::cout << "Enter your input line: ";
+    std::string line;
+    std::getline(std::cin, line);
+    if (parser.Parse(line.data(), line.data() + line.size()))
+        std::cout << "Accepted.\n";
+    else
+        std::cout << "Rejected.\n";
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0)
+        return RunBenchmark(argc > 2 ? argv[2] : DEFAULT_GRAMMAR);
+    if (argc > 1 && std::strcmp(argv[1], "--table") == 0)
+        return PrintTable(argc > 2 ? argv[2] : DEFAULT_GRAMMAR);
+
+    return Run(argc > 1 ? argv[1] : DEFAULT_GRAMMAR, argc > 2 ? argv[2] : nullptr);
+}
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../common/grammar.hpp"
+#include "first_follow.hpp"
+
+// LL(1) table built from a grammar and a parser driven by it.
+//
+// Терминалы - байты, столбец 256 - конец входа ($). По множествам FIRST и
+// FOLLOW (first_follow.hpp) заполняется таблица; конфликт (две продукции в одной клетке)
+// запоминается текстом, в клетке остается первая продукция. Таблица плотная:
+// variables x 257 номеров продукций (-1 - ошибка). Правые части хранятся
+// одним массивом в обратном порядке, чтобы разбор клал их на стек одним
+// копированием.
+class Ll1Table {
+public:
+    static constexpr int END = FirstFollow::END;   // $ column, ε in FIRST sets
+    using Set = FirstFollow::Set;
+
+    bool Build(const Grammar& grammar, std::string* error = nullptr)
+    {
+        m_Grammar = grammar;
+        m_Variables = grammar.Variables();
+        m_Conflicts.clear();
+        if (m_Variables == 0 || grammar.Productions().empty())
+            return Fail(error, "empty grammar");
+
+        m_Sets.Build(m_Grammar);
+
+        m_Table.assign(static_cast<size_t>(m_Variables) * 257, -1);
+        m_Rhs.clear();
+        m_Rhs_begin.assign(1, 0);
+        const auto& productions = grammar.Productions();
+        for (size_t p = 0; p < productions.size(); ++p) {
+            const Production& production = productions[p];
+            int a = Grammar::VariableIndex(production.left);
+            Set first = m_Sets.FirstOf(production.right);
+            if (first[END]) {
+                first[END] = false;
+                first |= m_Sets.Follow(a);         // ε in FIRST: the FOLLOW columns (with $)
+            }
+
+            for (int t = 0; t <= END; ++t) {
+                if (!first[t])
+                    continue;
+                int16_t& cell = m_Table[static_cast<size_t>(a) * 257 + t];
+                if (cell >= 0 && cell != static_cast<int16_t>(p)) {
+                    m_Conflicts.push_back(grammar.VariableName(production.left) + ", " + TerminalName(t) + ": " +
+                                          grammar.ToString(productions[cell]) + " / " +
+                                          grammar.ToString(production));
+                    continue;
+                }
+                cell = static_cast<int16_t>(p);
+            }
+
+            for (size_t k = production.right.size(); k-- > 0;)
+                m_Rhs.push_back(production.right[k]);
+            m_Rhs_begin.push_back(static_cast<int>(m_Rhs.size()));
+        }
+        ComputeSteps();
+        return true;
+    }
+
+    bool IsLl1() const { return m_Conflicts.empty(); }
+    const std::vector<std::string>& Conflicts() const { return m_Conflicts; }
+
+    const Grammar& Source() const { return m_Grammar; }
+    int Variables() const { return m_Variables; }
+    int Start() const { return Grammar::VariableIndex(m_Grammar.Start()); }
+
+    // FIRST of a variable (bit END - the variable derives ε) and FOLLOW
+    // (bit END - $)
+    const Set& First(int variable) const { return m_Sets.First(variable); }
+    const Set& Follow(int variable) const { return m_Sets.Follow(variable); }
+
+    // Production for variable index `a` and a terminal column, -1 - error
+    int Entry(int a, int terminal) const { return m_Table[static_cast<size_t>(a) * 257 + terminal]; }
+    const int16_t* Row(int a) const { return m_Table.data() + static_cast<size_t>(a) * 257; }
+
+    // Right side of production p reversed: [RhsBegin(p), RhsEnd(p))
+    const int* RhsBegin(int p) const { return m_Rhs.data() + m_Rhs_begin[p]; }
+    const int* RhsEnd(int p) const { return m_Rhs.data() + m_Rhs_begin[p + 1]; }
+
+    // All expansions of variable `a` on lookahead t up to the moment t is
+    // consumed (`consumes`), or up to the moment `a` derived ε. The stack
+    // pops `a` and pushes [begin, end) - already reversed
+    struct Step {
+        int begin;
+        int end;
+        bool consumes;
+    };
+
+    // nullptr - error
+    const Step* StepFor(int a, int terminal) const
+    {
+        const Step* step = &m_Steps[static_cast<size_t>(a) * 257 + terminal];
+        return step->begin < 0 ? nullptr : step;
+    }
+
+    const int* StepSymbols() const { return m_Step_symbols.data(); }
+
+    size_t TableBytes() const
+    {
+        return m_Table.size() * sizeof(int16_t) + m_Steps.size() * sizeof(Step) +
+               m_Step_symbols.size() * sizeof(int);
+    }
+
+    static std::string TerminalName(int t)
+    {
+        return t == END ? std::string("$") : std::string(1, static_cast<char>(t));
+    }
+
+private:
+    // Steps are found by running the table on the one-symbol stack [a]. Для
+    // LL(1)-грамматики цепочка конечна; при конфликтах (например, левой
+    // рекурсии) она может зациклиться и обрывается, клетка считается ошибкой.
+    void ComputeSteps()
+    {
+        static constexpr int MAX_EXPANSIONS = 4096;
+
+        m_Steps.assign(static_cast<size_t>(m_Variables) * 257, Step{ -1, -1, false });
+        m_Step_symbols.clear();
+        std::vector<int> stack;
+        for (int a = 0; a < m_Variables; ++a) {
+            for (int t = 0; t <= END; ++t) {
+                if (Entry(a, t) < 0)
+                    continue;
+                stack.assign(1, Grammar::Variable(a));
+                bool consumes = false;
+                int expansions = 0;
+                while (!stack.empty() && expansions < MAX_EXPANSIONS) {
+                    int top = stack.back();
+                    if (Grammar::IsTerminal(top)) {
+                        consumes = top == t;
+                        break;
+                    }
+                    int production = Entry(Grammar::VariableIndex(top), t);
+                    if (production < 0)
+                        break;
+                    stack.pop_back();
+                    stack.insert(stack.end(), RhsBegin(production), RhsEnd(production));
+                    ++expansions;
+                }
+                // Finished: t on top (consumed), or the stack is empty (ε)
+                if (!consumes && !stack.empty())
+                    continue;
+                if (consumes)
+                    stack.pop_back();
+                Step step;
+                step.begin = static_cast<int>(m_Step_symbols.size());
+                m_Step_symbols.insert(m_Step_symbols.end(), stack.begin(), stack.end());
+                step.end = static_cast<int>(m_Step_symbols.size());
+                step.consumes = consumes;
+                m_Steps[static_cast<size_t>(a) * 257 + t] = step;
+            }
+        }
+    }
+
+    static bool Fail(std::string* error, const std::string& message)
+    {
+        if (error)
+            *error = message;
+        return false;
+    }
+
+    Grammar m_Grammar;
+    int m_Variables = 0;
+    FirstFollow m_Sets;
+    std::vector<std::string> m_Conflicts;
+    std::vector<int16_t> m_Table;              // variables x 257
+    std::vector<int> m_Rhs;                    // right sides, each reversed
+    std::vector<int> m_Rhs_begin;              // production p: m_Rhs[m_Rhs_begin[p], m_Rhs_begin[p + 1])
+    std::vector<Step> m_Steps;                 // variables x 257, begin < 0 - error
+    std::vector<int> m_Step_symbols;           // pushed symbols of all steps
+};
+
+// Table-driven LL(1) parsing with an explicit stack: no recursion, so the
+// nesting depth of the input is limited only by memory. Пробельные символы
+// пропускаются, как в лексере recursive_descent.cpp. На каждый символ входа
+// приходится один шаг таблицы (Ll1Table::Step) - одно копирование на стек.
+// Стек выделяется один раз и растет по мере надобности между вызовами.
+class Ll1Parser {
+public:
+    explicit Ll1Parser(const Ll1Table& table)
+        : m_Table(table), m_Stack(1024)
+    {
+    }
+
+    bool Parse(const char* first, const char* last)
+    {
+        const char* p = SkipSpaces(first, last);
+        const int* symbols = m_Table.StepSymbols();
+        size_t size = 0;
+        m_Stack[size++] = Grammar::Variable(m_Table.Start());
+        m_Max_depth = 1;
+
+        while (size > 0) {
+            int top = m_Stack[size - 1];
+            int t = p == last ? Ll1Table::END : static_cast<unsigned char>(*p);
+            if (Grammar::IsTerminal(top)) {
+                if (top != t)
+                    return false;
+                --size;
+                p = SkipSpaces(p + 1, last);
+                continue;
+            }
+            const Ll1Table::Step* step = m_Table.StepFor(Grammar::VariableIndex(top), t);
+            if (!step)
+                return false;
+            --size;
+            size_t count = step->end - step->begin;
+            if (size + count > m_Stack.size())
+                m_Stack.resize(2 * (size + count));
+            std::copy(symbols + step->begin, symbols + step->end, m_Stack.data() + size);
+            size += count;
+            if (size > m_Max_depth)
+                m_Max_depth = size;
+            if (step->consumes)
+                p = SkipSpaces(p + 1, last);
+        }
+        return p == last;
+    }
+
+    // Deepest stack of the last Parse
+    size_t MaxDepth() const { return m_Max_depth; }
+
+private:
+    static const char* SkipSpaces(const char* p, const char* last)
+    {
+        while (p != last && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == '\v' || *p == '\f'))
+            ++p;
+        return p;
+    }
+
+    const Ll1Table& m_Table;
+    std::vector<int> m_Stack;
+    size_t m_Max_depth = 0;
+};
@@ -0,0 +1,194 @@
+// LR parser generated from a JFLAP grammar (pw5/"SLR(1).jff" by default).
+//
+//   lr                          - the grammar of this work, a line is entered
+//                                 from the keyboard
+//   lr <file.jff> [input]       - grammar from the file; with `input` every
+//                                 line of it is checked ('1' / '0')
+//   lr --table [file.jff]       - LR(0) states, SLR(1) and LALR(1) conflicts,
+//                                 the LALR(1) ACTION and GOTO tables
+//   lr --bench [file.jff]       - tokens per second of the shift-reduce loop
+//                                 with dense and packed tables
+
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../common/record_reader.hpp"
+#include "lr.hpp"
+#include "random_sentence.hpp"
+
+const char *DEFAULT_GRAMMAR = "SLR(1).jff";
+
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::time_point from)
+{
+    return std::chrono::duration<double>(Clock::now() - from).count();
+}
+
+bool LoadTables(const char *path, int method, LrTables &tables, bool report = true)
+{
+    Grammar grammar;
+    std::string error;
+    if (!grammar.Load(path, &error) || !tables.Build(grammar, method, &error))
+    {
+        std::fprintf(stderr, "%s: %s\n", path, error.c_str());
+        return false;
+    }
+    if (report)
+        for (const std::string &conflict : tables.Conflicts())
+            std::fprintf(stderr, "%s: %s conflict at %s\n", path, method == LR_SLR ? "SLR(1)" : "LALR(1)",
+                         conflict.c_str());
+    return true;
+}
+
+void PrintSummary(const char *name, const LrTables &tables)
+{
+    std::printf("%-8s %3d states, %3zu conflict(s), dense %7zu bytes, packed %6zu bytes (ACTION %zu slots, GOTO %zu slots)\n",
+                name, tables.States(), tables.Conflicts().size(), tables.DenseBytes(), tables.PackedBytes(),
+                tables.PackedAction().Slots(), tables.PackedGoto().Slots());
+}
+
+int PrintTable(const char *path)
+{
+    LrTables slr, lalr;
+    if (!LoadTables(path, LR_SLR, slr, false) || !LoadTables(path, LR_LALR, lalr))
+        return 1;
+    const Grammar &g = lalr.Source();
+
+    for (int s = 0; s < lalr.States(); ++s)
+    {
+        std::printf("state %d:", s);
+        for (const auto &item : lalr.Kernel(s))
+            std::printf("  %s", lalr.ItemText(item.first, item.second).c_str());
+        std::printf("\n");
+        for (int t = 0; t <= LrTables::END; ++t)
+        {
+            int32_t action = lalr.Action(s, t);
+            if (action == LrTables::ERROR)
+                continue;
+            if (action == LrTables::ACCEPT)
+                std::printf("    %s: accept\n", LrTables::TerminalName(t).c_str());
+            else if (action > 0)
+                std::printf("    %s: shift %d\n", LrTables::TerminalName(t).c_str(), action - 1);
+            else
+                std::printf("    %s: reduce %s\n", LrTables::TerminalName(t).c_str(),
+                            g.ToString(g.Productions()[-action - 1]).c_str());
+        }
+        for (int a = 0; a < lalr.Variables(); ++a)
+            if (lalr.Goto(s, a) != 0)
+                std::printf("    %s: goto %d\n", g.VariableName(Grammar::Variable(a)).c_str(), lalr.Goto(s, a));
+    }
+    std::printf("\n");
+    PrintSummary("SLR(1)", slr);
+    PrintSummary("LALR(1)", lalr);
+    return lalr.HasConflicts() ? 2 : 0;
+}
+
+int RunBenchmark(const char *path)
+{
+    LrTables slr, lalr;
+    if (!LoadTables(path, LR_SLR, slr) || !LoadTables(path, LR_LALR, lalr))
+        return 1;
+    PrintSummary("SLR(1)", slr);
+    PrintSummary("LALR(1)", lalr);
+
+    // Random sentences of about 16 MB and a copy with one character changed
+    // in each: the tables must agree on every line
+    std::mt19937 rng(18);
+    std::vector<std::string> sentences, broken;
+    size_t tokens = 0;
+    while (tokens < (16u << 20))
+    {
+        sentences.push_back(RandomSentence(slr.Source(), rng, 20 + rng() % 2000));
+        tokens += sentences.back().size();
+        broken.push_back(sentences.back());
+        broken.back()[rng() % broken.back().size()] = "gx0f;=|&~()"[rng() % 11];
+    }
+
+    struct Variant
+    {
+        const char *name;
+        const LrTables *tables;
+        bool packed;
+    };
+    std::vector<int> expected;
+    for (const Variant &v : { Variant{ "SLR(1) dense", &slr, false }, Variant{ "SLR(1) packed", &slr, true },
+                              Variant{ "LALR(1) dense", &lalr, false }, Variant{ "LALR(1) packed", &lalr, true } })
+    {
+        LrParser parser(*v.tables, v.packed);
+        std::vector<int> verdicts;
+        auto begin = Clock::now();
+        for (const auto &s : sentences)
+            verdicts.push_back(parser.Parse(s.data(), s.data() + s.size()));
+        double seconds = Seconds(begin);
+        int accepted = 0;
+        for (int verdict : verdicts)
+            accepted += verdict;
+        for (const auto &s : broken)
+            verdicts.push_back(parser.Parse(s.data(), s.data() + s.size()));
+        if (expected.empty())
+            expected = verdicts;
+        std::printf("%-15s %6.1f M tokens/s, accepted %d/%zu %s\n", v.name, tokens / 1e6 / seconds, accepted,
+                    sentences.size(), verdicts == expected ? "ok" : "MISMATCH");
+    }
+
+    // Deep right nesting g=g=g=...: the stack grows with the input
+    std::string deep;
+    for (int i = 0; i < 1000000; ++i)
+        deep += "g=";
+    deep += "g";
+    LrParser parser(lalr);
+    auto begin = Clock::now();
+    bool ok = parser.Parse(deep.data(), deep.data() + deep.size());
+    std::printf("g=g=...=g (%zu tokens): %s, %.1f ms, max stack %zu\n", deep.size(), ok ? "accepted" : "rejected",
+                Seconds(begin) * 1e3, parser.MaxDepth());
+    return 0;
+}
+
+int Run(const char *path, const char *input)
+{
+    LrTables tables;
+    if (!LoadTables(path, LR_LALR, tables))
+        return 1;
+    LrParser parser(tables);
+
+    if (input)
+    {
+        RecordReader reader;
+        std::string message;
+        if (!reader.Open(input, &message))
+        {
+            std::fprintf(stderr, "%s\n", message.c_str());
+            return 1;
+        }
+        std::string_view line;
+        while (reader.Next(line))
+            std::fputs(parser.Parse(line.data(), line.data() + line.size()) ? "1\n" : "0\n", stdout);
+        return 0;
+    }
+
+    std::cout << "Enter your input line: ";
+    std::string line;
+    std::getline(std::cin, line);
+    if (parser.Parse(line.data(), line.data() + line.size()))
+        std::cout << "Accepted.\n";
+    else
+        std::cout << "Rejected.\n";
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0)
+        return RunBenchmark(argc > 2 ? argv[2] : DEFAULT_GRAMMAR);
+    if (argc > 1 && std::strcmp(argv[1], "--table") == 0)
+        return PrintTable(argc > 2 ? argv[2] : DEFAULT_GRAMMAR);
+
+    return Run(argc > 1 ? argv[1] : DEFAULT_GRAMMAR, argc > 2 ? argv[2] : nullptr);
+}
@@ -0,0 +1,601 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../common/grammar.hpp"
+#include "first_follow.hpp"
+
+enum LR_METHOD {
+    LR_SLR,     // reductions on FOLLOW of the left side
+    LR_LALR     // lookaheads propagated through the LR(0) automaton
+};
+
+// Table compressed by row displacement ("comb" packing, as in yacc).
+// Значения строки, отличные от значения по умолчанию, раскладываются в общий
+// массив со сдвигом base[row], подобранным так, чтобы занятые клетки строк не
+// совпадали; check[] хранит номер строки-владельца клетки.
+class PackedTable {
+public:
+    void Pack(const std::vector<int32_t>& dense, int rows, int columns, const std::vector<int32_t>& defaults)
+    {
+        m_Default = defaults;
+        m_Base.assign(rows, 0);
+        m_Value.clear();
+        m_Check.clear();
+
+        std::vector<std::vector<int>> entries(rows);
+        for (int r = 0; r < rows; ++r)
+            for (int c = 0; c < columns; ++c)
+                if (dense[static_cast<size_t>(r) * columns + c] != defaults[r])
+                    entries[r].push_back(c);
+
+        // Fullest rows first: they are the hardest to fit
+        std::vector<int> order(rows);
+        for (int r = 0; r < rows; ++r)
+            order[r] = r;
+        std::stable_sort(order.begin(), order.end(), [&](int x, int y) {
+            return entries[x].size() > entries[y].size();
+        });
+
+        int top = 0;
+        for (int r : order) {
+            if (entries[r].empty())
+                continue;
+            int base = 0;
+            for (;; ++base) {
+                bool fits = true;
+                for (int c : entries[r]) {
+                    size_t k = static_cast<size_t>(base) + c;
+                    if (k < m_Check.size() && m_Check[k] >= 0) {
+                        fits = false;
+                        break;
+                    }
+                }
+                if (fits)
+                    break;
+            }
+            m_Base[r] = base;
+            top = std::max(top, base);
+            for (int c : entries[r]) {
+                size_t k = static_cast<size_t>(base) + c;
+                if (k >= m_Check.size()) {
+                    m_Check.resize(k + 1, -1);
+                    m_Value.resize(k + 1, 0);
+                }
+                m_Check[k] = r;
+                m_Value[k] = dense[static_cast<size_t>(r) * columns + c];
+            }
+        }
+        // Any base + column stays inside the arrays
+        m_Check.resize(static_cast<size_t>(top) + columns, -1);
+        m_Value.resize(static_cast<size_t>(top) + columns, 0);
+    }
+
+    int32_t Get(int row, int column) const
+    {
+        size_t k = static_cast<size_t>(m_Base[row]) + column;
+        return m_Check[k] == row ? m_Value[k] : m_Default[row];
+    }
+
+    size_t Slots() const { return m_Value.size(); }
+
+    size_t Bytes() const
+    {
+        return (m_Base.size() + m_Default.size() + m_Value.size() + m_Check.size()) * sizeof(int32_t);
+    }
+
+private:
+    std::vector<int32_t> m_Base;
+    std::vector<int32_t> m_Default;
+    std::vector<int32_t> m_Value;
+    std::vector<int32_t> m_Check;
+};
+
+// LR automaton of a grammar and its ACTION/GOTO tables.
+//
+// Автомат LR(0) строится по грамматике, дополненной правилом S' -> S.
+// Предпросмотр для свертки: SLR(1) - FOLLOW левой части, LALR(1) - по
+// алгоритму распространения (Ахо, Сети, Ульман): для каждого ядерного пункта
+// строится LR(1)-замыкание с фиктивным символом #, откуда берутся спонтанные
+// символы и ребра распространения, затем распространение до неподвижной точки.
+// Конфликты запоминаются текстом и решаются как в yacc: сдвиг важнее свертки,
+// из двух сверток - правило, записанное раньше.
+//
+// ACTION: 0 - ошибка, s + 1 - сдвиг в состояние s, -(p + 1) - свертка по
+// правилу p, ACCEPT - допуск. GOTO: номер состояния (0 - нет перехода,
+// в состояние 0 переходов не бывает). Обе таблицы есть в плотном виде и
+// упакованными (PackedTable); в упакованной ACTION пустые клетки строки
+// заменены самой частой сверткой этой строки, так что ошибка может
+// обнаружиться после нескольких лишних сверток, но до следующего сдвига.
+class LrTables {
+public:
+    static constexpr int END = FirstFollow::END;
+    static constexpr int32_t ERROR = 0;
+    static constexpr int32_t ACCEPT = INT32_MIN;
+
+    bool Build(const Grammar& grammar, int method, std::string* error = nullptr)
+    {
+        m_Conflicts.clear();
+        if (grammar.Variables() == 0 || grammar.Productions().empty())
+            return Fail(error, "empty grammar");
+
+        m_Grammar = grammar;
+        int start = m_Grammar.AddFreshVariable(m_Grammar.VariableName(grammar.Start()) + "'");
+        m_Grammar.AddProduction(start, { grammar.Start() });
+        m_Grammar.SetStart(start);
+        m_Augmented = static_cast<int>(m_Grammar.Productions().size()) - 1;
+        m_Variables = m_Grammar.Variables();
+        m_Sets.Build(m_Grammar);
+
+        IndexItems();
+        BuildLr0();
+        m_Action.assign(States() * static_cast<size_t>(257), ERROR);
+        m_Goto.assign(States() * static_cast<size_t>(m_Variables), 0);
+
+        for (int s = 0; s < States(); ++s) {
+            for (const auto& edge : m_Edges[s]) {
+                if (Grammar::IsTerminal(edge.first))
+                    SetAction(s, edge.first, edge.second + 1);
+                else
+                    m_Goto[static_cast<size_t>(s) * m_Variables + Grammar::VariableIndex(edge.first)] = edge.second;
+            }
+        }
+        if (method == LR_SLR)
+            AddSlrReductions();
+        else
+            AddLalrReductions();
+        Pack();
+        return true;
+    }
+
+    int States() const { return static_cast<int>(m_Kernels.size()); }
+    int Variables() const { return m_Variables; }
+    const Grammar& Source() const { return m_Grammar; }   // augmented
+
+    bool HasConflicts() const { return !m_Conflicts.empty(); }
+    const std::vector<std::string>& Conflicts() const { return m_Conflicts; }
+
+    int32_t Action(int state, int terminal) const { return m_Action[static_cast<size_t>(state) * 257 + terminal]; }
+    int Goto(int state, int variable) const { return m_Goto[static_cast<size_t>(state) * m_Variables + variable]; }
+
+    const PackedTable& PackedAction() const { return m_Packed_action; }
+    const PackedTable& PackedGoto() const { return m_Packed_goto; }
+
+    // Production p: length of the right side and the index of the left side
+    int RhsLength(int p) const { return m_Rhs_length[p]; }
+    int Lhs(int p) const { return m_Lhs[p]; }
+
+    size_t DenseBytes() const { return (m_Action.size() + m_Goto.size()) * sizeof(int32_t); }
+    size_t PackedBytes() const { return m_Packed_action.Bytes() + m_Packed_goto.Bytes(); }
+
+    // "A -> a.B" for the item `dot` of production p
+    std::string ItemText(int p, int dot) const
+    {
+        const Production& production = m_Grammar.Productions()[p];
+        std::string text = m_Grammar.SymbolName(production.left) + " -> ";
+        for (size_t k = 0; k <= production.right.size(); ++k) {
+            if (static_cast<int>(k) == dot)
+                text += '.';
+            if (k < production.right.size())
+                text += m_Grammar.SymbolName(production.right[k]);
+        }
+        return text;
+    }
+
+    // Kernel items of a state as (production, dot)
+    std::vector<std::pair<int, int>> Kernel(int state) const
+    {
+        std::vector<std::pair<int, int>> items;
+        for (int item : m_Kernels[state])
+            items.emplace_back(m_Item_production[item], m_Item_dot[item]);
+        return items;
+    }
+
+    static std::string TerminalName(int t)
+    {
+        return t == END ? std::string("$") : std::string(1, static_cast<char>(t));
+    }
+
+private:
+    using Set = FirstFollow::Set;
+
+    // Item = production + dot, numbered densely: m_Item_base[p] + dot
+    void IndexItems()
+    {
+        const auto& productions = m_Grammar.Productions();
+        m_Item_base.clear();
+        m_Item_production.clear();
+        m_Item_dot.clear();
+        m_Rhs_length.clear();
+        m_Lhs.clear();
+        m_By_left.assign(m_Variables, std::vector<int>());
+        for (size_t p = 0; p < productions.size(); ++p) {
+            m_Item_base.push_back(static_cast<int>(m_Item_production.size()));
+            for (size_t dot = 0; dot <= productions[p].right.size(); ++dot) {
+                m_Item_production.push_back(static_cast<int>(p));
+                m_Item_dot.push_back(static_cast<int>(dot));
+            }
+            m_Rhs_length.push_back(static_cast<int>(productions[p].right.size()));
+            m_Lhs.push_back(Grammar::VariableIndex(productions[p].left));
+            m_By_left[Grammar::VariableIndex(productions[p].left)].push_back(static_cast<int>(p));
+        }
+    }
+
+    int Items() const { return static_cast<int>(m_Item_production.size()); }
+
+    // Symbol after the dot, -1 for a complete item
+    int NextSymbol(int item) const
+    {
+        const Production& production = m_Grammar.Productions()[m_Item_production[item]];
+        int dot = m_Item_dot[item];
+        return dot < static_cast<int>(production.right.size()) ? production.right[dot] : -1;
+    }
+
+    std::vector<int> Closure0(const std::vector<int>& kernel) const
+    {
+        std::vector<int> items = kernel;
+        std::vector<char> added(m_Variables, 0);
+        for (size_t k = 0; k < items.size(); ++k) {
+            int symbol = NextSymbol(items[k]);
+            if (symbol < 0 || Grammar::IsTerminal(symbol) || added[Grammar::VariableIndex(symbol)])
+                continue;
+            added[Grammar::VariableIndex(symbol)] = 1;
+            for (int p : m_By_left[Grammar::VariableIndex(symbol)])
+                items.push_back(m_Item_base[p]);
+        }
+        return items;
+    }
+
+    void BuildLr0()
+    {
+        m_Kernels.assign(1, std::vector<int>{ m_Item_base[m_Augmented] });
+        m_Closures.clear();
+        m_Edges.clear();
+        std::map<std::vector<int>, int> index;
+        index[m_Kernels[0]] = 0;
+
+        for (size_t s = 0; s < m_Kernels.size(); ++s) {
+            m_Closures.push_back(Closure0(m_Kernels[s]));
+            std::map<int, std::vector<int>> moves;     // symbol -> advanced items
+            for (int item : m_Closures[s]) {
+                int symbol = NextSymbol(item);
+                if (symbol >= 0)
+                    moves[symbol].push_back(item + 1);
+            }
+            std::vector<std::pair<int, int>> edges;
+            for (auto& move : moves) {
+                std::sort(move.second.begin(), move.second.end());
+                auto found = index.find(move.second);
+                int target;
+                if (found == index.end()) {
+                    target = static_cast<int>(m_Kernels.size());
+                    index.emplace(move.second, target);
+                    m_Kernels.push_back(move.second);
+                } else {
+                    target = found->second;
+                }
+                edges.emplace_back(move.first, target);
+            }
+            m_Edges.push_back(std::move(edges));
+        }
+    }
+
+    int Transition(int state, int symbol) const
+    {
+        for (const auto& edge : m_Edges[state])
+            if (edge.first == symbol)
+                return edge.second;
+        return -1;
+    }
+
+    void SetAction(int state, int terminal, int32_t value)
+    {
+        int32_t& cell = m_Action[static_cast<size_t>(state) * 257 + terminal];
+        if (cell == ERROR || cell == value) {
+            cell = value;
+            return;
+        }
+        m_Conflicts.push_back("state " + std::to_string(state) + ", " + TerminalName(terminal) + ": " +
+                              ActionText(cell) + " / " + ActionText(value));
+        // Shift wins, then accept, then the earlier production
+        if (cell > 0 || value > 0 || (cell != ACCEPT && value != ACCEPT))
+            cell = std::max(cell, value);
+        else
+            cell = ACCEPT;
+    }
+
+    std::string ActionText(int32_t value) const
+    {
+        if (value == ACCEPT)
+            return "accept";
+        if (value > 0)
+            return "shift " + std::to_string(value - 1);
+        return "reduce " + m_Grammar.ToString(m_Grammar.Productions()[-value - 1]);
+    }
+
+    void Reduce(int state, int item, const Set& lookahead)
+    {
+        int p = m_Item_production[item];
+        for (int t = 0; t <= END; ++t) {
+            if (!lookahead[t])
+                continue;
+            if (p == m_Augmented)
+                SetAction(state, t, ACCEPT);     // only $ can follow S'
+            else
+                SetAction(state, t, -(p + 1));
+        }
+    }
+
+    void AddSlrReductions()
+    {
+        for (int s = 0; s < States(); ++s)
+            for (int item : m_Closures[s])
+                if (NextSymbol(item) < 0)
+                    Reduce(s, item, m_Sets.Follow(m_Lhs[m_Item_production[item]]));
+    }
+
+    // LR(1) closure: for every item its lookahead set and the flag of the
+    // dummy lookahead # (the item inherits the lookaheads of the kernel)
+    void Closure1(std::vector<Set>& lookahead, std::vector<char>& hash, std::vector<int>& items) const
+    {
+        std::vector<char> queued(Items(), 0), listed(Items(), 0);
+        std::vector<int> work = items;
+        for (int item : items)
+            queued[item] = listed[item] = 1;
+        while (!work.empty()) {
+            int item = work.back();
+            work.pop_back();
+            queued[item] = 0;
+            int symbol = NextSymbol(item);
+            if (symbol < 0 || Grammar::IsTerminal(symbol))
+                continue;
+
+            const Production& production = m_Grammar.Productions()[m_Item_production[item]];
+            const int* rest = production.right.data() + m_Item_dot[item] + 1;
+            Set first = m_Sets.FirstOf(rest, production.right.data() + production.right.size());
+            bool nullable = first[END];
+            first[END] = false;
+            if (nullable)
+                first |= lookahead[item];
+
+            for (int p : m_By_left[Grammar::VariableIndex(symbol)]) {
+                int target = m_Item_base[p];
+                Set merged = lookahead[target] | first;
+                bool merged_hash = hash[target] || (nullable && hash[item]);
+                if (merged == lookahead[target] && merged_hash == static_cast<bool>(hash[target]))
+                    continue;
+                if (!listed[target]) {
+                    listed[target] = 1;
+                    items.push_back(target);
+                }
+                lookahead[target] = merged;
+                hash[target] = merged_hash;
+                if (!queued[target]) {
+                    queued[target] = 1;
+                    work.push_back(target);
+                }
+            }
+        }
+    }
+
+    void AddLalrReductions()
+    {
+        // Lookaheads of kernel items: m_Kernels[s][k] -> kernel_lookahead[s][k]
+        std::vector<std::vector<Set>> kernel_lookahead(States());
+        for (int s = 0; s < States(); ++s)
+            kernel_lookahead[s].assign(m_Kernels[s].size(), Set());
+        kernel_lookahead[0][0][END] = true;
+
+        struct Edge {
+            int from_state, from_item, to_state, to_item;
+        };
+        std::vector<Edge> propagate;
+        std::vector<Set> lookahead(Items());
+        std::vector<char> hash(Items(), 0);
+        for (int s = 0; s < States(); ++s) {
+            for (size_t k = 0; k < m_Kernels[s].size(); ++k) {
+                std::fill(lookahead.begin(), lookahead.end(), Set());
+                std::fill(hash.begin(), hash.end(), 0);
+                std::vector<int> items{ m_Kernels[s][k] };
+                hash[items[0]] = 1;
+                Closure1(lookahead, hash, items);
+
+                for (int item : items) {
+                    int symbol = NextSymbol(item);
+                    if (symbol < 0)
+                        continue;
+                    int target = Transition(s, symbol);
+                    const std::vector<int>& kernel = m_Kernels[target];
+                    int index = static_cast<int>(std::lower_bound(kernel.begin(), kernel.end(), item + 1) - kernel.begin());
+                    kernel_lookahead[target][index] |= lookahead[item];
+                    if (hash[item])
+                        propagate.push_back({ s, static_cast<int>(k), target, index });
+                }
+            }
+        }
+
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (const Edge& edge : propagate) {
+                const Set& from = kernel_lookahead[edge.from_state][edge.from_item];
+                Set& to = kernel_lookahead[edge.to_state][edge.to_item];
+                if ((to | from) != to) {
+                    to |= from;
+                    changed = true;
+                }
+            }
+        }
+
+        // Reductions: LR(1) closure of every kernel with its lookaheads
+        // (non-kernel complete items are the ε-productions)
+        for (int s = 0; s < States(); ++s) {
+            std::fill(lookahead.begin(), lookahead.end(), Set());
+            std::fill(hash.begin(), hash.end(), 0);
+            std::vector<int> items = m_Kernels[s];
+            for (size_t k = 0; k < items.size(); ++k)
+                lookahead[items[k]] = kernel_lookahead[s][k];
+            Closure1(lookahead, hash, items);
+            for (int item : items)
+                if (NextSymbol(item) < 0)
+                    Reduce(s, item, lookahead[item]);
+        }
+    }
+
+    void Pack()
+    {
+        int states = States();
+        std::vector<int32_t> defaults(states, ERROR);
+        for (int s = 0; s < states; ++s) {
+            // The most frequent reduction of the row replaces its errors
+            std::map<int32_t, int> count;
+            for (int t = 0; t <= END; ++t) {
+                int32_t value = Action(s, t);
+                if (value < 0 && value != ACCEPT)
+                    ++count[value];
+            }
+            int best = 0;
+            for (const auto& c : count) {
+                if (c.second > best) {
+                    best = c.second;
+                    defaults[s] = c.first;
+                }
+            }
+        }
+        std::vector<int32_t> action = m_Action;
+        for (int s = 0; s < states; ++s)
+            for (int t = 0; t <= END; ++t)
+                if (action[static_cast<size_t>(s) * 257 + t] == ERROR)
+                    action[static_cast<size_t>(s) * 257 + t] = defaults[s];
+        m_Packed_action.Pack(action, states, 257, defaults);
+
+        // GOTO is read only after a valid reduction: empty cells may hold anything
+        std::vector<int32_t> goto_defaults(states, 0);
+        for (int s = 0; s < states; ++s) {
+            std::map<int32_t, int> count;
+            for (int a = 0; a < m_Variables; ++a)
+                if (Goto(s, a) != 0)
+                    ++count[Goto(s, a)];
+            int best = 0;
+            for (const auto& c : count) {
+                if (c.second > best) {
+                    best = c.second;
+                    goto_defaults[s] = c.first;
+                }
+            }
+        }
+        std::vector<int32_t> gotos = m_Goto;
+        for (int s = 0; s < states; ++s)
+            for (int a = 0; a < m_Variables; ++a)
+                if (gotos[static_cast<size_t>(s) * m_Variables + a] == 0)
+                    gotos[static_cast<size_t>(s) * m_Variables + a] = goto_defaults[s];
+        m_Packed_goto.Pack(gotos, states, m_Variables, goto_defaults);
+    }
+
+    static bool Fail(std::string* error, const std::string& message)
+    {
+        if (error)
+            *error = message;
+        return false;
+    }
+
+    Grammar m_Grammar;                         // with S' -> S
+    int m_Augmented = 0;                       // the production S' -> S
+    int m_Variables = 0;
+    FirstFollow m_Sets;
+
+    std::vector<int> m_Item_base;
+    std::vector<int> m_Item_production;
+    std::vector<int> m_Item_dot;
+    std::vector<int> m_Rhs_length;
+    std::vector<int> m_Lhs;
+    std::vector<std::vector<int>> m_By_left;   // productions of every variable
+
+    std::vector<std::vector<int>> m_Kernels;   // sorted kernel items of every state
+    std::vector<std::vector<int>> m_Closures;
+    std::vector<std::vector<std::pair<int, int>>> m_Edges;   // (symbol, state)
+
+    std::vector<std::string> m_Conflicts;
+    std::vector<int32_t> m_Action;             // states x 257
+    std::vector<int32_t> m_Goto;               // states x variables
+    PackedTable m_Packed_action;
+    PackedTable m_Packed_goto;
+};
+
+// Shift-reduce driver. Стек состояний выделяется один раз и растет только
+// при необходимости; цикл разбора - одно чтение ACTION на сдвиг и ACTION +
+// GOTO на свертку. Пробельные символы пропускаются.
+class LrParser {
+public:
+    explicit LrParser(const LrTables& tables, bool packed = true)
+        : m_Tables(tables), m_Packed(packed), m_Stack(1024)
+    {
+    }
+
+    void SetPacked(bool packed) { m_Packed = packed; }
+
+    bool Parse(const char* first, const char* last)
+    {
+        return m_Packed ? Run<true>(first, last) : Run<false>(first, last);
+    }
+
+    // Deepest stack of the last Parse
+    size_t MaxDepth() const { return m_Max_depth; }
+
+private:
+    template <bool Packed>
+    bool Run(const char* first, const char* last)
+    {
+        const LrTables& tables = m_Tables;
+        int32_t* stack = m_Stack.data();
+        size_t capacity = m_Stack.size();
+        size_t top = 0;
+        stack[0] = 0;
+        m_Max_depth = 1;
+
+        const char* p = SkipSpaces(first, last);
+        int t = p == last ? LrTables::END : static_cast<unsigned char>(*p);
+        for (;;) {
+            int32_t action = Packed ? tables.PackedAction().Get(stack[top], t) : tables.Action(stack[top], t);
+            int32_t next;
+            if (action > 0) {
+                next = action - 1;
+                p = SkipSpaces(p + 1, last);
+                t = p == last ? LrTables::END : static_cast<unsigned char>(*p);
+            } else if (action == LrTables::ERROR) {
+                return false;
+            } else if (action == LrTables::ACCEPT) {
+                return true;
+            } else {
+                int production = -action - 1;
+                top -= tables.RhsLength(production);
+                int lhs = tables.Lhs(production);
+                next = Packed ? tables.PackedGoto().Get(stack[top], lhs) : tables.Goto(stack[top], lhs);
+            }
+            if (++top == capacity) {
+                m_Stack.resize(2 * capacity);
+                stack = m_Stack.data();
+                capacity = m_Stack.size();
+            }
+            stack[top] = next;
+            if (top >= m_Max_depth)
+                m_Max_depth = top + 1;
+        }
+    }
+
+    static const char* SkipSpaces(const char* p, const char* last)
+    {
+        while (p != last && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == '\v' || *p == '\f'))
+            ++p;
+        return p;
+    }
+
+    const LrTables& m_Tables;
+    bool m_Packed;
+    std::vector<int32_t> m_Stack;
+    size_t m_Max_depth = 0;
+};
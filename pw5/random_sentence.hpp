@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../common/grammar.hpp"
+
+// Random sentence of a grammar with about `size` characters (for benchmarks):
+// leftmost derivation with random productions; once the text and the pending
+// symbols reach `size`, every variable takes its production closest to a
+// terminal string.
+inline std::string RandomSentence(const Grammar& grammar, std::mt19937& rng, size_t size)
+{
+    const auto& productions = grammar.Productions();
+    // Shortest terminal string derivable from every variable
+    std::vector<size_t> shortest(grammar.Variables(), SIZE_MAX);
+    auto length_of = [&](const std::vector<int>& right) {
+        size_t length = 0;
+        for (int symbol : right) {
+            size_t part = Grammar::IsTerminal(symbol) ? 1 : shortest[Grammar::VariableIndex(symbol)];
+            if (part == SIZE_MAX)
+                return SIZE_MAX;
+            length += part;
+        }
+        return length;
+    };
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (const auto& p : productions) {
+            size_t length = length_of(p.right);
+            size_t& target = shortest[Grammar::VariableIndex(p.left)];
+            if (length < target) {
+                target = length;
+                changed = true;
+            }
+        }
+    }
+    std::vector<std::vector<int>> by_left(grammar.Variables());
+    for (size_t p = 0; p < productions.size(); ++p)
+        by_left[Grammar::VariableIndex(productions[p].left)].push_back(static_cast<int>(p));
+
+    std::string text;
+    std::vector<int> stack = { grammar.Start() };
+    while (!stack.empty()) {
+        int symbol = stack.back();
+        stack.pop_back();
+        if (Grammar::IsTerminal(symbol)) {
+            text += static_cast<char>(symbol);
+            continue;
+        }
+        const std::vector<int>& options = by_left[Grammar::VariableIndex(symbol)];
+        int chosen = options[rng() % options.size()];
+        if (text.size() + stack.size() >= size) {
+            size_t best = SIZE_MAX;
+            for (int p : options) {
+                size_t length = length_of(productions[p].right);
+                if (length < best) {
+                    best = length;
+                    chosen = p;
+                }
+            }
+        }
+        const auto& right = productions[chosen].right;
+        stack.insert(stack.end(), right.rbegin(), right.rend());
+    }
+    return text;
+}
@@ -52,9 +52,16 @@
  */
 
 #include <iostream>
-#include <cctype>
-#include <cstdlib>
+#include <chrono>
+#include <cstdio>
 #include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../common/mapped_file.hpp"
+#include "lexer.hpp"
+#include "random_sentence.hpp"
 
 // Terminals
 const int NEG_SIGN = 0;      // ~
@@ -77,61 +84,105 @@ const int EOP = 14;
 
 const int UNDEF = 15;
 
-// Lexeme class (token)
-int lexeme = 0;
+// End of line: separates records in a file (lexer only)
+const int EOL_SIGN = 16;
+
+// State of one parse: the rest of the record's tokens and the look-ahead
+// lexeme.
+// Глобальных переменных нет, так что разбор можно запускать из нескольких
+// потоков и для любого числа записей подряд. Ошибка не завершает процесс:
+// error() помечает контекст, лексема становится UNDEF (ей не соответствует
+// ни одна ветвь), и рекурсия быстро сворачивается. Хвостовые правила
+// (списки через ; | & =, цепочки ~ и цифр) разбираются циклами, так что
+// стек растет только со вложенностью скобок, а она ограничена MAX_DEPTH:
+// более глубокая запись отвергается, а не роняет процесс.
+struct ParserContext
+{
+    static const int MAX_DEPTH = 10000;
+
+    const Token* token = nullptr;   // next token
+    const Token* end = nullptr;     // end of the record
+    int lexeme = 0;                 // lexeme class (token)
+    int depth = 0;                  // open parentheses
+    bool failed = false;
+};
 
 // Non terminals
-void LIST();
-void LIST_TAIL();
-void ASSIGN();
-void ASSIGN_TAIL();
-void EXPR();
-void ADD();
-void NEXT_EXPR();
-void MUL();
-void UNARY();
-void PRIMARY();
-void ID();
-void ONE_SYM();
-void SEC_SYM();
-void CONST();
-void CONST_TAIL();
-void BINARY();
-void BIT();
-void BIT_TAIL();
-void HEX();
-void HEXDIGIT();
-void HEX_TAIL();
-void DIGIT_TAIL();
-void DIGIT();
-void NZDIGIT();
-
-// Reject input line
-void error();
-
-// Look ahead lexeme
-int get_token();
-
-char g_inputBuffer[1024] = "";
-char* g_prog = nullptr;
+void LIST(ParserContext& ctx);
+void LIST_TAIL(ParserContext& ctx);
+void ASSIGN(ParserContext& ctx);
+void ASSIGN_TAIL(ParserContext& ctx);
+void EXPR(ParserContext& ctx);
+void ADD(ParserContext& ctx);
+void NEXT_EXPR(ParserContext& ctx);
+void MUL(ParserContext& ctx);
+void UNARY(ParserContext& ctx);
+void PRIMARY(ParserContext& ctx);
+void ID(ParserContext& ctx);
+void ONE_SYM(ParserContext& ctx);
+void SEC_SYM(ParserContext& ctx);
+void CONST(ParserContext& ctx);
+void CONST_TAIL(ParserContext& ctx);
+void BINARY(ParserContext& ctx);
+void BIT(ParserContext& ctx);
+void BIT_TAIL(ParserContext& ctx);
+void HEX(ParserContext& ctx);
+void HEXDIGIT(ParserContext& ctx);
+void HEX_TAIL(ParserContext& ctx);
+void DIGIT_TAIL(ParserContext& ctx);
+void DIGIT(ParserContext& ctx);
+void NZDIGIT(ParserContext& ctx);
+
+// Reject the record
+void error(ParserContext& ctx);
+
+// Whole record (tokens [first, last)): true if it is a program of the grammar
+bool parse_record(const Token* first, const Token* last, ParserContext& ctx);
+
+// Lexer of the terminals above, built once
+const Lexer& statement_lexer();
+
+// Look ahead lexeme: the next token of the record
+int get_token(ParserContext& ctx);
+
+// Every line of the file is a record, one verdict per line ('1' / '0');
+// the file is mapped into memory and tokenized in blocks of whole lines, the
+// parser then walks the token array
+int check_file(const char* path);
+
+// Long and deeply nested records with known verdicts: the parser must give
+// them without overflowing the call stack
+int run_tests();
+
+// Lexer alone: bytes per second of every SIMD kernel on a file or on random
+// programs of "LL(1) for program.jff", the tokens checked against the scalar
+// kernel
+int run_bench(const char* path);
 
 int main(int argc, char* argv[])
 {
+    if (argc > 2 && std::strcmp(argv[1], "-f") == 0)
+        return check_file(argv[2]);
+    if (argc > 1 && std::strcmp(argv[1], "--test") == 0)
+        return run_tests();
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0)
+        return run_bench(argc > 2 ? argv[2] : nullptr);
+
+    std::string line;
     if (1 == argc)
     {
         std::cout << "Enter your input line: ";
-        std::cin.getline(g_inputBuffer, 1024);
+        std::getline(std::cin, line);
     }
     else
     {
-        std::strcpy(g_inputBuffer, argv[1]);
+        line = argv[1];
     }
 
-    g_prog = g_inputBuffer;
-
-    lexeme = get_token();
-    LIST();
-    if (lexeme == EOP)
+    std::vector<Token> tokens;
+    size_t count = statement_lexer().Tokenize(line.data(), line.data() + line.size(), tokens);
+    ParserContext ctx;
+    if (count != Lexer::TOO_LONG && parse_record(tokens.data(), tokens.data() + count, ctx))
         std::cout << "Accepted.\n";
     else
         std::cout << "Rejected.\n";
@@ -139,351 +190,554 @@ int main(int argc, char* argv[])
     return 0;
 }
 
-void LIST()
+bool parse_record(const Token* first, const Token* last, ParserContext& ctx)
 {
-    ASSIGN();
-    LIST_TAIL();
+    ctx.token = first;
+    ctx.end = last;
+    ctx.depth = 0;
+    ctx.failed = false;
+
+    ctx.lexeme = get_token(ctx);
+    LIST(ctx);
+    return !ctx.failed && ctx.lexeme == EOP;
+}
+
+int check_file(const char* path)
+{
+    MappedFile file;
+    std::string message;
+    if (!file.Open(path, &message))
+    {
+        std::cerr << message << "\n";
+        return 1;
+    }
+
+    const Lexer& lexer = statement_lexer();
+    const char* p = file.Data();
+    const char* end = p + file.Size();
+    ParserContext ctx;
+    std::vector<Token> tokens;
+    std::vector<char> verdicts;
+    size_t records = 0;
+    size_t accepted = 0;
+    size_t too_long = 0;
+    double lex_seconds = 0;
+    double parse_seconds = 0;
+
+    // 64 KB of text: its tokens stay in the cache for the parser
+    const ptrdiff_t BLOCK = 1 << 16;
+    while (p < end)
+    {
+        // A block of whole lines, about BLOCK bytes
+        const char* last = end;
+        if (end - p > BLOCK)
+        {
+            const char* eol = static_cast<const char*>(std::memchr(p + BLOCK, '\n', end - p - BLOCK));
+            last = eol ? eol + 1 : end;
+            // Longer than the token offsets allow: the lines before the
+            // BLOCK mark go first, so the block is the long line alone
+            if (static_cast<size_t>(last - p) > Lexer::MAX_TEXT)
+            {
+                const char* before = static_cast<const char*>(memrchr(p, '\n', BLOCK));
+                if (before)
+                    last = before + 1;
+            }
+        }
+        if (static_cast<size_t>(last - p) > Lexer::MAX_TEXT)
+        {
+            // One line over 4 GB: rejected without tokenizing
+            ++records;
+            ++too_long;
+            std::fputs("0\n", stdout);
+            p = last;
+            continue;
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        size_t count = lexer.Tokenize(p, last, tokens);
+        auto lexed = std::chrono::steady_clock::now();
+
+        const Token* record = tokens.data();
+        const Token* stop = tokens.data() + count;
+        for (const Token* t = record; t != stop; ++t)
+        {
+            if (t->kind != EOL_SIGN)
+                continue;
+            bool ok = parse_record(record, t, ctx);
+            ++records;
+            accepted += ok;
+            verdicts.push_back(ok ? '1' : '0');
+            verdicts.push_back('\n');
+            record = t + 1;
+        }
+        // The last line of the file without '\n'
+        if (last[-1] != '\n')
+        {
+            bool ok = parse_record(record, stop, ctx);
+            ++records;
+            accepted += ok;
+            verdicts.push_back(ok ? '1' : '0');
+            verdicts.push_back('\n');
+        }
+        auto parsed = std::chrono::steady_clock::now();
+        lex_seconds += std::chrono::duration<double>(lexed - begin).count();
+        parse_seconds += std::chrono::duration<double>(parsed - lexed).count();
+
+        std::fwrite(verdicts.data(), 1, verdicts.size(), stdout);
+        verdicts.clear();
+        p = last;
+    }
+
+    if (too_long > 0)
+        std::fprintf(stderr, "%zu records over %zu bytes rejected\n", too_long, Lexer::MAX_TEXT);
+    double mb = file.Size() / 1e6;
+    std::fprintf(stderr, "%zu records, %zu accepted, %.1f MB: lexer %.3f s (%.2f GB/s), parser %.3f s (%.1f MB/s, %.2f M records/s)\n",
+                 records, accepted, mb, lex_seconds, mb / 1e3 / lex_seconds, parse_seconds, mb / parse_seconds,
+                 records / 1e6 / parse_seconds);
+    return 0;
 }
 
-void LIST_TAIL()
+int run_tests()
 {
-    if (lexeme == SEMI_SIGN)
+    auto repeat = [](const std::string& text, int count)
+    {
+        std::string result;
+        result.reserve(text.size() * count);
+        for (int i = 0; i < count; ++i)
+            result += text;
+        return result;
+    };
+    const int n = 300000;
+    const int deep = ParserContext::MAX_DEPTH;
+    struct Case
+    {
+        const char* name;
+        std::string input;
+        bool expected;
+    };
+    const Case cases[] = {
+        { "1 and 300k zeros", "1" + std::string(n, '0'), true },
+        { "0x and 300k hex digits", "0x" + repeat("a1f9", n / 4), true },
+        { "0b and 300k bits", "0b" + repeat("10", n / 2), true },
+        { "300k zeros and |", "1" + std::string(n, '0') + "|", false },
+        { "300k ~", std::string(n, '~') + "h", true },
+        { "300k |", repeat("h|", n) + "h", true },
+        { "300k &", repeat("h&", n) + "h", true },
+        { "300k =", repeat("h=", n) + "h", true },
+        { "300k ;", repeat("h;", n) + "h", true },
+        { "300k ; and trailing ;", repeat("h;", n), false },
+        { "nesting at the limit", std::string(deep, '(') + "h" + std::string(deep, ')'), true },
+        { "nesting over the limit", std::string(deep + 1, '(') + "h" + std::string(deep + 1, ')'), false },
+        { "200k nested parentheses", std::string(200000, '(') + "h" + std::string(200000, ')'), false },
+        { "200k unclosed parentheses", std::string(200000, '('), false },
+    };
+
+    const Lexer& lexer = statement_lexer();
+    std::vector<Token> tokens;
+    ParserContext ctx;
+    int failed = 0;
+    for (const Case& c : cases)
+    {
+        size_t count = lexer.Tokenize(c.input.data(), c.input.data() + c.input.size(), tokens);
+        bool ok = parse_record(tokens.data(), tokens.data() + count, ctx);
+        std::printf("%-28s %s %s\n", c.name, ok ? "accepted" : "rejected", ok == c.expected ? "ok" : "MISMATCH");
+        failed += ok != c.expected;
+    }
+    return failed == 0 ? 0 : 1;
+}
+
+int run_bench(const char* path)
+{
+    std::string text;
+    if (path)
     {
-        lexeme = get_token();
-        ASSIGN();
-        LIST_TAIL();
+        MappedFile file;
+        std::string message;
+        if (!file.Open(path, &message))
+        {
+            std::cerr << message << "\n";
+            return 1;
+        }
+        text.assign(file.Data(), file.Size());
     }
-    // Или ε
+    else
+    {
+        // About 16 MB of programs, a line each, with spaces around = and |
+        Grammar grammar;
+        std::string message;
+        if (!grammar.Load("LL(1) for program.jff", &message))
+        {
+            std::cerr << "LL(1) for program.jff: " << message << "\n";
+            return 1;
+        }
+        std::mt19937 rng(17);
+        while (text.size() < (16u << 20))
+        {
+            for (char ch : RandomSentence(grammar, rng, 20 + rng() % 2000))
+            {
+                if (ch == '=' || ch == '|')
+                    text += ' ';
+                text += ch;
+                if (ch == '=' || ch == '|' || ch == ';')
+                    text += ' ';
+            }
+            text += '\n';
+        }
+    }
+    if (text.size() > Lexer::MAX_TEXT)
+    {
+        std::cerr << "the text is over " << Lexer::MAX_TEXT << " bytes\n";
+        return 1;
+    }
+
+    // 64 KB blocks as in -f keep the tokens in the cache, 1 MB ones do not
+    std::vector<Token> expected, tokens;
+    size_t expected_count = 0;
+    bool all = true;
+    for (int kernel = KERNEL_SCALAR; kernel <= DetectSimdKernel(); ++kernel)
+    {
+        Lexer lexer = statement_lexer();
+        lexer.SetKernel(kernel);
+        if (lexer.Kernel() != kernel)
+            continue;
+        for (size_t block : { size_t(1) << 16, size_t(1) << 20 })
+        {
+            double best = 1e9;
+            size_t count = 0;
+            for (int round = 0; round < 5; ++round)
+            {
+                count = 0;
+                auto begin = std::chrono::steady_clock::now();
+                for (size_t p = 0; p < text.size(); p += block)
+                    count += lexer.Tokenize(text.data() + p, text.data() + std::min(text.size(), p + block), tokens);
+                best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+            }
+            // The whole text at once against the scalar kernel
+            count = lexer.Tokenize(text.data(), text.data() + text.size(), tokens);
+            bool same = true;
+            if (kernel == KERNEL_SCALAR)
+            {
+                expected = tokens;
+                expected_count = count;
+            }
+            else
+            {
+                same = count == expected_count;
+                for (size_t i = 0; i < count && same; ++i)
+                    same = tokens[i].offset == expected[i].offset && tokens[i].kind == expected[i].kind;
+            }
+            all = all && same;
+            std::printf("%-10s %4zu KB blocks: %.1f MB, %zu tokens (%.2f per byte), %.2f GB/s, %.0f M tokens/s %s\n",
+                        SimdKernelName(kernel), block >> 10, text.size() / 1e6, count, (double)count / text.size(),
+                        text.size() / 1e9 / best, count / 1e6 / best, same ? "ok" : "MISMATCH");
+        }
+    }
+    return all ? 0 : 1;
 }
 
-void ASSIGN()
+const Lexer& statement_lexer()
 {
-    EXPR();
-    ASSIGN_TAIL();
+    static const Lexer lexer = []
+    {
+        Lexer lexer;
+        lexer.AddLiteral(NEG_SIGN, "~");
+        lexer.AddLiteral(MUL_SIGN, "&");
+        lexer.AddLiteral(ADD_SIGN, "|");
+        lexer.AddLiteral(ASSIGN_SIGN, "=");
+        lexer.AddLiteral(LPAR_SIGN, "(");
+        lexer.AddLiteral(RPAR_SIGN, ")");
+        lexer.AddLiteral(SEMI_SIGN, ";");
+        lexer.AddClass(ID_SIGN, "hijklmnopqrstuvwyz");
+        lexer.AddClass(DIGIT_SIGN, "23456789");
+        lexer.AddLiteral(ZERO_SIGN, "0");
+        lexer.AddLiteral(BIT_SIGN, "1");
+        lexer.AddClass(HEX_SIGN, "acdef");
+        lexer.AddLiteral(B_SIGN, "b");
+        lexer.AddLiteral(X_SIGN, "x");
+        lexer.AddLiteral(EOL_SIGN, "\n");
+        lexer.SetSkip(" \t\r\v\f");
+        lexer.Compile();
+        return lexer;
+    }();
+    return lexer;
 }
 
-void ASSIGN_TAIL()
+void LIST(ParserContext& ctx)
 {
-    if (lexeme == ASSIGN_SIGN)
+    ASSIGN(ctx);
+    LIST_TAIL(ctx);
+}
+
+void LIST_TAIL(ParserContext& ctx)
+{
+    // ; ASSIGN LIST_TAIL - loop instead of the tail call
+    while (ctx.lexeme == SEMI_SIGN)
     {
-        lexeme = get_token();
-        ASSIGN();
+        ctx.lexeme = get_token(ctx);
+        ASSIGN(ctx);
     }
     // Или ε
 }
 
-void EXPR()
+void ASSIGN(ParserContext& ctx)
 {
-    NEXT_EXPR();
-    ADD();
+    EXPR(ctx);
+    ASSIGN_TAIL(ctx);
 }
 
-void ADD()
+void ASSIGN_TAIL(ParserContext& ctx)
 {
-    if (lexeme == ADD_SIGN)
+    // = ASSIGN, where ASSIGN is EXPR ASSIGN_TAIL: a loop over "= EXPR"
+    while (ctx.lexeme == ASSIGN_SIGN)
     {
-        lexeme = get_token();
-        NEXT_EXPR();
-        ADD();
+        ctx.lexeme = get_token(ctx);
+        EXPR(ctx);
     }
     // Или ε
 }
 
-void NEXT_EXPR()
+void EXPR(ParserContext& ctx)
 {
-    UNARY();
-    MUL();
+    NEXT_EXPR(ctx);
+    ADD(ctx);
 }
 
-void MUL()
+void ADD(ParserContext& ctx)
 {
-    if (lexeme == MUL_SIGN)
+    while (ctx.lexeme == ADD_SIGN)
     {
-        lexeme = get_token();
-        UNARY();
-        MUL();
+        ctx.lexeme = get_token(ctx);
+        NEXT_EXPR(ctx);
     }
     // Или ε
 }
 
-void UNARY()
+void NEXT_EXPR(ParserContext& ctx)
+{
+    UNARY(ctx);
+    MUL(ctx);
+}
+
+void MUL(ParserContext& ctx)
 {
-    if (lexeme == NEG_SIGN)
+    while (ctx.lexeme == MUL_SIGN)
     {
-        lexeme = get_token();
-        UNARY();
+        ctx.lexeme = get_token(ctx);
+        UNARY(ctx);
     }
-    else
+    // Или ε
+}
+
+void UNARY(ParserContext& ctx)
+{
+    // ~ UNARY: any number of ~, then PRIMARY
+    while (ctx.lexeme == NEG_SIGN)
     {
-        PRIMARY();
+        ctx.lexeme = get_token(ctx);
     }
+    PRIMARY(ctx);
 }
 
-void PRIMARY()
+void PRIMARY(ParserContext& ctx)
 {
-    if (lexeme == ID_SIGN || lexeme == HEX_SIGN || lexeme == B_SIGN || lexeme == X_SIGN)
+    if (ctx.lexeme == ID_SIGN || ctx.lexeme == HEX_SIGN || ctx.lexeme == B_SIGN || ctx.lexeme == X_SIGN)
     {   
-        ID();
+        ID(ctx);
     } 
-    else if (lexeme == ZERO_SIGN || lexeme == BIT_SIGN || lexeme == DIGIT_SIGN)
+    else if (ctx.lexeme == ZERO_SIGN || ctx.lexeme == BIT_SIGN || ctx.lexeme == DIGIT_SIGN)
     {   
-        CONST();
+        CONST(ctx);
     }
-    else if (lexeme == LPAR_SIGN)
+    else if (ctx.lexeme == LPAR_SIGN)
     {
-        lexeme = get_token();
-        EXPR();
-        if (lexeme != RPAR_SIGN)
+        // The only real recursion: its depth is bounded
+        if (++ctx.depth > ParserContext::MAX_DEPTH)
         {
-            error();
+            error(ctx);
+            return;
         }
-        lexeme = get_token();
+        ctx.lexeme = get_token(ctx);
+        EXPR(ctx);
+        if (ctx.lexeme != RPAR_SIGN)
+        {
+            error(ctx);
+        }
+        ctx.lexeme = get_token(ctx);
+        --ctx.depth;
     }
     else
     {
-        error();
+        error(ctx);
     }
 }
 
-void ID()
+void ID(ParserContext& ctx)
 {
-    ONE_SYM();
-    SEC_SYM();
+    ONE_SYM(ctx);
+    SEC_SYM(ctx);
 }
 
-void ONE_SYM(){
-    if (lexeme != ID_SIGN && lexeme != HEX_SIGN && lexeme != B_SIGN && lexeme != X_SIGN) {
-        error();
+void ONE_SYM(ParserContext& ctx){
+    if (ctx.lexeme != ID_SIGN && ctx.lexeme != HEX_SIGN && ctx.lexeme != B_SIGN && ctx.lexeme != X_SIGN) {
+        error(ctx);
     }
-    lexeme = get_token();
+    ctx.lexeme = get_token(ctx);
 }
 
-void SEC_SYM()
+void SEC_SYM(ParserContext& ctx)
 {
-    if (lexeme == ID_SIGN || lexeme == HEX_SIGN || lexeme == B_SIGN || lexeme == X_SIGN) {
-        ONE_SYM();
+    if (ctx.lexeme == ID_SIGN || ctx.lexeme == HEX_SIGN || ctx.lexeme == B_SIGN || ctx.lexeme == X_SIGN) {
+        ONE_SYM(ctx);
     }
     // Или ε
 }
 
-void CONST()
+void CONST(ParserContext& ctx)
 {
-    if (lexeme == ZERO_SIGN)
+    if (ctx.lexeme == ZERO_SIGN)
     {
-        lexeme = get_token();
-        CONST_TAIL();
+        ctx.lexeme = get_token(ctx);
+        CONST_TAIL(ctx);
     }
-    else if (lexeme == DIGIT_SIGN || lexeme == BIT_SIGN)
+    else if (ctx.lexeme == DIGIT_SIGN || ctx.lexeme == BIT_SIGN)
     {
-        lexeme = get_token();
-        DIGIT_TAIL();
+        ctx.lexeme = get_token(ctx);
+        DIGIT_TAIL(ctx);
     }
     else
     {
-        error();
+        error(ctx);
     }
 }
 
-void CONST_TAIL()
+void CONST_TAIL(ParserContext& ctx)
 {
-    if (lexeme == B_SIGN)
+    if (ctx.lexeme == B_SIGN)
     {
-        lexeme = get_token();
-        BINARY();
+        ctx.lexeme = get_token(ctx);
+        BINARY(ctx);
     }
-    else if (lexeme == X_SIGN)
+    else if (ctx.lexeme == X_SIGN)
     {
-        lexeme = get_token();
-        HEX();
+        ctx.lexeme = get_token(ctx);
+        HEX(ctx);
     }
     else
     {
-        DIGIT_TAIL();
+        DIGIT_TAIL(ctx);
     }
 }
 
-void BINARY()
+void BINARY(ParserContext& ctx)
 {
-    BIT();
-    BIT_TAIL();
+    BIT(ctx);
+    BIT_TAIL(ctx);
 }
 
-void BIT()
+void BIT(ParserContext& ctx)
 {
-    if (lexeme == ZERO_SIGN || lexeme == BIT_SIGN)
+    if (ctx.lexeme == ZERO_SIGN || ctx.lexeme == BIT_SIGN)
     {
-        lexeme = get_token();
+        ctx.lexeme = get_token(ctx);
     }
     else
     {
-        error();
+        error(ctx);
     }
 }
 
-void BIT_TAIL()
+void BIT_TAIL(ParserContext& ctx)
 {
-    if (lexeme == ZERO_SIGN || lexeme == BIT_SIGN)
+    while (ctx.lexeme == ZERO_SIGN || ctx.lexeme == BIT_SIGN)
     {
-        BIT();
-        BIT_TAIL();
+        BIT(ctx);
     }
     // Или ε
 }
 
 
-void HEX()
+void HEX(ParserContext& ctx)
 {
-    HEXDIGIT();
-    HEX_TAIL();
+    HEXDIGIT(ctx);
+    HEX_TAIL(ctx);
 }
 
-void HEXDIGIT()
+void HEXDIGIT(ParserContext& ctx)
 {
-    if (lexeme == DIGIT_SIGN || lexeme == BIT_SIGN || lexeme == ZERO_SIGN || lexeme == HEX_SIGN || lexeme == B_SIGN)
+    if (ctx.lexeme == DIGIT_SIGN || ctx.lexeme == BIT_SIGN || ctx.lexeme == ZERO_SIGN || ctx.lexeme == HEX_SIGN || ctx.lexeme == B_SIGN)
     {
-        lexeme = get_token();
+        ctx.lexeme = get_token(ctx);
     }
     else
     {
-        error();
+        error(ctx);
     }
 }
 
-void HEX_TAIL()
+void HEX_TAIL(ParserContext& ctx)
 {
-    if (lexeme == DIGIT_SIGN || lexeme == BIT_SIGN || lexeme == ZERO_SIGN || lexeme == HEX_SIGN || lexeme == B_SIGN)
+    while (ctx.lexeme == DIGIT_SIGN || ctx.lexeme == BIT_SIGN || ctx.lexeme == ZERO_SIGN || ctx.lexeme == HEX_SIGN || ctx.lexeme == B_SIGN)
     {
-        HEXDIGIT();
-        HEX_TAIL();
+        HEXDIGIT(ctx);
     }
     // Или ε
 }
 
 
-void DIGIT()
+void DIGIT(ParserContext& ctx)
 {
-    if (lexeme == ZERO_SIGN)
+    if (ctx.lexeme == ZERO_SIGN)
     {
-        lexeme = get_token();
+        ctx.lexeme = get_token(ctx);
     }
     else
     {
-        NZDIGIT();
+        NZDIGIT(ctx);
     }
 }
 
-void DIGIT_TAIL()
+void DIGIT_TAIL(ParserContext& ctx)
 {
-    if (lexeme == DIGIT_SIGN || lexeme == BIT_SIGN || lexeme == ZERO_SIGN)
+    while (ctx.lexeme == DIGIT_SIGN || ctx.lexeme == BIT_SIGN || ctx.lexeme == ZERO_SIGN)
     {
-        DIGIT();
-        DIGIT_TAIL();
+        DIGIT(ctx);
     }
     // Или ε
 }
 
-void NZDIGIT()
+void NZDIGIT(ParserContext& ctx)
 {
-    if (lexeme == DIGIT_SIGN || lexeme == BIT_SIGN)
+    if (ctx.lexeme == DIGIT_SIGN || ctx.lexeme == BIT_SIGN)
     {
-        lexeme = get_token();
+        ctx.lexeme = get_token(ctx);
     }
     else
     {
-        error();
+        error(ctx);
     }
 }
 
 
-int get_token()
+int get_token(ParserContext& ctx)
 {
-    char token[132] = "";
-    char* tok = token;
+    // After an error the record is not read any further
+    if (ctx.failed)
+        return UNDEF;
 
-    // Skip spaces
-    while (std::isspace(*g_prog))
-        ++g_prog;
+    // Line breaks inside a record are spaces
+    while (ctx.token != ctx.end && ctx.token->kind == EOL_SIGN)
+        ++ctx.token;
 
-    // End line marker
-    if (*g_prog == '\0')
+    // End of the record
+    if (ctx.token == ctx.end)
         return EOP;
 
-    // Keywords
-    if (*g_prog == '~')
-    {
-        ++g_prog;
-        return NEG_SIGN;
-    }
-    if (*g_prog == '&')
-    {
-        ++g_prog;
-        return MUL_SIGN;
-    }
-    if (*g_prog == '|')
-    {
-        ++g_prog;
-        return ADD_SIGN;
-    }
-    if (*g_prog == '=')
-    {
-        ++g_prog;
-        return ASSIGN_SIGN;
-    }
-    if (*g_prog == '(')
-    {
-        ++g_prog;
-        return LPAR_SIGN;
-    }
-    if (*g_prog == ')')
-    {
-        ++g_prog;
-        return RPAR_SIGN;
-    }
-    if (*g_prog == ';')
-    {
-        ++g_prog;
-        return SEMI_SIGN;
-    }
-    if ((*g_prog >= 'h' && *g_prog < 'x') || (*g_prog >= 'y' && *g_prog <= 'z'))
-    {
-        ++g_prog;
-        return ID_SIGN;
-    }
-    if (*g_prog >= '2' && *g_prog <= '9')
-    {
-        ++g_prog;
-        return DIGIT_SIGN;
-    }
-    if (*g_prog == '0')
-    {
-        ++g_prog;
-        return ZERO_SIGN;
-    }
-    if (*g_prog == '1')
-    {
-        ++g_prog;
-        return BIT_SIGN;
-    }
-    if (*g_prog == 'a' || (*g_prog >= 'c' && *g_prog <= 'f'))
-    {
-        ++g_prog;
-        return HEX_SIGN;
-    }
-    if (*g_prog == 'b')
-    {
-        ++g_prog;
-        return B_SIGN;
-    }
-    if (*g_prog == 'x')
-    {
-        ++g_prog;
-        return X_SIGN;
-    }
-    return UNDEF;
+    int kind = (ctx.token++)->kind;
+    return kind == Lexer::ERROR ? UNDEF : kind;
 }
 
-void error()
+void error(ParserContext& ctx)
 {
-    std::cout << "Rejected.\n";
-    std::exit(EXIT_FAILURE);
+    ctx.failed = true;
+    ctx.lexeme = UNDEF;
 }
\ No newline at end of file
@@ -0,0 +1,478 @@
+// Multi-tape Turing machine from a JFLAP file (pw6/TM-Calculator.jff by
+// default: f(x) = 2^(x!) in unary, x - the number of 1s of the input).
+//
+//   tm                           - the calculator of this work, a line is
+//                                  entered from the keyboard
+//   tm <file.jff> [input]        - machine from the file; with `input` every
+//                                  line of it is run ('1' - accepted, '0' -
+//                                  rejected), the statistics go to stderr
+//   tm --run <file.jff> <word>   - one run with the tapes, step count, visited
+//                                  cells and time of every phase
+//   tm --bench                   - steps per second on the machines of this
+//                                  work against a simulator that searches the
+//                                  transition list and shifts string tapes,
+//                                  and the time of the run-length simulator
+//   tm --rle ...                 - the modes above on run-length tapes with
+//                                  macro steps (TmRleRunner)
+//   tm --batch <file.jff> <file> [threads] [steps] [ms]
+//                                - every line of the file on a thread pool
+//                                  with a step and time limit per word;
+//                                  "<line> <verdict> <steps>" as the words
+//                                  finish, the throughput goes to stderr
+
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../common/record_reader.hpp"
+#include "../common/work_pool.hpp"
+#include "tm.hpp"
+#include "tm_batch.hpp"
+#include "tm_rle.hpp"
+
+const char *DEFAULT_MACHINE = "TM-Calculator.jff";
+
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::time_point from)
+{
+    return std::chrono::duration<double>(Clock::now() - from).count();
+}
+
+bool LoadMachine(const char *path, TuringMachine &machine)
+{
+    JffDocument doc;
+    std::string error;
+    if (!doc.Load(path, &error) || !machine.Load(doc, &error))
+    {
+        std::fprintf(stderr, "%s: %s\n", path, error.c_str());
+        return false;
+    }
+    return true;
+}
+
+const char *ResultText(int result)
+{
+    return result == TM_ACCEPTED   ? "accepted"
+           : result == TM_REJECTED ? "rejected"
+           : result == TM_TIMEOUT  ? "timeout"
+                                   : "step limit";
+}
+
+// Tape text for printing: long tapes are cut in the middle
+std::string Abbreviated(const std::string &text)
+{
+    if (text.size() <= 60)
+        return text;
+    return text.substr(0, 28) + "..." + text.substr(text.size() - 28) + " (" + std::to_string(text.size()) + " symbols)";
+}
+
+// The way a simple simulator works: transitions searched in the file order at
+// every step, tapes are strings, a step left of the start inserts a blank
+class NaiveRunner
+{
+public:
+    NaiveRunner(const JffDocument &doc) : m_Doc(doc) {}
+
+    int Run(const std::string &input, uint64_t limit, uint64_t &steps)
+    {
+        std::vector<std::string> tapes(m_Doc.Tapes());
+        std::vector<size_t> heads(m_Doc.Tapes(), 0);
+        tapes[0] = input;
+        int state = m_Doc.InitialState();
+        for (steps = 0; steps < limit && !m_Doc.States()[state].final; ++steps)
+        {
+            const JffTransition *found = nullptr;
+            for (const JffTransition &t : m_Doc.Transitions())
+            {
+                if (t.from != state)
+                    continue;
+                bool match = true;
+                for (int k = 0; k < m_Doc.Tapes() && match; ++k)
+                {
+                    char under = heads[k] < tapes[k].size() ? tapes[k][heads[k]] : ' ';
+                    std::string_view read = m_Doc.Label(t, JFF_READ, k + 1);
+                    match = (read.empty() ? ' ' : read[0]) == under;
+                }
+                if (match)
+                {
+                    found = &t;
+                    break;
+                }
+            }
+            if (!found)
+                return TM_REJECTED;
+            for (int k = 0; k < m_Doc.Tapes(); ++k)
+            {
+                std::string_view write = m_Doc.Label(*found, JFF_WRITE, k + 1);
+                if (heads[k] >= tapes[k].size())
+                    tapes[k].resize(heads[k] + 1, ' ');
+                tapes[k][heads[k]] = write.empty() ? ' ' : write[0];
+                std::string_view move = m_Doc.Label(*found, JFF_MOVE, k + 1);
+                if (move == "R")
+                    ++heads[k];
+                else if (move == "L" && heads[k] == 0)
+                    tapes[k].insert(tapes[k].begin(), ' ');
+                else if (move == "L")
+                    --heads[k];
+            }
+            state = found->to;
+        }
+        if (m_Doc.States()[state].final)
+            return TM_ACCEPTED;
+        return steps == limit ? TM_STEP_LIMIT : TM_REJECTED;
+    }
+
+private:
+    const JffDocument &m_Doc;
+};
+
+void BenchCase(const char *name, const JffDocument &doc, const TuringMachine &machine, const std::string &input,
+               bool naive, bool rle, uint64_t limit = UINT64_MAX)
+{
+    TmRunner runner(machine);
+    auto begin = Clock::now();
+    int result = runner.Run(input.data(), input.data() + input.size(), limit);
+    double seconds = Seconds(begin);
+    const TmStats &stats = runner.Stats();
+    int64_t cells = 0;
+    for (int t = 0; t < machine.Tapes(); ++t)
+        cells += stats.high[t] - stats.low[t] + 1;
+    std::printf("%-22s n=%-6zu %-8s %12llu steps %10.3f ms %7.1f M steps/s, %9lld cells visited",
+                name, input.size(), ResultText(result), (unsigned long long)stats.steps, seconds * 1e3,
+                stats.steps / 1e6 / seconds, (long long)cells);
+    if (naive)
+    {
+        NaiveRunner baseline(doc);
+        uint64_t steps;
+        begin = Clock::now();
+        int verdict = baseline.Run(input, stats.steps + 1, steps);
+        seconds = Seconds(begin);
+        std::printf(" | naive: %9.3f ms %6.1f M steps/s%s", seconds * 1e3, steps / 1e6 / seconds,
+                    verdict == result && steps == stats.steps ? "" : " MISMATCH");
+    }
+    std::printf("\n");
+    if (!rle)
+        return;
+
+    // The same run on run-length tapes: to the end even where the step limit
+    // cut the run above
+    TmRleRunner macro(machine);
+    begin = Clock::now();
+    int verdict = macro.Run(input.data(), input.data() + input.size());
+    seconds = Seconds(begin);
+    bool same = verdict == result && macro.Stats().steps == stats.steps && macro.State() == runner.State();
+    for (int t = 0; t < machine.Tapes() && same; ++t)
+        same = macro.Contents(t) == runner.Contents(t);
+    char macro_steps[64];
+    std::snprintf(macro_steps, sizeof(macro_steps),
+                  macro.Dense() ? "TmRunner after %llu macro steps" : "%9llu macro steps (%.1f steps each)",
+                  (unsigned long long)macro.MacroSteps(), (double)macro.Stats().steps / macro.MacroSteps());
+    std::printf("%-22s %8s %-8s %12llu steps %10.3f ms, %s%s\n", "  run-length", "", ResultText(verdict),
+                (unsigned long long)macro.Stats().steps, seconds * 1e3, macro_steps,
+                result == TM_STEP_LIMIT || same ? "" : " MISMATCH");
+}
+
+int RunBenchmark()
+{
+    for (const char *path : { "TM-Calculator.jff", "TM-Calculator-New.jff", "TM-Recognizer.jff" })
+    {
+        JffDocument doc;
+        TuringMachine machine;
+        std::string error;
+        if (!doc.Load(path, &error) || !machine.Load(doc, &error))
+        {
+            std::fprintf(stderr, "%s: %s\n", path, error.c_str());
+            return 1;
+        }
+        std::printf("%s: %d states, %d tape(s), %d symbols, table %.1f KB\n", path, machine.States(), machine.Tapes(),
+                    machine.Symbols(), machine.TableBytes() / 1024.0);
+        if (std::strcmp(path, "TM-Recognizer.jff") == 0)
+        {
+            // Quadratic: every a is matched with a b by a sweep. No runs of
+            // one symbol here: the run-length simulator goes on with TmRunner
+            for (size_t n : { 100, 1000, 10000, 30000 })
+            {
+                std::string word;
+                for (size_t i = 0; i < n; ++i)
+                    word += "ab"[i % 2];
+                BenchCase(path, doc, machine, word + "a", n <= 1000, n <= 10000);
+            }
+            continue;
+        }
+        // 2^(x!) ones: x = 4 is 2^24 ones, x = 5 is out of reach. The
+        // one-tape machine is quadratic in the output, x = 4 is cut by a limit
+        // (about 1.9 * 10^14 steps, only the run-length simulator ends it)
+        bool single = machine.Tapes() == 1;
+        for (size_t x : { 0, 1, 2, 3, 4 })
+            BenchCase(path, doc, machine, std::string(x, '1'), x <= 3, true, single && x == 4 ? 300000000 : UINT64_MAX);
+    }
+
+    // Passes of several states, the fallback to TmRunner and the stop before
+    // an endless pass; the steps, tapes and visited cells as on TmRunner
+    struct Check
+    {
+        const char *name;
+        const char *transitions;
+        std::string input;
+        bool dense;         // the macro steps give too little
+        bool diverges;
+        uint64_t limit;
+    };
+    const Check checks[] = {
+        // q0 -[□/1,R]-> q0 on the empty word writes 1s forever: the
+        // simulator must stop at the endless macro step instead of taking it
+        { "q0 -[_/1,R]-> q0", "<transition><from>0</from><to>0</to><read/><write>1</write><move>R</move></transition>",
+          "", false, true, UINT64_MAX },
+        // Parity of 1^n: a pass of two states, 2 cells each
+        { "parity", "<transition><from>0</from><to>1</to><read>1</read><write>1</write><move>R</move></transition>"
+                    "<transition><from>1</from><to>0</to><read>1</read><write>1</write><move>R</move></transition>"
+                    "<transition><from>0</from><to>3</to><read/><write/><move>S</move></transition>",
+          std::string(1000000, '1'), false, false, UINT64_MAX },
+        // 1 -> 0 with a look two cells ahead and a step back: the pass reads
+        // past the cell it stops at, the limit cuts the run in the middle
+        { "look ahead", "<transition><from>0</from><to>1</to><read>1</read><write>0</write><move>R</move></transition>"
+                        "<transition><from>1</from><to>2</to><read>1</read><write>1</write><move>R</move></transition>"
+                        "<transition><from>2</from><to>0</to><read>1</read><write>1</write><move>L</move></transition>"
+                        "<transition><from>1</from><to>3</to><read/><write/><move>L</move></transition>",
+          std::string(1000000, '1'), false, false, 1500000 },
+        // (ab)^n has no runs: TmRunner goes on and stops at q0 -[□/1,R]-> q0
+        // on a chunk boundary
+        { "(ab)^n, then 1s", "<transition><from>0</from><to>1</to><read>a</read><write>a</write><move>R</move></transition>"
+                             "<transition><from>1</from><to>0</to><read>b</read><write>b</write><move>R</move></transition>"
+                             "<transition><from>0</from><to>0</to><read/><write>1</write><move>R</move></transition>",
+          "", true, true, UINT64_MAX },
+    };
+    bool all = true;
+    for (const Check &check : checks)
+    {
+        std::string input = check.input;
+        if (check.dense)
+            for (uint64_t i = 0; i < TmRleRunner::PROBE; ++i)
+                input += "ab";
+        const std::string text = std::string("<structure><type>turing</type><automaton>"
+                                             "<state id=\"0\" name=\"q0\"><initial/></state>"
+                                             "<state id=\"1\" name=\"q1\"/><state id=\"2\" name=\"q2\"/>"
+                                             "<state id=\"3\" name=\"q3\"><final/></state>") +
+                                 check.transitions + "</automaton></structure>";
+        JffDocument doc;
+        TuringMachine machine;
+        std::string error;
+        if (!doc.Parse(text.data(), text.size(), &error) || !machine.Load(doc, &error))
+        {
+            std::fprintf(stderr, "%s: %s\n", check.name, error.c_str());
+            return 1;
+        }
+        TmRleRunner macro(machine);
+        auto begin = Clock::now();
+        int verdict = macro.Run(input.data(), input.data() + input.size(), check.limit);
+        double seconds = Seconds(begin);
+        // The same number of steps on TmRunner
+        TmRunner runner(machine);
+        int result = runner.Run(input.data(), input.data() + input.size(),
+                                check.diverges ? macro.Stats().steps : check.limit);
+        bool ok = verdict == result && macro.Stats().steps == runner.Stats().steps &&
+                  macro.State() == runner.State() && macro.Contents(0) == runner.Contents(0) &&
+                  macro.Head(0) == runner.Head(0) && macro.Stats().low[0] == runner.Stats().low[0] &&
+                  macro.Stats().high[0] == runner.Stats().high[0] && macro.Dense() == check.dense &&
+                  macro.Diverged() == check.diverges;
+        std::printf("%-22s n=%-6zu %-8s %12llu steps %10.3f ms, %s%s%s %s\n", check.name, input.size(),
+                    ResultText(verdict), (unsigned long long)macro.Stats().steps, seconds * 1e3,
+                    macro.Dense() ? "TmRunner after " : "", (std::to_string(macro.MacroSteps()) + " macro steps").c_str(),
+                    macro.Diverged() ? ", diverges" : "", ok ? "ok" : "MISMATCH");
+        all = all && ok;
+    }
+    return all ? 0 : 1;
+}
+
+// Macro steps of the run-length simulator for the statistics
+std::string MacroText(const TmRunner &)
+{
+    return "";
+}
+
+std::string MacroText(const TmRleRunner &runner)
+{
+    return std::string(runner.Dense() ? ", TmRunner after " : ", ") + std::to_string(runner.MacroSteps()) +
+           " macro steps" + (runner.Diverged() ? ", diverges (a pass over endless blank)" : "");
+}
+
+template <typename Runner>
+int RunOnce(const char *path, const char *word)
+{
+    auto begin = Clock::now();
+    JffDocument doc;
+    std::string error;
+    if (!doc.Load(path, &error))
+    {
+        std::fprintf(stderr, "%s: %s\n", path, error.c_str());
+        return 1;
+    }
+    double load = Seconds(begin);
+    begin = Clock::now();
+    TuringMachine machine;
+    if (!machine.Load(doc, &error))
+    {
+        std::fprintf(stderr, "%s: %s\n", path, error.c_str());
+        return 1;
+    }
+    double build = Seconds(begin);
+
+    Runner runner(machine);
+    begin = Clock::now();
+    int result = runner.Run(word, word + std::strlen(word));
+    double run = Seconds(begin);
+    begin = Clock::now();
+    std::vector<std::string> contents;
+    for (int t = 0; t < machine.Tapes(); ++t)
+        contents.push_back(runner.Contents(t));
+    double output = Seconds(begin);
+
+    const TmStats &stats = runner.Stats();
+    std::printf("%s, %llu steps%s\n", ResultText(result), (unsigned long long)stats.steps, MacroText(runner).c_str());
+    for (int t = 0; t < machine.Tapes(); ++t)
+        std::printf("tape %d: [%s], head at %lld, visited cells %lld..%lld\n", t + 1,
+                    Abbreviated(contents[t]).c_str(), (long long)runner.Head(t), (long long)stats.low[t],
+                    (long long)stats.high[t]);
+    std::printf("load %.3f ms, table %.3f ms (%.1f KB), run %.3f ms (%.1f M steps/s, tapes %.1f KB), output %.3f ms\n",
+                load * 1e3, build * 1e3, machine.TableBytes() / 1024.0, run * 1e3, stats.steps / 1e6 / run,
+                stats.tape_bytes / 1024.0, output * 1e3);
+    return 0;
+}
+
+int RunBatch(const char *path, const char *input, int threads, uint64_t limit, double timeout)
+{
+    TuringMachine machine;
+    if (!LoadMachine(path, machine))
+        return 1;
+    RecordReader reader;
+    std::string error;
+    if (!reader.Open(input, &error))
+    {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    // All words in one buffer: the pool takes them in any order
+    std::string text;
+    std::vector<size_t> ends;
+    std::string_view line;
+    while (reader.Next(line))
+    {
+        text += line;
+        ends.push_back(text.size());
+    }
+    std::vector<std::string_view> words;
+    for (size_t i = 0; i < ends.size(); ++i)
+    {
+        size_t from = i > 0 ? ends[i - 1] : 0;
+        words.emplace_back(text.data() + from, ends[i] - from);
+    }
+
+    WorkPool pool(threads);
+    TmBatch batch(machine, pool);
+    std::string out;
+    TmBatchStats stats = batch.Run(words, limit, timeout, [&out](const TmBatchResult *results, size_t count) {
+        out.clear();
+        for (size_t i = 0; i < count; ++i)
+        {
+            out += std::to_string(results[i].word + 1);
+            out += ' ';
+            out += "10LT"[results[i].result];
+            out += ' ';
+            out += std::to_string(results[i].steps);
+            out += '\n';
+        }
+        std::fwrite(out.data(), 1, out.size(), stdout);
+        std::fflush(stdout);
+    });
+
+    std::fprintf(stderr, "%zu words on %d thread(s): %zu accepted, %zu rejected, %zu step limit, %zu timeout\n",
+                 stats.words, pool.Threads(), stats.results[TM_ACCEPTED], stats.results[TM_REJECTED],
+                 stats.results[TM_STEP_LIMIT], stats.results[TM_TIMEOUT]);
+    std::fprintf(stderr, "%llu steps in %.3f s: %.0f words/s, %.1f M steps/s; %.1f steps per word, most %llu (line %zu)\n",
+                 (unsigned long long)stats.steps, stats.seconds, stats.words / stats.seconds,
+                 stats.steps / 1e6 / stats.seconds, stats.words ? (double)stats.steps / stats.words : 0.0,
+                 (unsigned long long)stats.max_steps, stats.max_word + 1);
+    std::fprintf(stderr, "words per thread:");
+    for (size_t count : stats.worker_words)
+        std::fprintf(stderr, " %zu", count);
+    std::fprintf(stderr, "\n");
+    return 0;
+}
+
+template <typename Runner>
+int Run(const char *path, const char *input)
+{
+    TuringMachine machine;
+    if (!LoadMachine(path, machine))
+        return 1;
+    Runner runner(machine);
+
+    if (input)
+    {
+        RecordReader reader;
+        std::string message;
+        if (!reader.Open(input, &message))
+        {
+            std::fprintf(stderr, "%s\n", message.c_str());
+            return 1;
+        }
+        std::string_view line;
+        size_t lines = 0, accepted = 0;
+        uint64_t steps = 0;
+        auto begin = Clock::now();
+        while (reader.Next(line))
+        {
+            bool ok = runner.Run(line.data(), line.data() + line.size()) == TM_ACCEPTED;
+            std::fputs(ok ? "1\n" : "0\n", stdout);
+            ++lines;
+            accepted += ok;
+            steps += runner.Stats().steps;
+        }
+        double seconds = Seconds(begin);
+        std::fprintf(stderr, "%zu lines, %zu accepted, %llu steps in %.3f s (%.1f M steps/s)\n", lines, accepted,
+                     (unsigned long long)steps, seconds, steps / 1e6 / seconds);
+        return 0;
+    }
+
+    std::cout << "Enter your input line: ";
+    std::string line;
+    std::getline(std::cin, line);
+    int result = runner.Run(line.data(), line.data() + line.size());
+    for (int t = 0; t < machine.Tapes(); ++t)
+        std::cout << "Tape " << t + 1 << ": " << Abbreviated(runner.Contents(t)) << "\n";
+    std::cout << (result == TM_ACCEPTED ? "Accepted.\n" : "Rejected.\n");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0)
+        return RunBenchmark();
+    if (argc > 3 && std::strcmp(argv[1], "--batch") == 0)
+    {
+        int threads = argc > 4 ? std::atoi(argv[4]) : 0;
+        uint64_t limit = argc > 5 ? std::strtoull(argv[5], nullptr, 10) : 0;
+        double timeout = argc > 6 ? std::atof(argv[6]) / 1e3 : 0;
+        return RunBatch(argv[2], argv[3], threads > 0 ? threads : (int)std::thread::hardware_concurrency(),
+                        limit > 0 ? limit : UINT64_MAX, timeout);
+    }
+    bool rle = argc > 1 && std::strcmp(argv[1], "--rle") == 0;
+    if (rle)
+    {
+        --argc;
+        ++argv;
+    }
+    if (argc > 3 && std::strcmp(argv[1], "--run") == 0)
+        return rle ? RunOnce<TmRleRunner>(argv[2], argv[3]) : RunOnce<TmRunner>(argv[2], argv[3]);
+
+    const char *path = argc > 1 ? argv[1] : DEFAULT_MACHINE;
+    const char *input = argc > 2 ? argv[2] : nullptr;
+    return rle ? Run<TmRleRunner>(path, input) : Run<TmRunner>(path, input);
+}
@@ -0,0 +1,445 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../common/jff.hpp"
+
+enum TM_RESULT {
+    TM_ACCEPTED = 0,        // halted in a final state
+    TM_REJECTED = 1,        // no transition in a non-final state
+    TM_STEP_LIMIT = 2,      // still running after the step limit
+    TM_TIMEOUT = 3          // still running after the time limit (TmBatch)
+};
+
+// Deterministic multi-tape Turing machine (<type>turing</type>, <tapes>N</tapes>)
+// with a dense action table.
+// Символы лент - маленькие номера: 0 - пробел (пустая метка JFLAP), затем
+// символы переходов, затем "прочий" символ для байтов входа, которых в машине
+// нет, и два служебных: FRESH - еще не посещенная ячейка (читается как
+// пробел) и GUARD - граница буфера ленты (см. TmTape). Номер символа ленты t
+// занимает свои биты ключа, строка таблицы состояния - 2^(bits·N) действий, и
+// шаг - это один индекс: строка состояния + символы под всеми головками.
+// Метка чтения "~" (JFLAP) - любой символ, запись "~" оставляет символ как
+// есть; явный переход важнее перехода с "~". Как в JFLAP, машина
+// останавливается, попав в заключительное состояние, и вход записывается на
+// первую ленту.
+class TuringMachine {
+public:
+    static constexpr int MAX_TAPES = 8;
+    static constexpr int HALT = -1;         // Action::next: no transition
+    static constexpr int EXTEND = -2;       // a head is on a GUARD cell
+    static constexpr size_t MAX_TABLE = size_t(1) << 24;
+
+    struct Action {
+        int32_t next = HALT;                // row of the next state
+        uint8_t write[MAX_TAPES] = {};
+        int8_t move[MAX_TAPES] = {};
+    };
+
+    bool Load(const JffDocument& doc, std::string* error = nullptr)
+    {
+        if (doc.Type() != "turing")
+            return Fail(error, "not a Turing machine: <type>" + std::string(doc.Type()) + "</type>");
+        if (doc.InitialState() < 0)
+            return Fail(error, "no initial state");
+        if (doc.Tapes() > MAX_TAPES)
+            return Fail(error, "more than " + std::to_string(MAX_TAPES) + " tapes");
+        m_Tapes = doc.Tapes();
+        m_States = static_cast<int>(doc.States().size());
+        m_Start = doc.InitialState();
+        m_Final.assign(m_States, 0);
+        for (int q = 0; q < m_States; ++q)
+            m_Final[q] = doc.States()[q].final;
+
+        // Alphabet: blank, the symbols of the transitions, the other bytes
+        std::fill(std::begin(m_Index), std::end(m_Index), -1);
+        m_Chars.assign(1, ' ');
+        for (const auto& t : doc.Transitions())
+            for (int tape = 1; tape <= m_Tapes; ++tape)
+                for (int kind : { JFF_READ, JFF_WRITE }) {
+                    std::string_view label = doc.Label(t, kind, tape);
+                    if (label.size() > 1)
+                        return Fail(error, "label \"" + std::string(label) + "\" is longer than one symbol");
+                    if (label.size() == 1 && label[0] != WILDCARD && m_Index[static_cast<unsigned char>(label[0])] < 0) {
+                        m_Index[static_cast<unsigned char>(label[0])] = static_cast<int>(m_Chars.size());
+                        m_Chars.push_back(label[0]);
+                    }
+                }
+        int other = static_cast<int>(m_Chars.size());
+        m_Chars.push_back('?');
+        for (int c = 0; c < 256; ++c)
+            if (m_Index[c] < 0)
+                m_Index[c] = other;
+        m_Bits = 0;
+        while ((1 << m_Bits) < Guard() + 1)
+            ++m_Bits;
+        if (static_cast<size_t>(m_Bits) * m_Tapes > 24 || (size_t(m_States) << (m_Bits * m_Tapes)) > MAX_TABLE)
+            return Fail(error, "the action table would be too large");
+        m_Width = static_cast<int>(1) << (m_Bits * m_Tapes);
+
+        m_Table.assign(static_cast<size_t>(m_States) * m_Width, Action());
+        std::vector<int8_t> exact(m_Table.size(), -1);   // explicit symbols of the transition in the slot
+        for (const auto& t : doc.Transitions()) {
+            if (m_Final[t.from])
+                continue;
+            Action action;
+            action.next = t.to * m_Width;
+            int8_t explicit_symbols = 0;
+            // Symbols each tape matches: read[tape] .. last[tape]; the blank
+            // matches FRESH too
+            int read[MAX_TAPES], last[MAX_TAPES];
+            for (int tape = 0; tape < m_Tapes; ++tape) {
+                std::string_view r = doc.Label(t, JFF_READ, tape + 1);
+                std::string_view w = doc.Label(t, JFF_WRITE, tape + 1);
+                std::string_view m = doc.Label(t, JFF_MOVE, tape + 1);
+                if (r == std::string_view(&WILDCARD, 1)) {
+                    read[tape] = 0;
+                    last[tape] = Fresh();
+                } else {
+                    read[tape] = last[tape] = SymbolIndex(r.empty() ? BLANK : r[0]);
+                    ++explicit_symbols;
+                }
+                action.write[tape] = w == std::string_view(&WILDCARD, 1) ? KEEP : SymbolIndex(w.empty() ? BLANK : w[0]);
+                if (m == "L")
+                    action.move[tape] = -1;
+                else if (m == "R")
+                    action.move[tape] = 1;
+                else if (m == "S")
+                    action.move[tape] = 0;
+                else
+                    return Fail(error, "bad move \"" + std::string(m) + "\"");
+            }
+
+            // Every symbol tuple the read labels match
+            int tuple[MAX_TAPES];
+            std::copy(read, read + m_Tapes, tuple);
+            for (;;) {
+                size_t key = static_cast<size_t>(t.from) * m_Width;
+                Action slot = action;
+                for (int tape = 0; tape < m_Tapes; ++tape) {
+                    key += static_cast<size_t>(tuple[tape]) << (m_Bits * tape);
+                    if (slot.write[tape] == KEEP)
+                        slot.write[tape] = static_cast<uint8_t>(tuple[tape] == Fresh() ? 0 : tuple[tape]);
+                }
+                if (exact[key] == explicit_symbols)
+                    return Fail(error, "nondeterministic transitions from state " +
+                                       std::string(doc.Text(doc.States()[t.from].name)));
+                if (exact[key] < explicit_symbols) {
+                    exact[key] = explicit_symbols;
+                    m_Table[key] = slot;
+                }
+                int tape = 0;
+                for (; tape < m_Tapes; ++tape) {
+                    if (tuple[tape] == 0 && last[tape] == 0) {
+                        tuple[tape] = Fresh();
+                        break;
+                    }
+                    if (tuple[tape] < last[tape]) {
+                        ++tuple[tape];
+                        break;
+                    }
+                    tuple[tape] = read[tape];
+                }
+                if (tape == m_Tapes)
+                    break;
+            }
+        }
+
+        // A GUARD under any head: the tape has to grow before the step
+        for (int q = 0; q < m_States; ++q) {
+            if (m_Final[q])
+                continue;
+            for (int k = 0; k < m_Width; ++k)
+                for (int tape = 0; tape < m_Tapes; ++tape)
+                    if ((k >> (m_Bits * tape) & ((1 << m_Bits) - 1)) == Guard())
+                        m_Table[static_cast<size_t>(q) * m_Width + k].next = EXTEND;
+        }
+        return true;
+    }
+
+    int Tapes() const { return m_Tapes; }
+    int States() const { return m_States; }
+    int Start() const { return m_Start; }
+    bool IsFinal(int state) const { return m_Final[state]; }
+
+    // Symbol numbers: 0 - blank, Symbols() - 1 - a byte the machine does not
+    // know; FRESH and GUARD follow
+    int Symbols() const { return static_cast<int>(m_Chars.size()); }
+    int Fresh() const { return Symbols(); }
+    int Guard() const { return Symbols() + 1; }
+    int SymbolIndex(char ch) const { return ch == BLANK ? 0 : m_Index[static_cast<unsigned char>(ch)]; }
+    char SymbolChar(int symbol) const { return symbol < Symbols() ? m_Chars[symbol] : ' '; }
+
+    // Bits of one tape symbol in a key; row of state q is q * Width()
+    int SymbolBits() const { return m_Bits; }
+    int Width() const { return m_Width; }
+    const Action* Table() const { return m_Table.data(); }
+    size_t TableBytes() const { return m_Table.capacity() * sizeof(Action); }
+
+private:
+    static constexpr char BLANK = ' ';
+    static constexpr char WILDCARD = '~';
+    static constexpr uint8_t KEEP = 0xff;
+
+    static bool Fail(std::string* error, const std::string& message)
+    {
+        if (error)
+            *error = message;
+        return false;
+    }
+
+    int m_Tapes = 1;
+    int m_States = 0;
+    int m_Start = 0;
+    std::vector<uint8_t> m_Final;
+    int m_Index[256] = {};
+    std::string m_Chars;
+    int m_Bits = 0;
+    int m_Width = 1;
+    std::vector<Action> m_Table;
+};
+
+// Tape unbounded in both directions: a ring buffer of 2^k cells.
+// Позиция p лежит в ячейке p & mask. Буфер держит окно из 2^k - 1 позиций
+// [left, left + 2^k - 2], оставшаяся ячейка - GUARD, и она же граница окна с
+// обеих сторон (позиции left - 1 и left + 2^k - 1 попадают в нее). Поэтому в
+// цикле шагов нет проверок границ: головка, вышедшая из окна, читает GUARD,
+// таблица дает EXTEND, и лента удваивается в сторону движения без сдвига
+// остального. Непосещенные ячейки - FRESH. Посещенные ячейки - отрезок, и
+// головка пишет в каждую, поэтому после куска шагов он ищется от прошлых
+// границ наружу до первой FRESH: цена - рост отрезка, а не размер окна, и
+// Resume() по кускам не просматривает ленту заново. Буфер служит следующему
+// запуску.
+class TmTape {
+public:
+    // Input at positions [0, count), the head at 0; `capacity` - a power of
+    // two above 2 * count
+    void Reset(const uint8_t* symbols, size_t count, size_t capacity, int fresh, int guard)
+    {
+        m_Fresh = static_cast<uint8_t>(fresh);
+        m_Guard = static_cast<uint8_t>(guard);
+        m_Cells.resize(capacity);
+        std::fill(m_Cells.begin(), m_Cells.end(), m_Fresh);
+        m_Left = -static_cast<int64_t>((capacity - 1 - count) / 2);
+        for (size_t i = 0; i < count; ++i)
+            m_Cells[i] = symbols[i];
+        m_Cells[(m_Left - 1) & Mask()] = m_Guard;
+        m_Head = 0;
+        m_Low = 0;
+        m_High = count > 0 ? static_cast<int64_t>(count) - 1 : 0;
+    }
+
+    // Doubles the buffer. If `head` is on the GUARD left of the window, the
+    // window grows to the left, otherwise to the right
+    void Extend(int64_t head)
+    {
+        size_t capacity = m_Cells.size() * 2;
+        std::vector<uint8_t> cells(capacity, m_Fresh);
+        // The old window in pieces that wrap around in neither buffer
+        int64_t last = m_Left + static_cast<int64_t>(Mask()) - 1;
+        for (int64_t p = m_Left; p <= last;) {
+            size_t from = p & Mask(), to = p & (capacity - 1);
+            size_t count = std::min({ static_cast<size_t>(last - p + 1), m_Cells.size() - from, capacity - to });
+            std::memcpy(cells.data() + to, m_Cells.data() + from, count);
+            p += static_cast<int64_t>(count);
+        }
+        if (head < m_Left)
+            m_Left -= static_cast<int64_t>(m_Cells.size());
+        m_Cells.swap(cells);
+        m_Cells[(m_Left - 1) & Mask()] = m_Guard;
+    }
+
+    // The head after a run; widens the visited span by the cells written
+    // since the last call (the head cell may still be FRESH)
+    void Finish(int64_t head)
+    {
+        m_Head = head;
+        int64_t last = m_Left + static_cast<int64_t>(Mask()) - 1;
+        while (m_Low > m_Left && m_Cells[(m_Low - 1) & Mask()] != m_Fresh)
+            --m_Low;
+        while (m_High < last && m_Cells[(m_High + 1) & Mask()] != m_Fresh)
+            ++m_High;
+        m_Low = std::min(m_Low, head);
+        m_High = std::max(m_High, head);
+    }
+
+    // Symbol at a position (blank outside the window and in FRESH cells)
+    uint8_t At(int64_t position) const
+    {
+        if (position < m_Left || position > m_Left + static_cast<int64_t>(Mask()) - 1)
+            return 0;
+        uint8_t symbol = m_Cells[position & Mask()];
+        return symbol == m_Fresh ? 0 : symbol;
+    }
+
+    uint8_t* Cells() { return m_Cells.data(); }
+    size_t Mask() const { return m_Cells.size() - 1; }
+    size_t Capacity() const { return m_Cells.size(); }
+    int64_t Head() const { return m_Head; }
+    int64_t Low() const { return m_Low; }
+    int64_t High() const { return m_High; }
+
+private:
+    std::vector<uint8_t> m_Cells;
+    int64_t m_Left = 0;         // first position of the window
+    int64_t m_Head = 0;
+    int64_t m_Low = 0;          // visited span (as of the last Finish)
+    int64_t m_High = 0;
+    uint8_t m_Fresh = 0;
+    uint8_t m_Guard = 0;
+};
+
+struct TmStats {
+    uint64_t steps = 0;
+    int64_t low[TuringMachine::MAX_TAPES] = {};    // leftmost and rightmost visited
+    int64_t high[TuringMachine::MAX_TAPES] = {};   // cells (input starts at 0)
+    size_t tape_bytes = 0;                          // buffers of all tapes
+};
+
+// Runs a TuringMachine; the tapes are reused from run to run
+class TmRunner {
+public:
+    explicit TmRunner(const TuringMachine& machine) : m_Machine(machine), m_Tapes(machine.Tapes()) {}
+
+    // Input on tape 1 from position 0, the heads at 0. Gives TM_RESULT
+    int Run(const char* first, const char* last, uint64_t limit = UINT64_MAX)
+    {
+        m_Input.resize(static_cast<size_t>(last - first));
+        for (size_t i = 0; i < m_Input.size(); ++i)
+            m_Input[i] = static_cast<uint8_t>(m_Machine.SymbolIndex(first[i]));
+        // All tapes of the same size: one mask for all of them in Loop()
+        size_t capacity = MIN_CAPACITY;
+        while (capacity < 2 * m_Input.size() + 2)
+            capacity *= 2;
+        if (m_Tapes[0].Capacity() > capacity && m_Tapes[0].Capacity() <= 16 * capacity)
+            capacity = m_Tapes[0].Capacity();
+        for (int t = 0; t < m_Machine.Tapes(); ++t)
+            m_Tapes[t].Reset(m_Input.data(), t == 0 ? m_Input.size() : 0, capacity, m_Machine.Fresh(), m_Machine.Guard());
+
+        m_State = m_Machine.Start();
+        m_Stats = TmStats();
+        return Resume(limit);
+    }
+
+    // Continues a run stopped by the step limit for `limit` more steps;
+    // Stats().steps counts the steps of all parts. Gives TM_RESULT
+    int Resume(uint64_t limit)
+    {
+        m_Halted = true;
+        uint64_t steps = 0;
+        if (!m_Machine.IsFinal(m_State)) {
+            switch (m_Machine.Tapes()) {
+            case 1: steps = Loop<1>(limit); break;
+            case 2: steps = Loop<2>(limit); break;
+            case 3: steps = Loop<3>(limit); break;
+            default: steps = Loop<0>(limit); break;
+            }
+        } else {
+            for (int t = 0; t < m_Machine.Tapes(); ++t)
+                m_Tapes[t].Finish(m_Tapes[t].Head());
+        }
+
+        m_Stats.steps += steps;
+        m_Stats.tape_bytes = 0;
+        for (int t = 0; t < m_Machine.Tapes(); ++t) {
+            m_Stats.low[t] = m_Tapes[t].Low();
+            m_Stats.high[t] = m_Tapes[t].High();
+            m_Stats.tape_bytes += m_Tapes[t].Capacity();
+        }
+        if (m_Machine.IsFinal(m_State))
+            return TM_ACCEPTED;
+        return m_Halted ? TM_REJECTED : TM_STEP_LIMIT;
+    }
+
+    const TmStats& Stats() const { return m_Stats; }
+    int State() const { return m_State; }
+    const TmTape& Tape(int tape) const { return m_Tapes[tape]; }
+    int64_t Head(int tape) const { return m_Tapes[tape].Head(); }
+
+    // Visited part of a tape without the blanks at its ends
+    std::string Contents(int tape) const
+    {
+        const TmTape& t = m_Tapes[tape];
+        int64_t low = t.Low(), high = t.High();
+        while (low <= high && t.At(low) == 0)
+            ++low;
+        while (high >= low && t.At(high) == 0)
+            --high;
+        std::string text(static_cast<size_t>(high - low + 1), ' ');
+        for (int64_t p = low; p <= high; ++p)
+            text[p - low] = m_Machine.SymbolChar(t.At(p));
+        return text;
+    }
+
+private:
+    static constexpr size_t MIN_CAPACITY = 4096;
+
+    // The step loop for TAPES tapes (0 - any number). Головки и буферы лент -
+    // локальные копии: запись байта в ленту иначе заставила бы компилятор
+    // перечитывать поля объекта на каждом шаге
+    template <int TAPES>
+    uint64_t Loop(uint64_t limit)
+    {
+        constexpr int N = TAPES > 0 ? TAPES : TuringMachine::MAX_TAPES;
+        const int tapes = TAPES > 0 ? TAPES : m_Machine.Tapes();
+        const TuringMachine::Action* table = m_Machine.Table();
+        const int bits = m_Machine.SymbolBits();
+
+        uint8_t* cells[N];
+        int64_t head[N];
+        size_t mask = m_Tapes[0].Mask();
+#pragma GCC unroll 8
+        for (int t = 0; t < tapes; ++t) {
+            cells[t] = m_Tapes[t].Cells();
+            head[t] = m_Tapes[t].Head();
+        }
+
+        int64_t row = static_cast<int64_t>(m_State) * m_Machine.Width();
+        uint64_t left = limit;
+        while (left > 0) {
+            // The symbol of tape t in bits [bits * t, bits * (t + 1)) of the key
+            size_t key = 0;
+#pragma GCC unroll 8
+            for (int t = tapes - 1; t >= 0; --t)
+                key = (key << bits) + cells[t][head[t] & mask];
+            const TuringMachine::Action& action = table[row + key];
+            if (action.next < 0) {
+                if (action.next == TuringMachine::HALT)
+                    break;
+#pragma GCC unroll 8
+                for (int t = 0; t < tapes; ++t) {
+                    m_Tapes[t].Extend(head[t]);
+                    cells[t] = m_Tapes[t].Cells();
+                }
+                mask = m_Tapes[0].Mask();
+                continue;
+            }
+            row = action.next;
+#pragma GCC unroll 8
+            for (int t = 0; t < tapes; ++t) {
+                cells[t][head[t] & mask] = action.write[t];
+                head[t] += action.move[t];
+            }
+            --left;
+        }
+        m_Halted = left > 0;
+
+#pragma GCC unroll 8
+        for (int t = 0; t < tapes; ++t)
+            m_Tapes[t].Finish(head[t]);
+        m_State = static_cast<int>(row / m_Machine.Width());
+        return limit - left;
+    }
+
+    const TuringMachine& m_Machine;
+    std::vector<TmTape> m_Tapes;
+    std::vector<uint8_t> m_Input;
+    int m_State = 0;
+    bool m_Halted = true;
+    TmStats m_Stats;
+};
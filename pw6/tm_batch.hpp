@@ -0,0 +1,120 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "../common/work_pool.hpp"
+#include "tm.hpp"
+
+struct TmBatchResult {
+    size_t word = 0;            // number of the word in the batch
+    int result = TM_REJECTED;   // TM_RESULT
+    uint64_t steps = 0;
+    double seconds = 0;
+};
+
+struct TmBatchStats {
+    size_t words = 0;
+    size_t results[4] = {};     // by TM_RESULT
+    uint64_t steps = 0;
+    uint64_t max_steps = 0;
+    size_t max_word = 0;        // the word with the most steps
+    double seconds = 0;         // wall time of the batch
+    std::vector<size_t> worker_words;   // words run by each thread
+};
+
+// Runs one TuringMachine on many words on a WorkPool.
+// У каждого потока пула свой TmRunner, и буферы его лент переиспользуются
+// от слова к слову: память выделяется только при росте ленты, а счетчики
+// потока сливаются в общие один раз на кусок слов. Каждое слово получает
+// предел шагов и предел времени: слово идет кусками по SLICE шагов (Resume),
+// и часы смотрятся между кусками. Результаты отдаются sink(results, count)
+// по мере готовности: каждый кусок слов пула - одним вызовом под мьютексом,
+// поэтому порядок - порядок завершения, а не порядок слов.
+class TmBatch {
+public:
+    static constexpr uint64_t SLICE = uint64_t(1) << 22;
+    static constexpr int GRAIN = 16;
+
+    TmBatch(const TuringMachine& machine, WorkPool& pool) : m_Pool(pool)
+    {
+        for (int t = 0; t < pool.Threads(); ++t)
+            m_Runners.push_back(std::make_unique<TmRunner>(machine));
+    }
+
+    // `limit` - steps per word, `timeout` - seconds per word (0 - none)
+    template <class Sink>
+    TmBatchStats Run(const std::vector<std::string_view>& words, uint64_t limit, double timeout, Sink sink)
+    {
+        using Clock = std::chrono::steady_clock;
+        std::vector<TmBatchStats> partial(m_Pool.Threads());
+        std::mutex output;
+        auto begin = Clock::now();
+        m_Pool.ParallelForWorker(0, static_cast<int>(words.size()), GRAIN, [&](int worker, int from, int to) {
+            TmRunner& runner = *m_Runners[worker];
+            TmBatchStats stats;
+            TmBatchResult results[GRAIN];
+            int count = 0;
+            for (int i = from; i < to; ++i) {
+                auto start = Clock::now();
+                std::string_view word = words[i];
+                int result = runner.Run(word.data(), word.data() + word.size(), std::min(limit, SLICE));
+                while (result == TM_STEP_LIMIT && runner.Stats().steps < limit) {
+                    if (timeout > 0 && std::chrono::duration<double>(Clock::now() - start).count() > timeout) {
+                        result = TM_TIMEOUT;
+                        break;
+                    }
+                    result = runner.Resume(std::min(limit - runner.Stats().steps, SLICE));
+                }
+
+                TmBatchResult& r = results[count++];
+                r.word = static_cast<size_t>(i);
+                r.result = result;
+                r.steps = runner.Stats().steps;
+                r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+                ++stats.words;
+                ++stats.results[result];
+                stats.steps += r.steps;
+                if (stats.words == 1 || r.steps > stats.max_steps) {
+                    stats.max_steps = r.steps;
+                    stats.max_word = r.word;
+                }
+                if (count == GRAIN || i + 1 == to) {
+                    std::lock_guard<std::mutex> lock(output);
+                    sink(static_cast<const TmBatchResult*>(results), static_cast<size_t>(count));
+                    count = 0;
+                }
+            }
+            Add(partial[worker], stats);
+        });
+
+        TmBatchStats total;
+        total.seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+        for (const TmBatchStats& stats : partial) {
+            Add(total, stats);
+            total.worker_words.push_back(stats.words);
+        }
+        return total;
+    }
+
+private:
+    static void Add(TmBatchStats& to, const TmBatchStats& from)
+    {
+        to.words += from.words;
+        for (int k = 0; k < 4; ++k)
+            to.results[k] += from.results[k];
+        to.steps += from.steps;
+        if (from.words > 0 && (to.words == from.words || from.max_steps > to.max_steps)) {
+            to.max_steps = from.max_steps;
+            to.max_word = from.max_word;
+        }
+    }
+
+    WorkPool& m_Pool;
+    std::vector<std::unique_ptr<TmRunner>> m_Runners;   // one per thread: its tape buffers
+};
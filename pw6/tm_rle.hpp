@@ -0,0 +1,414 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tm.hpp"
+
+// Tape as runs of equal symbols on both sides of the head.
+// Ячейки левее головки - стек отрезков (symbol, count), ближайший к головке
+// на вершине, правее - такой же стек; под стеками - бесконечный пробел,
+// поэтому пробел на пустой стек не кладется. Соседние одинаковые отрезки
+// сливаются, и повторение одного перехода по отрезку из k ячеек меняет стеки
+// за O(1): k ячеек уходят с одной стороны и k записанных приходят на другую.
+class TmRleTape {
+public:
+    static constexpr uint64_t UNBOUNDED = UINT64_MAX;
+
+    struct Run {
+        uint64_t count;
+        uint8_t symbol;
+    };
+
+    // Input at positions [0, count), the head at 0
+    void Reset(const uint8_t* symbols, size_t count)
+    {
+        m_Left.clear();
+        m_Right.clear();
+        for (size_t i = count; i-- > 1;)
+            Push(m_Right, symbols[i], 1);
+        m_Symbol = count > 0 ? symbols[0] : 0;
+        m_Head = 0;
+        m_Low = 0;
+        m_High = count > 0 ? static_cast<int64_t>(count) - 1 : 0;
+    }
+
+    uint8_t Symbol() const { return m_Symbol; }
+
+    // Cells from the head in direction `move` (+1 or -1) that hold the symbol
+    // under the head, the head cell included
+    uint64_t Span(int move) const
+    {
+        const std::vector<Run>& ahead = move > 0 ? m_Right : m_Left;
+        if (ahead.empty())
+            return m_Symbol == 0 ? UNBOUNDED : 1;
+        return ahead.back().symbol == m_Symbol ? ahead.back().count + 1 : 1;
+    }
+
+    // `count` steps that each write `symbol` and move the head by `move`;
+    // count <= Span(move) (count == 1 when move == 0)
+    void Step(uint8_t symbol, int move, uint64_t count)
+    {
+        if (move == 0) {
+            m_Symbol = symbol;
+            return;
+        }
+        std::vector<Run>& behind = move > 0 ? m_Left : m_Right;
+        std::vector<Run>& ahead = move > 0 ? m_Right : m_Left;
+        Push(behind, symbol, count);
+        Pop(ahead, count - 1);
+        if (ahead.empty()) {
+            m_Symbol = 0;
+        } else {
+            m_Symbol = ahead.back().symbol;
+            Pop(ahead, 1);
+        }
+        m_Head += move > 0 ? static_cast<int64_t>(count) : -static_cast<int64_t>(count);
+        m_Low = std::min(m_Low, m_Head);
+        m_High = std::max(m_High, m_Head);
+    }
+
+    // Non-blank part of the tape, `text(symbol)` - the character of a symbol
+    template <typename Text>
+    std::string Contents(Text text) const
+    {
+        std::string contents;
+        for (const Run& run : m_Left)
+            contents.append(run.count, text(run.symbol));
+        contents += text(m_Symbol);
+        for (size_t i = m_Right.size(); i-- > 0;)
+            contents.append(m_Right[i].count, text(m_Right[i].symbol));
+        size_t first = contents.find_first_not_of(text(0));
+        if (first == std::string::npos)
+            return std::string();
+        return contents.substr(first, contents.find_last_not_of(text(0)) - first + 1);
+    }
+
+    size_t Runs() const { return m_Left.size() + m_Right.size() + 1; }
+    size_t Bytes() const { return (m_Left.capacity() + m_Right.capacity()) * sizeof(Run); }
+    int64_t Head() const { return m_Head; }
+    int64_t Low() const { return m_Low; }
+    int64_t High() const { return m_High; }
+
+private:
+    static void Push(std::vector<Run>& runs, uint8_t symbol, uint64_t count)
+    {
+        if (!runs.empty() && runs.back().symbol == symbol)
+            runs.back().count += count;
+        else if (!runs.empty() || symbol != 0)
+            runs.push_back({ count, symbol });
+    }
+
+    // An empty stack is endless blank
+    static void Pop(std::vector<Run>& runs, uint64_t count)
+    {
+        if (count == 0 || runs.empty())
+            return;
+        runs.back().count -= count;
+        if (runs.back().count == 0)
+            runs.pop_back();
+    }
+
+    std::vector<Run> m_Left;
+    std::vector<Run> m_Right;
+    uint8_t m_Symbol = 0;       // under the head
+    int64_t m_Head = 0;
+    int64_t m_Low = 0;          // visited span
+    int64_t m_High = 0;
+};
+
+// Runs a TuringMachine on run-length tapes with macro steps.
+// Машины с унарной записью почти все шаги тратят на проходы по отрезкам
+// одинаковых символов: петлей q -[1/1,R]-> q или циклом из нескольких
+// состояний, который за проход сдвигает головку на несколько ячеек. Макрошаг
+// повторяет такой проход k раз за O(1). Проходы хранятся в кэше по ячейке
+// таблицы (состояние + символы под головками) и считаются при первом ее
+// посещении: от этой ячейки делается не больше MAX_CYCLE шагов по ленте, где
+// впереди каждой головки лежит ее же символ. Проход найден, если машина
+// вернулась в то же состояние и на каждой ленте головка либо стоит на месте
+// (символ под ней прежний), либо сдвинулась на d ячеек, ни разу не заходя
+// назад за начало, оставила позади d одинаковых символов w и не тронула
+// ячейки за новым положением (или записала в них прежний символ). Тогда
+// следующий проход видит то же самое, k - наименьшее по движущимся лентам
+// число проходов, чтение которых остается в отрезке под головкой, а лента за
+// k проходов - это k·d символов w вместо символа отрезка. Петля - проход из
+// одного шага. Если все движущиеся головки прохода уходят в бесконечный
+// пробел (или ни одна не движется), проход не кончится никогда: запуск
+// останавливается до него с TM_STEP_LIMIT и Diverged().
+// На машинах, где отрезки короткие (символы чередуются, как у распознавателя
+// (ab)^n), макрошаг делает один шаг и стоит дороже шага TmRunner. Поэтому
+// после PROBE макрошагов, если шагов на макрошаг меньше MIN_GAIN, запуск
+// начинается заново на TmRunner (Dense()) кусками по шагам; между кусками
+// проверяется, не стоит ли машина перед бесконечным проходом, и тогда запуск
+// кончается с Diverged() на границе куска. Шагов за запуск не больше
+// MAX_STEPS, так что позиции головок и длины отрезков не переполняются. В
+// остальном число шагов, состояние, ленты и посещенные ячейки те же, что у
+// TmRunner.
+class TmRleRunner {
+public:
+    static constexpr uint64_t MAX_STEPS = uint64_t(1) << 62;
+    static constexpr int MAX_CYCLE = 16;
+    static constexpr uint64_t PROBE = uint64_t(1) << 12;
+    static constexpr uint64_t MIN_GAIN = 4;
+
+    explicit TmRleRunner(const TuringMachine& machine)
+        : m_Machine(machine), m_Tapes(machine.Tapes()), m_Dense(machine),
+          m_Slot(static_cast<size_t>(machine.States()) * machine.Width(), UNKNOWN)
+    {
+    }
+
+    // Input on tape 1 from position 0, the heads at 0. Gives TM_RESULT
+    int Run(const char* first, const char* last, uint64_t limit = UINT64_MAX)
+    {
+        m_Input.resize(static_cast<size_t>(last - first));
+        for (size_t i = 0; i < m_Input.size(); ++i)
+            m_Input[i] = static_cast<uint8_t>(m_Machine.SymbolIndex(first[i]));
+        for (int t = 0; t < m_Machine.Tapes(); ++t)
+            m_Tapes[t].Reset(m_Input.data(), t == 0 ? m_Input.size() : 0);
+
+        const TuringMachine::Action* table = m_Machine.Table();
+        const int tapes = m_Machine.Tapes();
+        const int bits = m_Machine.SymbolBits();
+        int64_t row = static_cast<int64_t>(m_Machine.Start()) * m_Machine.Width();
+        uint64_t left = std::min(limit, MAX_STEPS);
+        const uint64_t steps = left;
+        m_MacroSteps = 0;
+        m_Diverged = false;
+        m_UseDense = false;
+        while (left > 0) {
+            if (m_MacroSteps == PROBE && steps - left < MIN_GAIN * PROBE)
+                return RunDense(first, last, steps);
+            size_t key = 0;
+            for (int t = tapes - 1; t >= 0; --t)
+                key = (key << bits) + m_Tapes[t].Symbol();
+            const TuringMachine::Action& action = table[row + key];
+            if (action.next < 0)
+                break;
+            int32_t slot = m_Slot[row + key];
+            if (slot == UNKNOWN)
+                slot = m_Slot[row + key] = Trace(row, key);
+            uint64_t count = 1;
+            if (slot == LOOP) {
+                uint64_t span = TmRleTape::UNBOUNDED;
+                for (int t = 0; t < tapes; ++t)
+                    if (action.move[t] != 0)
+                        span = std::min(span, m_Tapes[t].Span(action.move[t]));
+                if (span == TmRleTape::UNBOUNDED) {
+                    m_Diverged = true;
+                    break;
+                }
+                count = std::min(span, left);
+            } else if (slot >= 0) {
+                const Cycle& cycle = m_Cycles[slot];
+                uint64_t passes = left / cycle.steps;
+                bool endless = true;
+                for (int t = 0; t < tapes; ++t) {
+                    if (cycle.shift[t] == 0)
+                        continue;
+                    uint64_t span = m_Tapes[t].Span(cycle.shift[t]);
+                    if (span == TmRleTape::UNBOUNDED)
+                        continue;
+                    endless = false;
+                    uint64_t reach = static_cast<uint64_t>(cycle.reach[t]);
+                    passes = span > reach ? std::min(passes, (span - 1 - reach) / std::abs(cycle.shift[t]) + 1) : 0;
+                }
+                if (endless) {
+                    m_Diverged = true;
+                    break;
+                }
+                if (passes > 0) {
+                    for (int t = 0; t < tapes; ++t) {
+                        int shift = cycle.shift[t];
+                        if (shift == 0)
+                            continue;
+                        // The cells read past the new head are in a finite
+                        // run, hence already in the visited span
+                        m_Tapes[t].Step(cycle.write[t], shift, passes * static_cast<uint64_t>(std::abs(shift)));
+                    }
+                    left -= passes * cycle.steps;
+                    ++m_MacroSteps;
+                    continue;
+                }
+            }
+            for (int t = 0; t < tapes; ++t)
+                m_Tapes[t].Step(action.write[t], action.move[t], count);
+            row = action.next;
+            left -= count;
+            ++m_MacroSteps;
+        }
+        m_Halted = left > 0 && !m_Diverged;
+        m_State = static_cast<int>(row / m_Machine.Width());
+
+        m_Stats = TmStats();
+        m_Stats.steps = steps - left;
+        for (int t = 0; t < tapes; ++t) {
+            m_Stats.low[t] = m_Tapes[t].Low();
+            m_Stats.high[t] = m_Tapes[t].High();
+            m_Stats.tape_bytes += m_Tapes[t].Bytes();
+        }
+        if (m_Machine.IsFinal(m_State))
+            return TM_ACCEPTED;
+        return m_Halted ? TM_REJECTED : TM_STEP_LIMIT;
+    }
+
+    const TmStats& Stats() const { return m_UseDense ? m_Dense.Stats() : m_Stats; }
+    // Macro steps of the last run (of its probe if it went on with TmRunner)
+    uint64_t MacroSteps() const { return m_MacroSteps; }
+    // The last run stopped before a pass that never ends
+    bool Diverged() const { return m_Diverged; }
+    // The last run went on with TmRunner: the macro steps gave too little
+    bool Dense() const { return m_UseDense; }
+    int State() const { return m_UseDense ? m_Dense.State() : m_State; }
+    int64_t Head(int tape) const { return m_UseDense ? m_Dense.Head(tape) : m_Tapes[tape].Head(); }
+
+    // Tape without the blanks at its ends
+    std::string Contents(int tape) const
+    {
+        if (m_UseDense)
+            return m_Dense.Contents(tape);
+        return m_Tapes[tape].Contents([this](uint8_t symbol) { return m_Machine.SymbolChar(symbol); });
+    }
+
+private:
+    static constexpr int32_t UNKNOWN = -2;      // m_Slot: not looked at yet
+    static constexpr int32_t NONE = -1;         // m_Slot: no pass from the slot
+    static constexpr int32_t LOOP = -3;         // m_Slot: the action itself is a pass
+    static constexpr uint64_t MIN_CHUNK = uint64_t(1) << 20;
+
+    // Net effect of one pass from a slot back to its state
+    struct Cycle {
+        uint8_t steps;
+        int8_t shift[TuringMachine::MAX_TAPES];    // cells the head moves by, 0 - stands
+        int8_t reach[TuringMachine::MAX_TAPES];    // farthest cell read, along the shift
+        uint8_t write[TuringMachine::MAX_TAPES];   // symbol left behind
+    };
+
+    // Steps from the slot on a tape where each head has its symbol ahead;
+    // the cells it wrote are in a window of MAX_CYCLE cells to either side
+    __attribute__((noinline)) int32_t Trace(int64_t row, size_t key)
+    {
+        constexpr int SIDE = MAX_CYCLE;
+        constexpr uint8_t UNTOUCHED = 0xff;
+        const TuringMachine::Action* table = m_Machine.Table();
+        const int tapes = m_Machine.Tapes();
+        const int bits = m_Machine.SymbolBits();
+        uint8_t symbol[TuringMachine::MAX_TAPES];
+        uint8_t cells[TuringMachine::MAX_TAPES][2 * SIDE + 1];
+        int position[TuringMachine::MAX_TAPES] = {};
+        int low[TuringMachine::MAX_TAPES] = {};     // cells read
+        int high[TuringMachine::MAX_TAPES] = {};
+        for (int t = 0; t < tapes; ++t) {
+            symbol[t] = static_cast<uint8_t>(key >> (bits * t) & ((1 << bits) - 1));
+            std::fill(std::begin(cells[t]), std::end(cells[t]), UNTOUCHED);
+        }
+
+        int64_t state = row;
+        for (int steps = 1; steps <= MAX_CYCLE; ++steps) {
+            size_t k = 0;
+            for (int t = tapes - 1; t >= 0; --t) {
+                uint8_t cell = cells[t][SIDE + position[t]];
+                k = (k << bits) + (cell == UNTOUCHED ? symbol[t] : cell);
+            }
+            const TuringMachine::Action& action = table[state + k];
+            if (action.next < 0)
+                return NONE;
+            for (int t = 0; t < tapes; ++t) {
+                low[t] = std::min(low[t], position[t]);
+                high[t] = std::max(high[t], position[t]);
+                cells[t][SIDE + position[t]] = action.write[t];
+                position[t] += action.move[t];
+            }
+            state = action.next;
+            if (state != row)
+                continue;
+
+            Cycle cycle = {};
+            cycle.steps = static_cast<uint8_t>(steps);
+            bool pass = true;
+            for (int t = 0; t < tapes && pass; ++t) {
+                int shift = position[t];
+                const uint8_t* cell = cells[t] + SIDE;
+                if (shift == 0) {
+                    pass = low[t] == 0 && high[t] == 0 && cell[0] == symbol[t];
+                    continue;
+                }
+                int move = shift > 0 ? 1 : -1;
+                pass = move > 0 ? low[t] >= 0 : high[t] <= 0;
+                for (int i = 0; i < std::abs(shift) && pass; ++i)
+                    pass = cell[i * move] == cell[0];
+                for (int i = std::abs(shift); i <= SIDE && pass; ++i)
+                    pass = cell[i * move] == UNTOUCHED || cell[i * move] == symbol[t];
+                cycle.shift[t] = static_cast<int8_t>(shift);
+                cycle.reach[t] = static_cast<int8_t>(move > 0 ? high[t] : -low[t]);
+                cycle.write[t] = cell[0];
+            }
+            if (pass && steps == 1)
+                return LOOP;
+            if (pass) {
+                m_Cycles.push_back(cycle);
+                return static_cast<int32_t>(m_Cycles.size() - 1);
+            }
+        }
+        return NONE;
+    }
+
+    // The run from the start on TmRunner in growing chunks
+    int RunDense(const char* first, const char* last, uint64_t limit)
+    {
+        m_UseDense = true;
+        uint64_t chunk = MIN_CHUNK;
+        int result = m_Dense.Run(first, last, std::min(chunk, limit));
+        while (result == TM_STEP_LIMIT && m_Dense.Stats().steps < limit) {
+            if (Endless()) {
+                m_Diverged = true;
+                break;
+            }
+            chunk *= 2;
+            result = m_Dense.Resume(std::min(chunk, limit - m_Dense.Stats().steps));
+        }
+        return result;
+    }
+
+    // TmRunner stands before a pass that never ends: the heads that move
+    // have only blank ahead
+    bool Endless()
+    {
+        const int tapes = m_Machine.Tapes();
+        const int bits = m_Machine.SymbolBits();
+        int64_t row = static_cast<int64_t>(m_Dense.State()) * m_Machine.Width();
+        size_t key = 0;
+        for (int t = tapes - 1; t >= 0; --t)
+            key = (key << bits) + m_Dense.Tape(t).At(m_Dense.Tape(t).Head());
+        int32_t& slot = m_Slot[row + key];
+        if (slot == UNKNOWN)
+            slot = Trace(row, key);
+        if (slot == NONE)
+            return false;
+        for (int t = 0; t < tapes; ++t) {
+            int move = slot == LOOP ? m_Machine.Table()[row + key].move[t] : m_Cycles[slot].shift[t];
+            if (move == 0)
+                continue;
+            move = move > 0 ? 1 : -1;
+            const TmTape& tape = m_Dense.Tape(t);
+            for (int64_t p = tape.Head(); p != (move > 0 ? tape.High() + 1 : tape.Low() - 1); p += move)
+                if (tape.At(p) != 0)
+                    return false;
+        }
+        return true;
+    }
+
+    const TuringMachine& m_Machine;
+    std::vector<TmRleTape> m_Tapes;
+    TmRunner m_Dense;
+    std::vector<int32_t> m_Slot;        // index in m_Cycles, UNKNOWN or NONE
+    std::vector<Cycle> m_Cycles;
+    std::vector<uint8_t> m_Input;
+    int m_State = 0;
+    bool m_Halted = true;
+    bool m_Diverged = false;
+    bool m_UseDense = false;
+    uint64_t m_MacroSteps = 0;
+    TmStats m_Stats;
+};